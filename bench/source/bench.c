@@ -0,0 +1,576 @@
+#ifndef _WIN32
+// getrusage is POSIX, not C11
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include "monkey.h"
+#include "monkey/ast.h"
+#include "monkey/compiler.h"
+#include "monkey/environment.h"
+#include "monkey/evaluator.h"
+#include "monkey/lexer.h"
+#include "monkey/macros.h"
+#include "monkey/object.h"
+#include "monkey/optimizer.h"
+#include "monkey/parser.h"
+#include "monkey/stream.h"
+#include "monkey/string.h"
+#include "monkey/token.h"
+#include "monkey/vm.h"
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#ifdef _WIN32
+#include <Windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+// ---- Allocation counting ----
+
+MONKEY_FILE_LOCAL uint64_t allocationCount = 0;
+
+#ifdef MONKEY_BENCH_COUNT_ALLOCATIONS
+// The linker redirects the interpreter's calls to these (see -Wl,--wrap in CMakeLists.txt).
+// NOLINTBEGIN(bugprone-reserved-identifier,cert-dcl37-c,cert-dcl51-cpp)
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+void* __wrap_malloc(size_t size);
+void* __wrap_calloc(size_t count, size_t size);
+void* __wrap_realloc(void* ptr, size_t size);
+
+void* __wrap_malloc(size_t size) {
+	++allocationCount;
+	return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+	++allocationCount;
+	return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size) {
+	++allocationCount;
+	return __real_realloc(ptr, size);
+}
+// NOLINTEND(bugprone-reserved-identifier,cert-dcl37-c,cert-dcl51-cpp)
+#endif
+
+// ---- Measurements ----
+
+MONKEY_FILE_LOCAL uint64_t nowNanoseconds(void) {
+	struct timespec ts;
+	(void)timespec_get(&ts, TIME_UTC);
+	return (uint64_t)ts.tv_sec * UINT64_C(1000000000) + (uint64_t)ts.tv_nsec;
+}
+
+MONKEY_FILE_LOCAL uint64_t peakResidentKibibytes(void) {
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if (!K32GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof counters)) {
+		return 0;
+	}
+	return (uint64_t)counters.PeakWorkingSetSize / 1024;
+#else
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0) {
+		return 0;
+	}
+#ifdef __APPLE__
+	return (uint64_t)usage.ru_maxrss / 1024;
+#else
+	return (uint64_t)usage.ru_maxrss;
+#endif
+#endif
+}
+
+// ---- Workloads ----
+
+/**
+ * @brief Benchmark is one workload. setup and teardown are not timed. run does one iteration and
+ * returns how many operations (tokens, nodes, programs) it performed.
+ */
+typedef struct {
+	const char* name;
+	const char* unit;
+	void* (*setup)(void);
+	uint64_t (*run)(void* context);
+	void (*teardown)(void* context);
+} Benchmark;
+
+#define LEX_REPEAT 200
+#define LET_CHAIN_LENGTH 1000
+
+MONKEY_FILE_LOCAL const char LEX_SNIPPET[] =
+		"let fib = fn(x) { if (x < 2) { return x; } fib(x - 1) + fib(x - 2) };\n"
+		"let result = !(fib(10) == 55) != false;\n"
+		"let adder = fn(a, b) { a * b / 2 - a + b > 7 };\n";
+
+// long identifiers and numbers and deep indentation, where the lexer scans runs of characters
+MONKEY_FILE_LOCAL const char WIDE_LEX_SNIPPET[] =
+		"let accumulated_interest_for_the_current_billing_period = fn(principal_amount) {\n"
+		"\t\t\t\t\t\t\t\t\t\t\t\tprincipal_amount * 1234567890123456789 / 100000000000000000\n"
+		"                                                                };\n";
+
+MONKEY_FILE_LOCAL const char FIB_SOURCE[] =
+		"let fib = fn(x) { if (x < 2) { return x; } fib(x - 1) + fib(x - 2) }; fib(20);";
+
+MONKEY_FILE_LOCAL const char CLOSURE_SOURCE[] =
+		"let compose = fn(f, g) { fn(x) { g(f(x)) } };\n"
+		"let adder = fn(a) { fn(b) { a + b } };\n"
+		"let repeat = fn(f, n, x) { if (n == 0) { return x; } repeat(f, n - 1, f(x)) };\n"
+		"let step = compose(adder(1), adder(2));\n"
+		"repeat(fn(x) { step(x) }, 500, 0);";
+
+// constant subexpressions in a hot function, for comparing with and without OptimizeProgram
+MONKEY_FILE_LOCAL const char CONSTANTS_SOURCE[] =
+		"let millis = fn(hours) { hours * 60 * 60 * 1000 + 2 * 60 * 1000 };\n"
+		"let loop = fn(n, total) {\n"
+		"  if (n == 0) { return total; }\n"
+		"  if (!false) { loop(n - 1, total + millis(n) / (1000 * 1000)) } else { -1 }\n"
+		"};\n"
+		"loop(500, 0);";
+
+MONKEY_FILE_LOCAL char* repeatSource(const char* snippet, size_t count) {
+	size_t length = strlen(snippet);
+	char* result = malloc(length * count + 1);
+	for (size_t i = 0; i < count; ++i) {
+		memcpy(result + i * length, snippet, length);
+	}
+	result[length * count] = '\0';
+	return result;
+}
+
+/**
+ * @brief Spells index in base 26 with letters, since identifiers cannot contain digits. The prefix
+ * keeps the names clear of keywords.
+ */
+MONKEY_FILE_LOCAL void letterName(size_t index, char out[static 8]) {
+	size_t length = 0;
+	out[length++] = 'v';
+	do {
+		out[length++] = (char)('a' + index % 26);
+		index /= 26;
+	} while (index > 0 && length < 7);
+	out[length] = '\0';
+}
+
+MONKEY_FILE_LOCAL char* letChainSource(void) {
+	MonkeyStringBuffer lines = BUFFER_INIT;
+	char previous[8];
+	char current[8];
+	letterName(0, previous);
+	BUFFER_PUSH(&lines, MonkeyAsprintf("let %s = 0;", previous));
+	for (size_t i = 1; i < LET_CHAIN_LENGTH; ++i) {
+		letterName(i, current);
+		BUFFER_PUSH(&lines, MonkeyAsprintf("let %s = %s + 1;", current, previous));
+		memcpy(previous, current, sizeof current);
+	}
+	BUFFER_PUSH(&lines, MonkeyAsprintf("%s;", previous));
+	char* result = MonkeyStringJoin((MonkeyStringSpan)BUFFER_AS_SPAN(lines));
+	for (size_t i = 0; i < lines.length; ++i) {
+		free(lines.data[i]);
+	}
+	BUFFER_FREE(lines);
+	return result;
+}
+
+typedef struct {
+	Monkey* monkey;
+	char* source;
+	Lexer* lexer;
+	Parser* parser;
+	Program* program;
+	Compiler* compiler;
+	VM* vm;
+} Workload;
+
+MONKEY_FILE_LOCAL Workload* createWorkload(char* source) {
+	Workload* workload = calloc(1, sizeof(Workload));
+	workload->monkey = CreateMonkey();
+	workload->source = source;
+	return workload;
+}
+
+MONKEY_FILE_LOCAL Workload* createParsedWorkload(char* source) {
+	Workload* workload = createWorkload(source);
+	workload->lexer = CreateLexer(workload->monkey, workload->source);
+	workload->parser = CreateParser(workload->lexer);
+	workload->program = ParseProgram(workload->parser);
+	if (ParserErrors(workload->parser).length > 0) {
+		(void)fprintf(stderr, "benchmark program failed to parse: %s\n",
+				ParserErrors(workload->parser).data[0]);
+		exit(EXIT_FAILURE);
+	}
+	return workload;
+}
+
+MONKEY_FILE_LOCAL void destroyWorkload(void* context) {
+	Workload* workload = context;
+	if (workload->vm != NULL) {
+		DestroyVM(workload->vm);
+		DestroyCompiler(workload->compiler);
+	}
+	if (workload->program != NULL) {
+		DestroyProgram(workload->program);
+		DestroyParser(workload->parser);
+		DestroyLexer(workload->lexer);
+	}
+	DestroyMonkey(workload->monkey);
+	free(workload->source);
+	free(workload);
+}
+
+MONKEY_FILE_LOCAL void* setupLexer(void) {
+	return createWorkload(repeatSource(LEX_SNIPPET, LEX_REPEAT));
+}
+
+MONKEY_FILE_LOCAL void* setupWideLexer(void) {
+	return createWorkload(repeatSource(WIDE_LEX_SNIPPET, LEX_REPEAT));
+}
+
+MONKEY_FILE_LOCAL uint64_t countTokens(Lexer* lexer) {
+	uint64_t tokens = 0;
+	while (true) {
+		Token token = LexerNextToken(lexer);
+		++tokens;
+		bool done = token.type == TOKEN_TYPE_END_OF_FILE;
+		DestroyToken(&token);
+		if (done) {
+			break;
+		}
+	}
+	return tokens;
+}
+
+MONKEY_FILE_LOCAL uint64_t runLexer(void* context) {
+	Workload* workload = context;
+	Lexer* lexer = CreateLexer(workload->monkey, workload->source);
+	uint64_t tokens = countTokens(lexer);
+	DestroyLexer(lexer);
+	return tokens;
+}
+
+MONKEY_FILE_LOCAL uint64_t runStreamLexer(void* context) {
+	Workload* workload = context;
+	Stream* stream = StreamFromText(workload->source, strlen(workload->source));
+	Lexer* lexer = CreateStreamLexer(workload->monkey, stream, LEXER_CHUNK_SIZE);
+	uint64_t tokens = countTokens(lexer);
+	DestroyLexer(lexer);
+	CloseStream(stream);
+	return tokens;
+}
+
+MONKEY_FILE_LOCAL uint64_t countStatement(const Statement* statement);
+
+MONKEY_FILE_LOCAL uint64_t countExpression(const Expression* expression) {
+	if (expression == NULL) {
+		return 0;
+	}
+	switch (expression->type) {
+		case EXPRESSION_TYPE_IDENTIFIER:
+		case EXPRESSION_TYPE_INTEGER_LITERAL:
+		case EXPRESSION_TYPE_BOOLEAN_LITERAL:
+			return 1;
+		case EXPRESSION_TYPE_PREFIX:
+			return 1 + countExpression(((const PrefixExpression*)expression)->right);
+		case EXPRESSION_TYPE_INFIX: {
+			const InfixExpression* infix = (const InfixExpression*)expression;
+			return 1 + countExpression(infix->left) + countExpression(infix->right);
+		}
+		case EXPRESSION_TYPE_IF: {
+			const IfExpression* exp = (const IfExpression*)expression;
+			uint64_t count = 1 + countExpression(exp->condition) +
+					countStatement(&exp->consequence->base);
+			if (exp->alternative != NULL) {
+				count += countStatement(&exp->alternative->base);
+			}
+			return count;
+		}
+		case EXPRESSION_TYPE_FUNCTION_LITERAL: {
+			const FunctionLiteral* exp = (const FunctionLiteral*)expression;
+			return 1 + exp->parameters.length + countStatement(&exp->body->base);
+		}
+		case EXPRESSION_TYPE_CALL: {
+			const CallExpression* exp = (const CallExpression*)expression;
+			uint64_t count = 1 + countExpression(exp->function);
+			for (size_t i = 0; i < exp->arguments.length; ++i) {
+				count += countExpression(exp->arguments.begin[i]);
+			}
+			return count;
+		}
+	}
+	return 1;
+}
+
+MONKEY_FILE_LOCAL uint64_t countStatement(const Statement* statement) {
+	switch (statement->type) {
+		case STATEMENT_TYPE_LET: {
+			const LetStatement* let = (const LetStatement*)statement;
+			return 2 + countExpression(let->value);
+		}
+		case STATEMENT_TYPE_RETURN:
+			return 1 + countExpression(((const ReturnStatement*)statement)->returnValue);
+		case STATEMENT_TYPE_EXPRESSION:
+			return 1 + countExpression(((const ExpressionStatement*)statement)->expression);
+		case STATEMENT_TYPE_BLOCK: {
+			const BlockStatement* block = (const BlockStatement*)statement;
+			uint64_t count = 1;
+			for (size_t i = 0; i < block->statements.length; ++i) {
+				count += countStatement(block->statements.begin[i]);
+			}
+			return count;
+		}
+	}
+	return 1;
+}
+
+MONKEY_FILE_LOCAL uint64_t runParser(void* context) {
+	Workload* workload = context;
+	Lexer* lexer = CreateLexer(workload->monkey, workload->source);
+	Parser* parser = CreateParser(lexer);
+	Program* program = ParseProgram(parser);
+	uint64_t nodes = 1;
+	for (size_t i = 0; i < program->statements.length; ++i) {
+		nodes += countStatement(program->statements.begin[i]);
+	}
+	DestroyProgram(program);
+	DestroyParser(parser);
+	DestroyLexer(lexer);
+	return nodes;
+}
+
+MONKEY_FILE_LOCAL void* setupFib(void) {
+	return createParsedWorkload(MonkeyStrdup(FIB_SOURCE));
+}
+
+MONKEY_FILE_LOCAL void* setupClosures(void) {
+	return createParsedWorkload(MonkeyStrdup(CLOSURE_SOURCE));
+}
+
+MONKEY_FILE_LOCAL void* setupLetChain(void) {
+	return createParsedWorkload(letChainSource());
+}
+
+MONKEY_FILE_LOCAL void* setupConstants(void) {
+	return createParsedWorkload(MonkeyStrdup(CONSTANTS_SOURCE));
+}
+
+MONKEY_FILE_LOCAL void* setupOptimizedConstants(void) {
+	Workload* workload = createParsedWorkload(MonkeyStrdup(CONSTANTS_SOURCE));
+	OptimizeProgram(workload->program);
+	return workload;
+}
+
+MONKEY_FILE_LOCAL uint64_t runEval(void* context) {
+	Workload* workload = context;
+	Environment* env = CreateEnvironment(workload->monkey, NULL);
+	Object* result = Eval(workload->monkey, env, &workload->program->base);
+	if (result != NULL && ObjectTypeOf(result) == OBJECT_TYPE_ERROR) {
+		(void)fprintf(stderr, "benchmark program failed: %s\n", ((ErrorObject*)result)->message);
+		exit(EXIT_FAILURE);
+	}
+	DestroyEnvironment(env);
+	return 1;
+}
+
+MONKEY_FILE_LOCAL void* setupCompiledFib(void) {
+	Workload* workload = createParsedWorkload(MonkeyStrdup(FIB_SOURCE));
+	workload->compiler = CreateCompiler(workload->monkey);
+	if (!Compile(workload->compiler, workload->program)) {
+		(void)fprintf(stderr, "benchmark program failed to compile: %s\n",
+				CompilerErrors(workload->compiler).data[0]);
+		exit(EXIT_FAILURE);
+	}
+	workload->vm = CreateVM(workload->monkey);
+	return workload;
+}
+
+MONKEY_FILE_LOCAL uint64_t runVM(void* context) {
+	Workload* workload = context;
+	Object* result = Run(workload->vm, CompilerBytecode(workload->compiler));
+	if (result != NULL && ObjectTypeOf(result) == OBJECT_TYPE_ERROR) {
+		(void)fprintf(stderr, "benchmark program failed: %s\n", ((ErrorObject*)result)->message);
+		exit(EXIT_FAILURE);
+	}
+	return 1;
+}
+
+MONKEY_FILE_LOCAL const Benchmark BENCHMARKS[] = {
+		{"lexer", "token", setupLexer, runLexer, destroyWorkload},
+		{"lexer_wide", "token", setupWideLexer, runLexer, destroyWorkload},
+		{"lexer_stream", "token", setupLexer, runStreamLexer, destroyWorkload},
+		{"parser", "node", setupLexer, runParser, destroyWorkload},
+		{"eval_fib", "program", setupFib, runEval, destroyWorkload},
+		{"eval_closures", "program", setupClosures, runEval, destroyWorkload},
+		{"eval_let_chain", "program", setupLetChain, runEval, destroyWorkload},
+		{"eval_constants", "program", setupConstants, runEval, destroyWorkload},
+		{"eval_constants_optimized", "program", setupOptimizedConstants, runEval, destroyWorkload},
+		{"vm_fib", "program", setupCompiledFib, runVM, destroyWorkload},
+};
+
+// ---- Driver ----
+
+typedef struct {
+	const char* name;
+	const char* unit;
+	uint64_t iterations;
+	uint64_t operations;
+	double nsPerOp;
+	double allocationsPerOp;
+	uint64_t peakRssKib;
+} Result;
+
+#define DEFAULT_MIN_TIME_NS UINT64_C(500000000)
+#define MAX_ITERATIONS UINT64_C(1000000000)
+
+/**
+ * @brief Runs a benchmark for a fixed number of iterations, or when iterations is 0, doubles the
+ * number of iterations until one batch takes at least minTimeNs. Only the last batch is reported.
+ */
+MONKEY_FILE_LOCAL Result measure(
+		const Benchmark* benchmark, uint64_t iterations, uint64_t minTimeNs) {
+	void* context = benchmark->setup();
+	// one untimed iteration warms up caches and the heap
+	(void)benchmark->run(context);
+
+	uint64_t batch = iterations > 0 ? iterations : 1;
+	Result result = {benchmark->name, benchmark->unit, 0, 0, 0, 0, 0};
+	while (true) {
+		uint64_t operations = 0;
+		uint64_t allocationsBefore = allocationCount;
+		uint64_t start = nowNanoseconds();
+		for (uint64_t i = 0; i < batch; ++i) {
+			operations += benchmark->run(context);
+		}
+		uint64_t elapsed = nowNanoseconds() - start;
+		uint64_t allocations = allocationCount - allocationsBefore;
+
+		if (iterations > 0 || elapsed >= minTimeNs || batch >= MAX_ITERATIONS) {
+			result.iterations = batch;
+			result.operations = operations;
+			result.nsPerOp = (double)elapsed / (double)operations;
+			result.allocationsPerOp = (double)allocations / (double)operations;
+			break;
+		}
+		batch *= 2;
+	}
+
+	benchmark->teardown(context);
+	result.peakRssKib = peakResidentKibibytes();
+	return result;
+}
+
+MONKEY_FILE_LOCAL void printUsage(const char* program) {
+	(void)fprintf(stderr,
+			"Usage: %s [--json] [--iterations=N] [--min-time-ms=N] [benchmark...]\n"
+			"Benchmarks:",
+			program);
+	for (size_t i = 0; i < sizeof BENCHMARKS / sizeof BENCHMARKS[0]; ++i) {
+		(void)fprintf(stderr, " %s", BENCHMARKS[i].name);
+	}
+	(void)fprintf(stderr, "\n");
+}
+
+/**
+ * @brief Parses an option of the form --name=N, returning false if arg is not that option or N is
+ * not a number.
+ */
+MONKEY_FILE_LOCAL bool parseCountOption(const char* arg, const char* name, uint64_t* out) {
+	size_t nameLength = strlen(name);
+	if (strncmp(arg, name, nameLength) != 0 || arg[nameLength] != '=') {
+		return false;
+	}
+	const char* text = arg + nameLength + 1;
+	char* end = NULL;
+	unsigned long long value = strtoull(text, &end, 10);
+	if (end == text || *end != '\0') {
+		return false;
+	}
+	*out = (uint64_t)value;
+	return true;
+}
+
+int main(int argc, const char* argv[]) {
+	bool json = false;
+	uint64_t iterations = 0;
+	uint64_t minTimeNs = DEFAULT_MIN_TIME_NS;
+	bool selected[sizeof BENCHMARKS / sizeof BENCHMARKS[0]] = {false};
+	bool anySelected = false;
+	for (int i = 1; i < argc; ++i) {
+		uint64_t minTimeMs = 0;
+		if (strcmp(argv[i], "--json") == 0) {
+			json = true;
+		} else if (parseCountOption(argv[i], "--iterations", &iterations)) {
+			// nothing else to do
+		} else if (parseCountOption(argv[i], "--min-time-ms", &minTimeMs)) {
+			minTimeNs = minTimeMs * UINT64_C(1000000);
+		} else {
+			bool found = false;
+			for (size_t j = 0; j < sizeof BENCHMARKS / sizeof BENCHMARKS[0]; ++j) {
+				if (strcmp(argv[i], BENCHMARKS[j].name) == 0) {
+					selected[j] = true;
+					found = true;
+				}
+			}
+			if (!found) {
+				printUsage(argv[0]);
+				return EXIT_FAILURE;
+			}
+			anySelected = true;
+		}
+	}
+
+#ifdef MONKEY_BENCH_COUNT_ALLOCATIONS
+	const bool countsAllocations = true;
+#else
+	const bool countsAllocations = false;
+#endif
+
+	if (json) {
+		printf("[");
+	} else {
+		printf("%-24s %12s %14s %14s %14s\n", "benchmark", "operations", "ns/op", "allocs/op",
+				"peak RSS KiB");
+	}
+	bool first = true;
+	for (size_t i = 0; i < sizeof BENCHMARKS / sizeof BENCHMARKS[0]; ++i) {
+		if (anySelected && !selected[i]) {
+			continue;
+		}
+		Result result = measure(&BENCHMARKS[i], iterations, minTimeNs);
+		if (json) {
+			printf("%s\n  {\"name\": \"%s\", \"unit\": \"%s\", \"iterations\": %" PRIu64
+				   ", \"operations\": %" PRIu64 ", \"ns_per_op\": %.3f, ",
+					first ? "" : ",", result.name, result.unit, result.iterations,
+					result.operations, result.nsPerOp);
+			if (countsAllocations) {
+				printf("\"allocs_per_op\": %.3f, ", result.allocationsPerOp);
+			} else {
+				printf("\"allocs_per_op\": null, ");
+			}
+			printf("\"peak_rss_kib\": %" PRIu64 "}", result.peakRssKib);
+		} else {
+			char allocations[32] = "n/a";
+			if (countsAllocations) {
+				(void)snprintf(allocations, sizeof allocations, "%.3f", result.allocationsPerOp);
+			}
+			printf("%-24s %12" PRIu64 " %14.3f %14s %14" PRIu64 "\n", result.name,
+					result.operations, result.nsPerOp, allocations, result.peakRssKib);
+		}
+		(void)fflush(stdout);
+		first = false;
+	}
+	if (json) {
+		printf("\n]\n");
+	}
+	return EXIT_SUCCESS;
+}
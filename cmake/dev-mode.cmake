@@ -5,6 +5,11 @@ if(BUILD_TESTING)
 	add_subdirectory(test)
 endif()
 
+option(BUILD_BENCHMARKS "Build the monkey_bench target" ON)
+if(BUILD_BENCHMARKS)
+	add_subdirectory(bench)
+endif()
+
 add_custom_target(
 	run-exe
 	COMMAND monkey_exe
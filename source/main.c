@@ -1,14 +1,45 @@
 #include "monkey/repl.h"
+#include "monkey/script.h"
 #include "monkey/stream.h"
 #include "monkey/user.h"
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 int main(int argc, const char* argv[]) {
-	(void)argc;
-	(void)argv;
+	MonkeyEngine engine = MONKEY_ENGINE_EVALUATOR;
+	bool optimize = false;
+	const char* script = NULL;
+	for (int i = 1; i < argc; ++i) {
+		if (strcmp(argv[i], "--engine=vm") == 0) {
+			engine = MONKEY_ENGINE_VM;
+		} else if (strcmp(argv[i], "--engine=eval") == 0) {
+			engine = MONKEY_ENGINE_EVALUATOR;
+		} else if (strcmp(argv[i], "--optimize") == 0) {
+			optimize = true;
+		} else if ((argv[i][0] != '-' || strcmp(argv[i], "-") == 0) && script == NULL) {
+			script = argv[i];
+		} else {
+			(void)fprintf(stderr, "Usage: %s [--engine=eval|vm] [--optimize] [script | -]\n",
+					argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (script != NULL) {
+		Stream* reader = StreamFromFile(stdin);
+		Stream* writer = StreamFromFile(stdout);
+		Stream* errors = StreamFromFile(stderr);
+		bool ok = MONKEY_RUN_SCRIPT(.path = script, .reader = reader, .writer = writer,
+				.errors = errors, .engine = engine, .optimize = optimize);
+		CloseStream(reader);
+		CloseStream(writer);
+		CloseStream(errors);
+		return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
 
 	char* user = CurrentUser();
 	if (user == NULL) {
@@ -20,7 +51,8 @@ int main(int argc, const char* argv[]) {
 	printf("Feel free to type in commands\n");
 	Stream* reader = StreamFromFile(stdin);
 	Stream* writer = StreamFromFile(stdout);
-	MONKEY_REPL(.reader = reader, .writer = writer);
+	MONKEY_REPL(
+			.reader = reader, .writer = writer, .engine = engine, .optimize = optimize);
 	CloseStream(reader);
 	CloseStream(writer);
 	return EXIT_SUCCESS;
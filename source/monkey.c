@@ -1,8 +1,9 @@
 #include "monkey.h"
 
+#include "monkey/heap.h"
 #include "monkey/macros.h"
 #include "monkey/object.h"
-#include "monkey/token.h"
+#include "monkey/symbol.h"
 
 #include <hedley.h>
 #include <stdbool.h>
@@ -13,8 +14,11 @@ MONKEY_INTERNAL const char LIBRARY_NAME[] = "Monkey";
 
 typedef struct {
 	Monkey base;
-	MonkeyTokenState* token;
+	MonkeySymbolTable* symbols;
 	MonkeyInternedObjects interns;
+	Heap* heap;
+	size_t maxCallDepth;
+	size_t stackLimit;
 } MonkeyImpl;
 
 Monkey* CreateMonkey(void) {
@@ -22,19 +26,19 @@ Monkey* CreateMonkey(void) {
 	char* name = malloc(sizeof LIBRARY_NAME);
 	(void)memcpy(name, LIBRARY_NAME, sizeof LIBRARY_NAME);
 	impl->base.name = name;
-	impl->token = CreateTokenState();
-	impl->interns.trueObj = (Object*)CreateBooleanObject(true);
-	impl->interns.trueObj->freeable = OBJECT_DISALLOW_FREE;
-	impl->interns.falseObj = (Object*)CreateBooleanObject(false);
-	impl->interns.falseObj->freeable = OBJECT_DISALLOW_FREE;
-	impl->interns.nullObj = (Object*)CreateNullObject();
-	impl->interns.nullObj->freeable = OBJECT_DISALLOW_FREE;
+	impl->symbols = CreateSymbolTable();
+	impl->interns.trueObj = BooleanToObject(true);
+	impl->interns.falseObj = BooleanToObject(false);
+	impl->interns.nullObj = NullToObject();
+	impl->heap = CreateHeap();
+	impl->maxCallDepth = MONKEY_DEFAULT_MAX_CALL_DEPTH;
+	impl->stackLimit = MONKEY_DEFAULT_STACK_LIMIT;
 	return (Monkey*)impl;
 }
 
-MonkeyTokenState* MonkeyGetTokenState(Monkey* monkey) {
+MonkeySymbolTable* MonkeyGetSymbols(Monkey* monkey) {
 	MonkeyImpl* impl = (MonkeyImpl*)monkey;
-	return impl->token;
+	return impl->symbols;
 }
 
 MonkeyInternedObjects MonkeyGetInterns(Monkey* monkey) {
@@ -42,15 +46,39 @@ MonkeyInternedObjects MonkeyGetInterns(Monkey* monkey) {
 	return impl->interns;
 }
 
+Heap* MonkeyGetHeap(Monkey* monkey) {
+	MonkeyImpl* impl = (MonkeyImpl*)monkey;
+	return impl->heap;
+}
+
+void MonkeySetCollectionThreshold(Monkey* monkey, size_t bytes) {
+	HeapSetThreshold(MonkeyGetHeap(monkey), bytes);
+}
+
+void MonkeySetMaxCallDepth(Monkey* monkey, size_t depth) {
+	MonkeyImpl* impl = (MonkeyImpl*)monkey;
+	impl->maxCallDepth = depth;
+}
+
+void MonkeySetStackLimit(Monkey* monkey, size_t bytes) {
+	MonkeyImpl* impl = (MonkeyImpl*)monkey;
+	impl->stackLimit = bytes;
+}
+
+size_t MonkeyGetMaxCallDepth(Monkey* monkey) {
+	MonkeyImpl* impl = (MonkeyImpl*)monkey;
+	return impl->maxCallDepth;
+}
+
+size_t MonkeyGetStackLimit(Monkey* monkey) {
+	MonkeyImpl* impl = (MonkeyImpl*)monkey;
+	return impl->stackLimit;
+}
+
 void DestroyMonkey(Monkey* lib) {
 	MonkeyImpl* impl = (MonkeyImpl*)lib;
-	impl->interns.trueObj->freeable = OBJECT_ALLOW_FREE;
-	DestroyObject(impl->interns.trueObj);
-	impl->interns.falseObj->freeable = OBJECT_ALLOW_FREE;
-	DestroyObject(impl->interns.falseObj);
-	impl->interns.nullObj->freeable = OBJECT_ALLOW_FREE;
-	DestroyObject(impl->interns.nullObj);
 	free(HEDLEY_CONST_CAST(void*, lib->name));
-	DestroyTokenState(impl->token);
+	DestroySymbolTable(impl->symbols);
+	DestroyHeap(impl->heap);
 	free(impl);
 }
@@ -1,11 +1,17 @@
 #pragma once
 
+#include "monkey/macros.h"
+
+#include <stddef.h>
+
 /**
- * @brief MonkeyTokenState is an opaque struct that holds the state of the
- * token module.
+ * @brief MonkeySymbolTable is an opaque struct that interns the identifiers of a Monkey instance
+ * (see monkey/symbol.h).
  */
-#include "monkey/macros.h"
-typedef struct MonkeyTokenState MonkeyTokenState;
+typedef struct MonkeySymbolTable MonkeySymbolTable;
+
+// avoid cyclic include with monkey/heap.h here
+typedef struct Heap Heap;
 
 /**
  * @brief Monkey is a struct that holds the public state of the Monkey library.
@@ -18,8 +24,8 @@ typedef struct {
  * @private
  *
  * This struct is retained as "global" state. It enables direct pointer
- * comparisons with objects of type bool and null, and reduces allocation
- * for those same common object types.
+ * comparisons with objects of type bool and null. These are immediates (see
+ * object.h), so they are never allocated.
  */
 typedef struct {
 	struct Object* trueObj;
@@ -35,13 +41,60 @@ Monkey* CreateMonkey(void);
 /**
  * @private
  */
-MONKEY_INTERNAL MonkeyTokenState* MonkeyGetTokenState(Monkey* monkey);
+MONKEY_INTERNAL MonkeySymbolTable* MonkeyGetSymbols(Monkey* monkey);
 
 /**
  * @private
  */
 MONKEY_INTERNAL MonkeyInternedObjects MonkeyGetInterns(Monkey* monkey);
 
+/**
+ * @private
+ */
+MONKEY_INTERNAL Heap* MonkeyGetHeap(Monkey* monkey);
+
+/**
+ * @brief Set how many bytes of objects may be allocated between garbage collections (see
+ * HeapSetThreshold). The default is HEAP_DEFAULT_THRESHOLD.
+ */
+void MonkeySetCollectionThreshold(Monkey* monkey, size_t bytes);
+
+/**
+ * @brief MONKEY_DEFAULT_MAX_CALL_DEPTH is how deeply Monkey functions may call each other, unless
+ * MonkeySetMaxCallDepth says otherwise.
+ */
+#define MONKEY_DEFAULT_MAX_CALL_DEPTH ((size_t)10000)
+
+/**
+ * @brief MONKEY_DEFAULT_STACK_LIMIT is how many bytes of C stack the evaluator may use, unless
+ * MonkeySetStackLimit says otherwise. It is a quarter of the main thread stack on Linux and macOS;
+ * threads with smaller stacks, like those on Windows, need a lower limit.
+ */
+#define MONKEY_DEFAULT_STACK_LIMIT ((size_t)2 << 20U)
+
+/**
+ * @brief Set how deeply Monkey functions may call each other. A call past the limit fails with a
+ * "stack overflow" error rather than crashing. Tail calls made by the evaluator do not count.
+ */
+void MonkeySetMaxCallDepth(Monkey* monkey, size_t depth);
+
+/**
+ * @brief Set how many bytes of C stack the evaluator may use below where Eval was called. A call
+ * that finds the evaluator past the limit fails with a "stack overflow" error, so set it well
+ * below the size of the stack of the thread that runs Monkey code.
+ */
+void MonkeySetStackLimit(Monkey* monkey, size_t bytes);
+
+/**
+ * @private
+ */
+MONKEY_INTERNAL size_t MonkeyGetMaxCallDepth(Monkey* monkey);
+
+/**
+ * @private
+ */
+MONKEY_INTERNAL size_t MonkeyGetStackLimit(Monkey* monkey);
+
 /**
  * @brief Destroys resources held by the library
  */
@@ -0,0 +1,79 @@
+#include "monkey/arena.h"
+
+#include "monkey/macros.h"
+
+#include <stdalign.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ARENA_CHUNK_SIZE ((size_t)16 << 10U)
+
+typedef struct ArenaChunk {
+	struct ArenaChunk* previous;
+	size_t capacity;
+	size_t used;
+	alignas(max_align_t) unsigned char data[];
+} ArenaChunk;
+
+struct Arena {
+	/**
+	 * @brief chunk is the chunk being allocated from, which links to the full ones.
+	 */
+	ArenaChunk* chunk;
+	size_t refCount;
+};
+
+MONKEY_FILE_LOCAL ArenaChunk* createChunk(ArenaChunk* previous, size_t capacity) {
+	ArenaChunk* chunk = calloc(1, sizeof(ArenaChunk) + capacity);
+	chunk->previous = previous;
+	chunk->capacity = capacity;
+	return chunk;
+}
+
+Arena* CreateArena(void) {
+	Arena* arena = malloc(sizeof(Arena));
+	arena->chunk = createChunk(NULL, ARENA_CHUNK_SIZE);
+	arena->refCount = 1;
+	return arena;
+}
+
+void* ArenaAllocate(Arena* arena, size_t size) {
+	const size_t alignment = alignof(max_align_t);
+	size = (size + alignment - 1) & ~(alignment - 1);
+	ArenaChunk* chunk = arena->chunk;
+	if (chunk->capacity - chunk->used < size) {
+		chunk = createChunk(chunk, size > ARENA_CHUNK_SIZE ? size : ARENA_CHUNK_SIZE);
+		arena->chunk = chunk;
+	}
+	void* result = chunk->data + chunk->used;
+	chunk->used += size;
+	return result;
+}
+
+void* ArenaCopy(Arena* arena, const void* data, size_t size) {
+	if (size == 0) {
+		return NULL;
+	}
+	void* result = ArenaAllocate(arena, size);
+	memcpy(result, data, size);
+	return result;
+}
+
+Arena* RetainArena(Arena* arena) {
+	++arena->refCount;
+	return arena;
+}
+
+void ReleaseArena(Arena* arena) {
+	if (--arena->refCount > 0) {
+		return;
+	}
+	ArenaChunk* chunk = arena->chunk;
+	while (chunk != NULL) {
+		ArenaChunk* previous = chunk->previous;
+		free(chunk);
+		chunk = previous;
+	}
+	free(arena);
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stddef.h>
+
+/**
+ * @brief Arena is a bump allocator whose allocations are all freed together.
+ *
+ * Memory comes from large zeroed chunks, so allocating is a pointer increment and objects made
+ * one after another sit next to each other. Arenas are reference counted, so that whatever refers
+ * into one (like a function value referring to the AST of its body) can keep it alive.
+ */
+typedef struct Arena Arena;
+
+/**
+ * @brief Create an empty arena, with a reference count of one.
+ */
+Arena* CreateArena(void);
+
+/**
+ * @brief Allocate zeroed memory from an arena, aligned for any type.
+ *
+ * @param arena the arena
+ * @param size the number of bytes
+ * @return void* the memory, which lives as long as the arena
+ */
+void* ArenaAllocate(Arena* arena, size_t size);
+
+/**
+ * @brief Copy memory into an arena.
+ *
+ * @param arena the arena
+ * @param data the memory to copy, which may be NULL if size is zero
+ * @param size the number of bytes
+ * @return void* the copy, or NULL if size is zero
+ */
+void* ArenaCopy(Arena* arena, const void* data, size_t size);
+
+/**
+ * @brief Take another reference to an arena.
+ *
+ * @return Arena* arena itself
+ */
+Arena* RetainArena(Arena* arena);
+
+/**
+ * @brief Drop a reference to an arena, freeing all its memory when it was the last one.
+ */
+void ReleaseArena(Arena* arena);
@@ -1,6 +1,7 @@
 #include "monkey/ast.h"
 
 #include "buffer.h"
+#include "monkey/arena.h"
 #include "monkey/macros.h"
 #include "monkey/string.h"
 #include "monkey/token.h"
@@ -11,90 +12,81 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
-#include <stdlib.h>
 
-MONKEY_FILE_LOCAL void initStatement(Statement* statement, StatementType type) {
-	statement->base.type = NODE_TYPE_STATEMENT;
-	statement->type = type;
-}
-
-MONKEY_FILE_LOCAL void initExpression(Expression* expression, ExpressionType type) {
-	expression->base.type = NODE_TYPE_EXPRESSION;
-	expression->type = type;
-}
-
-void DestroyExpression(Expression* expression) {
-	if (expression == NULL) {
-		return;
+const char* OperatorText(Operator op) {
+	switch (op) {
+#define X(name, string) \
+	case OPERATOR_##name: \
+		return string;
+		OPERATORS_X
+#undef X
 	}
-	switch (expression->type) {
-		case EXPRESSION_TYPE_IDENTIFIER:
-			DestroyIdentifier((Identifier*)expression);
-			return;
-		case EXPRESSION_TYPE_INTEGER_LITERAL:
-			DestroyIntegerLiteral((IntegerLiteral*)expression);
-			return;
-		case EXPRESSION_TYPE_BOOLEAN_LITERAL:
-			DestroyBooleanLiteral((BooleanLiteral*)expression);
-			return;
-		case EXPRESSION_TYPE_PREFIX:
-			DestroyPrefixExpression((PrefixExpression*)expression);
-			return;
-		case EXPRESSION_TYPE_INFIX:
-			DestroyInfixExpression((InfixExpression*)expression);
-			return;
-		case EXPRESSION_TYPE_IF:
-			DestroyIfExpression((IfExpression*)expression);
-			return;
-		case EXPRESSION_TYPE_FUNCTION_LITERAL:
-			DestroyFunctionLiteral((FunctionLiteral*)expression);
-			return;
-		case EXPRESSION_TYPE_CALL:
-			DestroyCallExpression((CallExpression*)expression);
-			return;
-	}
-	(void)fprintf(stderr, "Unknown expression type: %d\n", expression->type);
+	(void)fprintf(stderr, "Unknown operator: %d\n", op);
 	assert(false);
+	return NULL;
 }
 
-MONKEY_FILE_LOCAL void destroyStatement(Statement* statement);
-
-MONKEY_FILE_LOCAL void destroyLetStatement(LetStatement* statement) {
-	DestroyToken(&statement->token);
-	DestroyIdentifier(statement->identifier);
-	DestroyExpression(statement->value);
-	free(statement);
+bool ApplyIntegerOperator(Operator op, int64_t left, int64_t right, int64_t* result) {
+	switch (op) {
+		case OPERATOR_PLUS:
+			if (right > 0 ? left > INT64_MAX - right : left < INT64_MIN - right) {
+				return false;
+			}
+			*result = left + right;
+			return true;
+		case OPERATOR_MINUS:
+			if (right < 0 ? left > INT64_MAX + right : left < INT64_MIN + right) {
+				return false;
+			}
+			*result = left - right;
+			return true;
+		case OPERATOR_ASTERISK: {
+			bool overflows = false;
+			if (left > 0) {
+				overflows = right > 0 ? left > INT64_MAX / right : right < INT64_MIN / left;
+			} else if (left < 0) {
+				overflows = right > 0 ? left < INT64_MIN / right : right < INT64_MAX / left;
+			}
+			if (overflows) {
+				return false;
+			}
+			*result = left * right;
+			return true;
+		}
+		case OPERATOR_SLASH:
+			if (right == 0 || (left == INT64_MIN && right == -1)) {
+				return false;
+			}
+			*result = left / right;
+			return true;
+		default:
+			return false;
+	}
 }
 
-MONKEY_FILE_LOCAL void destroyReturnStatement(ReturnStatement* statement) {
-	DestroyToken(&statement->token);
-	DestroyExpression(statement->returnValue);
-	free(statement);
-}
+MONKEY_FILE_LOCAL void appendPrefixExpression(
+		MonkeyStringBuilder* out, const PrefixExpression* prefix);
+MONKEY_FILE_LOCAL void appendInfixExpression(
+		MonkeyStringBuilder* out, const InfixExpression* infix);
+MONKEY_FILE_LOCAL void appendIfExpression(MonkeyStringBuilder* out, const IfExpression* exp);
+MONKEY_FILE_LOCAL void appendFunctionLiteral(MonkeyStringBuilder* out, const FunctionLiteral* exp);
+MONKEY_FILE_LOCAL void appendCallExpression(MonkeyStringBuilder* out, const CallExpression* exp);
+MONKEY_FILE_LOCAL void appendLetStatement(MonkeyStringBuilder* out, const LetStatement* statement);
+MONKEY_FILE_LOCAL void appendReturnStatement(
+		MonkeyStringBuilder* out, const ReturnStatement* statement);
+MONKEY_FILE_LOCAL void appendExpressionStatement(
+		MonkeyStringBuilder* out, const ExpressionStatement* statement);
+MONKEY_FILE_LOCAL void appendBlockStatement(
+		MonkeyStringBuilder* out, const BlockStatement* statement);
 
-MONKEY_FILE_LOCAL void destroyExpressionStatement(ExpressionStatement* statement) {
-	DestroyToken(&statement->token);
-	DestroyExpression(statement->expression);
-	free(statement);
+MONKEY_FILE_LOCAL void initStatement(Statement* statement, StatementType type) {
+	statement->base.type = NODE_TYPE_STATEMENT;
+	statement->type = type;
 }
 
-MONKEY_FILE_LOCAL void destroyStatement(Statement* statement) {
-	switch (statement->type) {
-		case STATEMENT_TYPE_LET:
-			destroyLetStatement((LetStatement*)statement);
-			return;
-		case STATEMENT_TYPE_RETURN:
-			destroyReturnStatement((ReturnStatement*)statement);
-			return;
-		case STATEMENT_TYPE_EXPRESSION:
-			destroyExpressionStatement((ExpressionStatement*)statement);
-			return;
-		case STATEMENT_TYPE_BLOCK:
-			DestroyBlockStatement((BlockStatement*)statement);
-			return;
-	}
-	(void)fprintf(stderr, "Unknown statement type: %d\n", statement->type);
-	assert(false);
+MONKEY_FILE_LOCAL void initExpression(Expression* expression, ExpressionType type) {
+	expression->base.type = NODE_TYPE_EXPRESSION;
+	expression->type = type;
 }
 
 char* StatementTokenLiteral(const Statement* statement) {
@@ -113,50 +105,73 @@ char* StatementTokenLiteral(const Statement* statement) {
 	return NULL;
 }
 
-char* StatementString(const Statement* statement) {
+void AppendStatementString(MonkeyStringBuilder* out, const Statement* statement) {
 	switch (statement->type) {
 		case STATEMENT_TYPE_LET:
-			return LetStatementString((const LetStatement*)statement);
+			appendLetStatement(out, (const LetStatement*)statement);
+			return;
 		case STATEMENT_TYPE_RETURN:
-			return ReturnStatementString((const ReturnStatement*)statement);
+			appendReturnStatement(out, (const ReturnStatement*)statement);
+			return;
 		case STATEMENT_TYPE_EXPRESSION:
-			return ExpressionStatementString((const ExpressionStatement*)statement);
+			appendExpressionStatement(out, (const ExpressionStatement*)statement);
+			return;
 		case STATEMENT_TYPE_BLOCK:
-			return BlockStatementString((const BlockStatement*)statement);
+			appendBlockStatement(out, (const BlockStatement*)statement);
+			return;
 	}
 	(void)fprintf(stderr, "Unknown statement type: %d\n", statement->type);
 	assert(false);
-	return NULL;
 }
 
-char* ExpressionString(const Expression* expression) {
+char* StatementString(const Statement* statement) {
+	MonkeyStringBuilder out = BUFFER_INIT;
+	AppendStatementString(&out, statement);
+	return MonkeyStringBuilderFinish(&out);
+}
+
+void AppendExpressionString(MonkeyStringBuilder* out, const Expression* expression) {
 	switch (expression->type) {
 		case EXPRESSION_TYPE_IDENTIFIER:
-			return IdentifierString((const Identifier*)expression);
+			MonkeyStringBuilderAppendView(out, ((const Identifier*)expression)->value);
+			return;
 		case EXPRESSION_TYPE_INTEGER_LITERAL:
-			return IntegerLiteralString((const IntegerLiteral*)expression);
+			MonkeyStringBuilderAppendView(out, ((const IntegerLiteral*)expression)->token.literal);
+			return;
 		case EXPRESSION_TYPE_BOOLEAN_LITERAL:
-			return BooleanLiteralString((const BooleanLiteral*)expression);
+			MonkeyStringBuilderAppendView(out, ((const BooleanLiteral*)expression)->token.literal);
+			return;
 		case EXPRESSION_TYPE_PREFIX:
-			return PrefixExpressionString((const PrefixExpression*)expression);
+			appendPrefixExpression(out, (const PrefixExpression*)expression);
+			return;
 		case EXPRESSION_TYPE_INFIX:
-			return InfixExpressionString((const InfixExpression*)expression);
+			appendInfixExpression(out, (const InfixExpression*)expression);
+			return;
 		case EXPRESSION_TYPE_IF:
-			return IfExpressionString((const IfExpression*)expression);
+			appendIfExpression(out, (const IfExpression*)expression);
+			return;
 		case EXPRESSION_TYPE_FUNCTION_LITERAL:
-			return FunctionLiteralString((const FunctionLiteral*)expression);
+			appendFunctionLiteral(out, (const FunctionLiteral*)expression);
+			return;
 		case EXPRESSION_TYPE_CALL:
-			return CallExpressionString((const CallExpression*)expression);
+			appendCallExpression(out, (const CallExpression*)expression);
+			return;
 	}
 	(void)fprintf(stderr, "Unknown expression type: %d\n", expression->type);
 	assert(false);
-	return NULL;
 }
 
-Program* CreateProgram(StatementSpan statements) {
-	Program* program = calloc(1, sizeof(Program));
+char* ExpressionString(const Expression* expression) {
+	MonkeyStringBuilder out = BUFFER_INIT;
+	AppendExpressionString(&out, expression);
+	return MonkeyStringBuilderFinish(&out);
+}
+
+Program* CreateProgram(Arena* arena, StatementSpan statements) {
+	Program* program = ArenaAllocate(arena, sizeof(Program));
 	program->base.type = NODE_TYPE_PROGRAM;
 	program->statements = statements;
+	program->arena = arena;
 	return program;
 }
 
@@ -169,50 +184,36 @@ char* ProgramTokenLiteral(const Program* program) {
 }
 
 char* ProgramString(const Program* program) {
-	MonkeyStringBuffer statementStrings = BUFFER_INIT;
+	MonkeyStringBuilder out = BUFFER_INIT;
 	for (size_t i = 0; i < program->statements.length; ++i) {
-		BUFFER_PUSH(&statementStrings, StatementString(program->statements.begin[i]));
+		AppendStatementString(&out, program->statements.begin[i]);
 	}
-	char* result = MonkeyStringJoin((MonkeyStringSpan)BUFFER_AS_SPAN(statementStrings));
-	for (size_t i = 0; i < statementStrings.length; ++i) {
-		free(statementStrings.data[i]);
-	}
-	BUFFER_FREE(statementStrings);
-	return result;
+	return MonkeyStringBuilderFinish(&out);
 }
 
 void DestroyProgram(Program* program) {
-	for (size_t i = 0; i < program->statements.length; i++) {
-		destroyStatement(program->statements.begin[i]);
-	}
-	free(program->statements.begin);
-	free(program);
+	ReleaseArena(program->arena);
 }
 
-Identifier* CreateIdentifier(Token token, char* value) {
-	Identifier* identifier = calloc(1, sizeof(Identifier));
+Identifier* CreateIdentifier(Arena* arena, Token token, MonkeyStringView value) {
+	Identifier* identifier = ArenaAllocate(arena, sizeof(Identifier));
 	initExpression(&identifier->base, EXPRESSION_TYPE_IDENTIFIER);
 	identifier->token = token;
 	identifier->value = value;
+	identifier->symbol = token.symbol;
 	return identifier;
 }
 
 char* IdentifierTokenLiteral(const Identifier* identifier) {
-	return MonkeyStrdup(identifier->token.literal);
+	return MonkeyStringViewDup(identifier->token.literal);
 }
 
 char* IdentifierString(const Identifier* identifier) {
-	return MonkeyStrdup(identifier->value);
-}
-
-void DestroyIdentifier(Identifier* identifier) {
-	DestroyToken(&identifier->token);
-	free(identifier->value);
-	free(identifier);
+	return MonkeyStringViewDup(identifier->value);
 }
 
-IntegerLiteral* CreateIntegerLiteral(Token token, int64_t value) {
-	IntegerLiteral* integerLiteral = calloc(1, sizeof(IntegerLiteral));
+IntegerLiteral* CreateIntegerLiteral(Arena* arena, Token token, int64_t value) {
+	IntegerLiteral* integerLiteral = ArenaAllocate(arena, sizeof(IntegerLiteral));
 	initExpression(&integerLiteral->base, EXPRESSION_TYPE_INTEGER_LITERAL);
 	integerLiteral->token = token;
 	integerLiteral->value = value;
@@ -220,20 +221,15 @@ IntegerLiteral* CreateIntegerLiteral(Token token, int64_t value) {
 }
 
 char* IntegerLiteralTokenLiteral(const IntegerLiteral* integerLiteral) {
-	return MonkeyStrdup(integerLiteral->token.literal);
+	return MonkeyStringViewDup(integerLiteral->token.literal);
 }
 
 char* IntegerLiteralString(const IntegerLiteral* integerLiteral) {
-	return MonkeyStrdup(integerLiteral->token.literal);
+	return MonkeyStringViewDup(integerLiteral->token.literal);
 }
 
-void DestroyIntegerLiteral(IntegerLiteral* integerLiteral) {
-	DestroyToken(&integerLiteral->token);
-	free(integerLiteral);
-}
-
-BooleanLiteral* CreateBooleanLiteral(Token token, int64_t value) {
-	BooleanLiteral* booleanLiteral = calloc(1, sizeof(BooleanLiteral));
+BooleanLiteral* CreateBooleanLiteral(Arena* arena, Token token, int64_t value) {
+	BooleanLiteral* booleanLiteral = ArenaAllocate(arena, sizeof(BooleanLiteral));
 	initExpression(&booleanLiteral->base, EXPRESSION_TYPE_BOOLEAN_LITERAL);
 	booleanLiteral->token = token;
 	booleanLiteral->value = value;
@@ -241,20 +237,16 @@ BooleanLiteral* CreateBooleanLiteral(Token token, int64_t value) {
 }
 
 char* BooleanLiteralTokenLiteral(const BooleanLiteral* booleanLiteral) {
-	return MonkeyStrdup(booleanLiteral->token.literal);
+	return MonkeyStringViewDup(booleanLiteral->token.literal);
 }
 
 char* BooleanLiteralString(const BooleanLiteral* booleanLiteral) {
-	return MonkeyStrdup(booleanLiteral->token.literal);
-}
-
-void DestroyBooleanLiteral(BooleanLiteral* booleanLiteral) {
-	DestroyToken(&booleanLiteral->token);
-	free(booleanLiteral);
+	return MonkeyStringViewDup(booleanLiteral->token.literal);
 }
 
-PrefixExpression* CreatePrefixExpression(Token token, char* op, Expression* right) {
-	PrefixExpression* prefix = calloc(1, sizeof(PrefixExpression));
+PrefixExpression* CreatePrefixExpression(
+		Arena* arena, Token token, Operator op, Expression* right) {
+	PrefixExpression* prefix = ArenaAllocate(arena, sizeof(PrefixExpression));
 	initExpression(&prefix->base, EXPRESSION_TYPE_PREFIX);
 	prefix->token = token;
 	prefix->op = op;
@@ -263,32 +255,24 @@ PrefixExpression* CreatePrefixExpression(Token token, char* op, Expression* righ
 }
 
 char* PrefixExpressionTokenLiteral(const PrefixExpression* prefix) {
-	return MonkeyStrdup(prefix->token.literal);
+	return MonkeyStringViewDup(prefix->token.literal);
 }
 
-char* PrefixExpressionString(const PrefixExpression* prefix) {
-	MonkeyStringBuffer out = BUFFER_INIT;
-	BUFFER_PUSH(&out, MonkeyStrdup("("));
-	BUFFER_PUSH(&out, MonkeyStrdup(prefix->op));
-	BUFFER_PUSH(&out, ExpressionString(prefix->right));
-	BUFFER_PUSH(&out, MonkeyStrdup(")"));
-	char* result = MonkeyStringJoin((MonkeyStringSpan)BUFFER_AS_SPAN(out));
-	for (size_t i = 0; i < out.length; ++i) {
-		free(out.data[i]);
-	}
-	BUFFER_FREE(out);
-	return result;
+MONKEY_FILE_LOCAL void appendPrefixExpression(
+		MonkeyStringBuilder* out, const PrefixExpression* prefix) {
+	MonkeyStringBuilderAppend(out, "(");
+	MonkeyStringBuilderAppend(out, OperatorText(prefix->op));
+	AppendExpressionString(out, prefix->right);
+	MonkeyStringBuilderAppend(out, ")");
 }
 
-void DestroyPrefixExpression(PrefixExpression* prefix) {
-	DestroyToken(&prefix->token);
-	free(prefix->op);
-	DestroyExpression(prefix->right);
-	free(prefix);
+char* PrefixExpressionString(const PrefixExpression* prefix) {
+	return ExpressionString(&prefix->base);
 }
 
-InfixExpression* CreateInfixExpression(Token token, Expression* left, char* op, Expression* right) {
-	InfixExpression* infix = calloc(1, sizeof(InfixExpression));
+InfixExpression* CreateInfixExpression(
+		Arena* arena, Token token, Expression* left, Operator op, Expression* right) {
+	InfixExpression* infix = ArenaAllocate(arena, sizeof(InfixExpression));
 	initExpression(&infix->base, EXPRESSION_TYPE_INFIX);
 	infix->token = token;
 	infix->left = left;
@@ -298,37 +282,27 @@ InfixExpression* CreateInfixExpression(Token token, Expression* left, char* op,
 }
 
 char* InfixExpressionTokenLiteral(const InfixExpression* infix) {
-	return MonkeyStrdup(infix->token.literal);
+	return MonkeyStringViewDup(infix->token.literal);
 }
 
-char* InfixExpressionString(const InfixExpression* infix) {
-	MonkeyStringBuffer out = BUFFER_INIT;
-	BUFFER_PUSH(&out, MonkeyStrdup("("));
-	BUFFER_PUSH(&out, ExpressionString(infix->left));
-	BUFFER_PUSH(&out, MonkeyStrdup(" "));
-	BUFFER_PUSH(&out, MonkeyStrdup(infix->op));
-	BUFFER_PUSH(&out, MonkeyStrdup(" "));
-	BUFFER_PUSH(&out, ExpressionString(infix->right));
-	BUFFER_PUSH(&out, MonkeyStrdup(")"));
-	char* result = MonkeyStringJoin((MonkeyStringSpan)BUFFER_AS_SPAN(out));
-	for (size_t i = 0; i < out.length; ++i) {
-		free(out.data[i]);
-	}
-	BUFFER_FREE(out);
-	return result;
+MONKEY_FILE_LOCAL void appendInfixExpression(
+		MonkeyStringBuilder* out, const InfixExpression* infix) {
+	MonkeyStringBuilderAppend(out, "(");
+	AppendExpressionString(out, infix->left);
+	MonkeyStringBuilderAppend(out, " ");
+	MonkeyStringBuilderAppend(out, OperatorText(infix->op));
+	MonkeyStringBuilderAppend(out, " ");
+	AppendExpressionString(out, infix->right);
+	MonkeyStringBuilderAppend(out, ")");
 }
 
-void DestroyInfixExpression(InfixExpression* infix) {
-	DestroyToken(&infix->token);
-	DestroyExpression(infix->left);
-	free(infix->op);
-	DestroyExpression(infix->right);
-	free(infix);
+char* InfixExpressionString(const InfixExpression* infix) {
+	return ExpressionString(&infix->base);
 }
 
-IfExpression* CreateIfExpression(Token token, Expression* condition, BlockStatement* consequence,
-		BlockStatement* alternative) {
-	IfExpression* exp = calloc(1, sizeof(IfExpression));
+IfExpression* CreateIfExpression(Arena* arena, Token token, Expression* condition,
+		BlockStatement* consequence, BlockStatement* alternative) {
+	IfExpression* exp = ArenaAllocate(arena, sizeof(IfExpression));
 	initExpression(&exp->base, EXPRESSION_TYPE_IF);
 	exp->token = token;
 	exp->condition = condition;
@@ -338,81 +312,59 @@ IfExpression* CreateIfExpression(Token token, Expression* condition, BlockStatem
 }
 
 char* IfExpressionTokenLiteral(const IfExpression* exp) {
-	return MonkeyStrdup(exp->token.literal);
+	return MonkeyStringViewDup(exp->token.literal);
 }
 
-char* IfExpressionString(const IfExpression* exp) {
-	MonkeyStringBuffer out = BUFFER_INIT;
-	BUFFER_PUSH(&out, MonkeyStrdup("if"));
-	BUFFER_PUSH(&out, ExpressionString(exp->condition));
-	BUFFER_PUSH(&out, MonkeyStrdup(" "));
-	BUFFER_PUSH(&out, StatementString(&exp->consequence->base));
+MONKEY_FILE_LOCAL void appendIfExpression(MonkeyStringBuilder* out, const IfExpression* exp) {
+	MonkeyStringBuilderAppend(out, "if");
+	AppendExpressionString(out, exp->condition);
+	MonkeyStringBuilderAppend(out, " ");
+	appendBlockStatement(out, exp->consequence);
 	if (exp->alternative != NULL) {
-		BUFFER_PUSH(&out, MonkeyStrdup(" else "));
-		BUFFER_PUSH(&out, StatementString(&exp->alternative->base));
-	}
-	char* result = MonkeyStringJoin((MonkeyStringSpan)BUFFER_AS_SPAN(out));
-	for (size_t i = 0; i < out.length; ++i) {
-		free(out.data[i]);
+		MonkeyStringBuilderAppend(out, " else ");
+		appendBlockStatement(out, exp->alternative);
 	}
-	BUFFER_FREE(out);
-	return result;
 }
 
-void DestroyIfExpression(IfExpression* exp) {
-	DestroyToken(&exp->token);
-	DestroyExpression(exp->condition);
-	DestroyBlockStatement(exp->consequence);
-	DestroyBlockStatement(exp->alternative);
-	free(exp);
+char* IfExpressionString(const IfExpression* exp) {
+	return ExpressionString(&exp->base);
 }
 
 FunctionLiteral* CreateFunctionLiteral(
-		Token token, IdentifierSpan parameters, BlockStatement* body) {
-	FunctionLiteral* exp = calloc(1, sizeof(FunctionLiteral));
+		Arena* arena, Token token, IdentifierSpan parameters, BlockStatement* body) {
+	FunctionLiteral* exp = ArenaAllocate(arena, sizeof(FunctionLiteral));
 	initExpression(&exp->base, EXPRESSION_TYPE_FUNCTION_LITERAL);
 	exp->token = token;
 	exp->parameters = parameters;
 	exp->body = body;
+	exp->arena = arena;
 	return exp;
 }
 
 char* FunctionLiteralTokenLiteral(const FunctionLiteral* exp) {
-	return MonkeyStrdup(exp->token.literal);
+	return MonkeyStringViewDup(exp->token.literal);
 }
 
-char* FunctionLiteralString(const FunctionLiteral* exp) {
-	MonkeyStringBuffer out = BUFFER_INIT;
-	BUFFER_PUSH(&out, FunctionLiteralTokenLiteral(exp));
-	BUFFER_PUSH(&out, MonkeyStrdup("("));
+MONKEY_FILE_LOCAL void appendFunctionLiteral(MonkeyStringBuilder* out, const FunctionLiteral* exp) {
+	MonkeyStringBuilderAppendView(out, exp->token.literal);
+	MonkeyStringBuilderAppend(out, "(");
 	for (size_t i = 0; i < exp->parameters.length; ++i) {
 		if (i > 0) {
-			BUFFER_PUSH(&out, MonkeyStrdup(", "));
+			MonkeyStringBuilderAppend(out, ", ");
 		}
-		BUFFER_PUSH(&out, IdentifierString(exp->parameters.begin[i]));
-	}
-	BUFFER_PUSH(&out, MonkeyStrdup(")"));
-	BUFFER_PUSH(&out, BlockStatementString(exp->body));
-	char* result = MonkeyStringJoin((MonkeyStringSpan)BUFFER_AS_SPAN(out));
-	for (size_t i = 0; i < out.length; ++i) {
-		free(out.data[i]);
+		MonkeyStringBuilderAppendView(out, exp->parameters.begin[i]->value);
 	}
-	BUFFER_FREE(out);
-	return result;
+	MonkeyStringBuilderAppend(out, ")");
+	appendBlockStatement(out, exp->body);
 }
 
-void DestroyFunctionLiteral(FunctionLiteral* exp) {
-	DestroyToken(&exp->token);
-	for (size_t i = 0; i < exp->parameters.length; ++i) {
-		DestroyIdentifier(exp->parameters.begin[i]);
-	}
-	free(exp->parameters.begin);
-	DestroyBlockStatement(exp->body);
-	free(exp);
+char* FunctionLiteralString(const FunctionLiteral* exp) {
+	return ExpressionString(&exp->base);
 }
 
-CallExpression* CreateCallExpression(Token token, Expression* function, ExpressionSpan arguments) {
-	CallExpression* exp = calloc(1, sizeof(CallExpression));
+CallExpression* CreateCallExpression(
+		Arena* arena, Token token, Expression* function, ExpressionSpan arguments) {
+	CallExpression* exp = ArenaAllocate(arena, sizeof(CallExpression));
 	initExpression(&exp->base, EXPRESSION_TYPE_CALL);
 	exp->token = token;
 	exp->function = function;
@@ -421,40 +373,28 @@ CallExpression* CreateCallExpression(Token token, Expression* function, Expressi
 }
 
 char* CallExpressionTokenLiteral(const CallExpression* exp) {
-	return MonkeyStrdup(exp->token.literal);
+	return MonkeyStringViewDup(exp->token.literal);
 }
 
-char* CallExpressionString(const CallExpression* exp) {
-	MonkeyStringBuffer out = BUFFER_INIT;
-	BUFFER_PUSH(&out, ExpressionString(exp->function));
-	BUFFER_PUSH(&out, MonkeyStrdup("("));
+MONKEY_FILE_LOCAL void appendCallExpression(MonkeyStringBuilder* out, const CallExpression* exp) {
+	AppendExpressionString(out, exp->function);
+	MonkeyStringBuilderAppend(out, "(");
 	for (size_t i = 0; i < exp->arguments.length; ++i) {
 		if (i > 0) {
-			BUFFER_PUSH(&out, MonkeyStrdup(", "));
+			MonkeyStringBuilderAppend(out, ", ");
 		}
-		BUFFER_PUSH(&out, ExpressionString(exp->arguments.begin[i]));
+		AppendExpressionString(out, exp->arguments.begin[i]);
 	}
-	BUFFER_PUSH(&out, MonkeyStrdup(")"));
-	char* result = MonkeyStringJoin((MonkeyStringSpan)BUFFER_AS_SPAN(out));
-	for (size_t i = 0; i < out.length; ++i) {
-		free(out.data[i]);
-	}
-	BUFFER_FREE(out);
-	return result;
+	MonkeyStringBuilderAppend(out, ")");
 }
 
-void DestroyCallExpression(CallExpression* exp) {
-	DestroyToken(&exp->token);
-	DestroyExpression(exp->function);
-	for (size_t i = 0; i < exp->arguments.length; ++i) {
-		DestroyExpression(exp->arguments.begin[i]);
-	}
-	free(exp->arguments.begin);
-	free(exp);
+char* CallExpressionString(const CallExpression* exp) {
+	return ExpressionString(&exp->base);
 }
 
-LetStatement* CreateLetStatement(Token token, Identifier* identifier, Expression* value) {
-	LetStatement* statement = calloc(1, sizeof(LetStatement));
+LetStatement* CreateLetStatement(
+		Arena* arena, Token token, Identifier* identifier, Expression* value) {
+	LetStatement* statement = ArenaAllocate(arena, sizeof(LetStatement));
 	initStatement(&statement->base, STATEMENT_TYPE_LET);
 	statement->token = token;
 	statement->identifier = identifier;
@@ -463,29 +403,26 @@ LetStatement* CreateLetStatement(Token token, Identifier* identifier, Expression
 }
 
 char* LetStatementTokenLiteral(const LetStatement* statement) {
-	return MonkeyStrdup(statement->token.literal);
+	return MonkeyStringViewDup(statement->token.literal);
 }
 
-char* LetStatementString(const LetStatement* statement) {
-	MonkeyStringBuffer out = BUFFER_INIT;
-	BUFFER_PUSH(&out, LetStatementTokenLiteral(statement));
-	BUFFER_PUSH(&out, MonkeyStrdup(" "));
-	BUFFER_PUSH(&out, IdentifierString(statement->identifier));
-	BUFFER_PUSH(&out, MonkeyStrdup(" = "));
+MONKEY_FILE_LOCAL void appendLetStatement(MonkeyStringBuilder* out, const LetStatement* statement) {
+	MonkeyStringBuilderAppendView(out, statement->token.literal);
+	MonkeyStringBuilderAppend(out, " ");
+	MonkeyStringBuilderAppendView(out, statement->identifier->value);
+	MonkeyStringBuilderAppend(out, " = ");
 	if (statement->value != NULL) {
-		BUFFER_PUSH(&out, ExpressionString(statement->value));
-	}
-	BUFFER_PUSH(&out, MonkeyStrdup(";"));
-	char* result = MonkeyStringJoin((MonkeyStringSpan)BUFFER_AS_SPAN(out));
-	for (size_t i = 0; i < out.length; ++i) {
-		free(out.data[i]);
+		AppendExpressionString(out, statement->value);
 	}
-	BUFFER_FREE(out);
-	return result;
+	MonkeyStringBuilderAppend(out, ";");
 }
 
-ReturnStatement* CreateReturnStatement(Token token, Expression* returnValue) {
-	ReturnStatement* statement = calloc(1, sizeof(ReturnStatement));
+char* LetStatementString(const LetStatement* statement) {
+	return StatementString(&statement->base);
+}
+
+ReturnStatement* CreateReturnStatement(Arena* arena, Token token, Expression* returnValue) {
+	ReturnStatement* statement = ArenaAllocate(arena, sizeof(ReturnStatement));
 	initStatement(&statement->base, STATEMENT_TYPE_RETURN);
 	statement->token = token;
 	statement->returnValue = returnValue;
@@ -493,27 +430,26 @@ ReturnStatement* CreateReturnStatement(Token token, Expression* returnValue) {
 }
 
 char* ReturnStatementTokenLiteral(const ReturnStatement* statement) {
-	return MonkeyStrdup(statement->token.literal);
+	return MonkeyStringViewDup(statement->token.literal);
 }
 
-char* ReturnStatementString(const ReturnStatement* statement) {
-	MonkeyStringBuffer out = BUFFER_INIT;
-	BUFFER_PUSH(&out, ReturnStatementTokenLiteral(statement));
-	BUFFER_PUSH(&out, MonkeyStrdup(" "));
+MONKEY_FILE_LOCAL void appendReturnStatement(
+		MonkeyStringBuilder* out, const ReturnStatement* statement) {
+	MonkeyStringBuilderAppendView(out, statement->token.literal);
+	MonkeyStringBuilderAppend(out, " ");
 	if (statement->returnValue != NULL) {
-		BUFFER_PUSH(&out, ExpressionString(statement->returnValue));
-	}
-	BUFFER_PUSH(&out, MonkeyStrdup(";"));
-	char* result = MonkeyStringJoin((MonkeyStringSpan)BUFFER_AS_SPAN(out));
-	for (size_t i = 0; i < out.length; ++i) {
-		free(out.data[i]);
+		AppendExpressionString(out, statement->returnValue);
 	}
-	BUFFER_FREE(out);
-	return result;
+	MonkeyStringBuilderAppend(out, ";");
 }
 
-ExpressionStatement* CreateExpressionStatement(Token token, Expression* expression) {
-	ExpressionStatement* statement = calloc(1, sizeof(ExpressionStatement));
+char* ReturnStatementString(const ReturnStatement* statement) {
+	return StatementString(&statement->base);
+}
+
+ExpressionStatement* CreateExpressionStatement(
+		Arena* arena, Token token, Expression* expression) {
+	ExpressionStatement* statement = ArenaAllocate(arena, sizeof(ExpressionStatement));
 	initStatement(&statement->base, STATEMENT_TYPE_EXPRESSION);
 	statement->token = token;
 	statement->expression = expression;
@@ -521,18 +457,22 @@ ExpressionStatement* CreateExpressionStatement(Token token, Expression* expressi
 }
 
 char* ExpressionStatementTokenLiteral(const ExpressionStatement* statement) {
-	return MonkeyStrdup(statement->token.literal);
+	return MonkeyStringViewDup(statement->token.literal);
 }
 
-char* ExpressionStatementString(const ExpressionStatement* statement) {
+MONKEY_FILE_LOCAL void appendExpressionStatement(
+		MonkeyStringBuilder* out, const ExpressionStatement* statement) {
 	if (statement->expression) {
-		return ExpressionString(statement->expression);
+		AppendExpressionString(out, statement->expression);
 	}
-	return MonkeyStrdup("");
 }
 
-BlockStatement* CreateBlockStatement(Token token, StatementSpan statements) {
-	BlockStatement* statement = calloc(1, sizeof(BlockStatement));
+char* ExpressionStatementString(const ExpressionStatement* statement) {
+	return StatementString(&statement->base);
+}
+
+BlockStatement* CreateBlockStatement(Arena* arena, Token token, StatementSpan statements) {
+	BlockStatement* statement = ArenaAllocate(arena, sizeof(BlockStatement));
 	initStatement(&statement->base, STATEMENT_TYPE_BLOCK);
 	statement->token = token;
 	statement->statements = statements;
@@ -540,30 +480,17 @@ BlockStatement* CreateBlockStatement(Token token, StatementSpan statements) {
 }
 
 char* BlockStatementTokenLiteral(const BlockStatement* statement) {
-	return MonkeyStrdup(statement->token.literal);
+	return MonkeyStringViewDup(statement->token.literal);
 }
 
-char* BlockStatementString(const BlockStatement* statement) {
-	MonkeyStringBuffer out = BUFFER_INIT;
+MONKEY_FILE_LOCAL void appendBlockStatement(
+		MonkeyStringBuilder* out, const BlockStatement* statement) {
 	for (size_t i = 0; i < statement->statements.length; ++i) {
-		BUFFER_PUSH(&out, StatementString(statement->statements.begin[i]));
-	}
-	char* result = MonkeyStringJoin((MonkeyStringSpan)BUFFER_AS_SPAN(out));
-	for (size_t i = 0; i < out.length; ++i) {
-		free(out.data[i]);
+		AppendStatementString(out, statement->statements.begin[i]);
 	}
-	BUFFER_FREE(out);
-	return result;
 }
 
-void DestroyBlockStatement(BlockStatement* statement) {
-	if (statement == NULL) {
-		return;
-	}
-	DestroyToken(&statement->token);
-	for (size_t i = 0; i < statement->statements.length; ++i) {
-		destroyStatement(statement->statements.begin[i]);
-	}
-	free(statement->statements.begin);
-	free(statement);
+char* BlockStatementString(const BlockStatement* statement) {
+	return StatementString(&statement->base);
 }
+
@@ -1,10 +1,14 @@
 #pragma once
 
 #include "buffer.h"
+#include "monkey/arena.h"
+#include "monkey/string.h"
+#include "monkey/symbol.h"
 #include "monkey/token.h"
 #include "span.h"
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #define NODE_TYPES_X \
@@ -41,6 +45,11 @@ typedef struct {
 
 char* StatementTokenLiteral(const Statement* statement);
 char* StatementString(const Statement* statement);
+/**
+ * @brief Appends what StatementString returns to a builder, so that nested nodes are printed
+ * without a string of their own.
+ */
+void AppendStatementString(MonkeyStringBuilder* out, const Statement* statement);
 
 #define EXPRESSION_TYPES_X \
 	X(IDENTIFIER) \
@@ -58,6 +67,42 @@ typedef enum {
 #undef X
 } ExpressionType;
 
+/**
+ * @brief OPERATORS_X is a list of all the prefix and infix operators, along with their source
+ * text. Names match the token types they are parsed from.
+ */
+#define OPERATORS_X \
+	X(PLUS, "+") \
+	X(MINUS, "-") \
+	X(BANG, "!") \
+	X(ASTERISK, "*") \
+	X(SLASH, "/") \
+	X(LT, "<") \
+	X(GT, ">") \
+	X(EQ, "==") \
+	X(NOT_EQ, "!=")
+
+/**
+ * @brief Operator is the kind of a prefix or infix expression, resolved by the parser so that
+ * later passes can dispatch on it without comparing strings.
+ */
+typedef enum {
+#define X(name, string) OPERATOR_##name,
+	OPERATORS_X
+#undef X
+} Operator;
+
+/**
+ * @brief Returns the source text of an operator.
+ */
+const char* OperatorText(Operator op);
+
+/**
+ * @brief Applies an arithmetic operator to two integers, the way both engines and the optimizer
+ * do. Returns false where the result would overflow or the division would trap.
+ */
+bool ApplyIntegerOperator(Operator op, int64_t left, int64_t right, int64_t* result);
+
 typedef struct {
 	Node base;
 	ExpressionType type;
@@ -66,31 +111,65 @@ typedef struct {
 typedef BUFFER_TYPE(Expression*) ExpressionBuffer;
 typedef SPAN_TYPE(Expression*) ExpressionSpan;
 
-void DestroyExpression(Expression* expression);
 char* ExpressionString(const Expression* expression);
+/**
+ * @brief Appends what ExpressionString returns to a builder.
+ */
+void AppendExpressionString(MonkeyStringBuilder* out, const Expression* expression);
 
 typedef SPAN_TYPE(Statement*) StatementSpan;
 
 typedef struct {
 	Node base;
 	StatementSpan statements;
+	/**
+	 * @brief arena holds every node of the program, along with the arrays behind its spans.
+	 */
+	Arena* arena;
 } Program;
 
-Program* CreateProgram(StatementSpan statements);
+Program* CreateProgram(Arena* arena, StatementSpan statements);
 char* ProgramTokenLiteral(const Program* program);
 char* ProgramString(const Program* program);
+/**
+ * @brief Destroy a program, dropping its reference to the arena its nodes live in.
+ */
 void DestroyProgram(Program* program);
 
+/**
+ * @brief IdentifierScope says where the resolver found the variable an identifier refers to.
+ */
+typedef enum {
+	/**
+	 * @brief IDENTIFIER_SCOPE_GLOBAL variables are looked up by name at run time.
+	 */
+	IDENTIFIER_SCOPE_GLOBAL,
+	/**
+	 * @brief IDENTIFIER_SCOPE_LOCAL variables are parameters or locals of an enclosing function.
+	 */
+	IDENTIFIER_SCOPE_LOCAL,
+} IdentifierScope;
+
 typedef struct {
 	Expression base;
 	Token token;
-	char* value;
+	MonkeyStringView value;
+	/**
+	 * @brief symbol is the interned name, taken from the token. Variables are keyed by it.
+	 */
+	const MonkeySymbol* symbol;
+	/**
+	 * @brief scope, depth and slot are filled in by ResolveProgram. depth counts the function
+	 * scopes between the identifier and its variable, and slot indexes that scope.
+	 */
+	IdentifierScope scope;
+	size_t depth;
+	size_t slot;
 } Identifier;
 
-Identifier* CreateIdentifier(Token token, char* value);
+Identifier* CreateIdentifier(Arena* arena, Token token, MonkeyStringView value);
 char* IdentifierTokenLiteral(const Identifier* identifier);
 char* IdentifierString(const Identifier* identifier);
-void DestroyIdentifier(Identifier* identifier);
 
 typedef BUFFER_TYPE(Identifier*) IdentifierBuffer;
 typedef SPAN_TYPE(Identifier*) IdentifierSpan;
@@ -101,10 +180,9 @@ typedef struct {
 	int64_t value;
 } IntegerLiteral;
 
-IntegerLiteral* CreateIntegerLiteral(Token token, int64_t value);
+IntegerLiteral* CreateIntegerLiteral(Arena* arena, Token token, int64_t value);
 char* IntegerLiteralTokenLiteral(const IntegerLiteral* integerLiteral);
 char* IntegerLiteralString(const IntegerLiteral* integerLiteral);
-void DestroyIntegerLiteral(IntegerLiteral* integerLiteral);
 
 typedef struct {
 	Expression base;
@@ -112,35 +190,33 @@ typedef struct {
 	bool value;
 } BooleanLiteral;
 
-BooleanLiteral* CreateBooleanLiteral(Token token, int64_t value);
+BooleanLiteral* CreateBooleanLiteral(Arena* arena, Token token, int64_t value);
 char* BooleanLiteralTokenLiteral(const BooleanLiteral* booleanLiteral);
 char* BooleanLiteralString(const BooleanLiteral* booleanLiteral);
-void DestroyBooleanLiteral(BooleanLiteral* booleanLiteral);
 
 typedef struct {
 	Expression base;
 	Token token;
-	char* op;
+	Operator op;
 	Expression* right;
 } PrefixExpression;
 
-PrefixExpression* CreatePrefixExpression(Token token, char* op, Expression* right);
+PrefixExpression* CreatePrefixExpression(Arena* arena, Token token, Operator op, Expression* right);
 char* PrefixExpressionTokenLiteral(const PrefixExpression* prefix);
 char* PrefixExpressionString(const PrefixExpression* prefix);
-void DestroyPrefixExpression(PrefixExpression* prefix);
 
 typedef struct {
 	Expression base;
 	Token token;
 	Expression* left;
-	char* op;
+	Operator op;
 	Expression* right;
 } InfixExpression;
 
-InfixExpression* CreateInfixExpression(Token token, Expression* left, char* op, Expression* right);
+InfixExpression* CreateInfixExpression(
+		Arena* arena, Token token, Expression* left, Operator op, Expression* right);
 char* InfixExpressionTokenLiteral(const InfixExpression* infix);
 char* InfixExpressionString(const InfixExpression* infix);
-void DestroyInfixExpression(InfixExpression* infix);
 
 struct BlockStatement;
 
@@ -152,36 +228,63 @@ typedef struct {
 	struct BlockStatement* alternative;
 } IfExpression;
 
-IfExpression* CreateIfExpression(Token token, Expression* condition,
+IfExpression* CreateIfExpression(Arena* arena, Token token, Expression* condition,
 		struct BlockStatement* consequence, struct BlockStatement* alternative);
 char* IfExpressionTokenLiteral(const IfExpression* exp);
 char* IfExpressionString(const IfExpression* exp);
-void DestroyIfExpression(IfExpression* exp);
 
 typedef struct {
 	Expression base;
 	Token token;
 	IdentifierSpan parameters;
 	struct BlockStatement* body;
+	/**
+	 * @brief slotCount is the number of parameters and locals, filled in by ResolveProgram.
+	 */
+	size_t slotCount;
+	/**
+	 * @brief arena is the arena the literal lives in, which function values retain.
+	 */
+	Arena* arena;
 } FunctionLiteral;
 
 FunctionLiteral* CreateFunctionLiteral(
-		Token token, IdentifierSpan parameters, struct BlockStatement* body);
+		Arena* arena, Token token, IdentifierSpan parameters, struct BlockStatement* body);
 char* FunctionLiteralTokenLiteral(const FunctionLiteral* exp);
 char* FunctionLiteralString(const FunctionLiteral* exp);
-void DestroyFunctionLiteral(FunctionLiteral* exp);
+
+// avoid cyclic includes with monkey/object.h and monkey/environment.h here
+struct Object;
+struct Environment;
+
+/**
+ * @brief CallCache is the inline cache of a call whose function is a global name. It remembers
+ * what the name was bound to in a name-keyed scope at some version of it (see
+ * GetEnvironmentVersion), and only ever holds functions that take the call's number of arguments.
+ */
+typedef struct {
+	const struct Environment* scope;
+	uint64_t version;
+	struct Object* function;
+} CallCache;
 
 typedef struct {
 	Expression base;
 	Token token;
 	Expression* function;
 	ExpressionSpan arguments;
+	/**
+	 * @brief tail is set by ResolveProgram on calls whose value the enclosing function returns as
+	 * it is, which the evaluator makes without nesting another call on the C stack.
+	 */
+	bool tail;
+	CallCache cache;
 } CallExpression;
 
-CallExpression* CreateCallExpression(Token token, Expression* function, ExpressionSpan arguments);
+CallExpression* CreateCallExpression(
+		Arena* arena, Token token, Expression* function, ExpressionSpan arguments);
 char* CallExpressionTokenLiteral(const CallExpression* exp);
 char* CallExpressionString(const CallExpression* exp);
-void DestroyCallExpression(CallExpression* exp);
 
 typedef struct {
 	Statement base;
@@ -190,7 +293,8 @@ typedef struct {
 	Expression* value;
 } LetStatement;
 
-LetStatement* CreateLetStatement(Token token, Identifier* identifier, Expression* value);
+LetStatement* CreateLetStatement(
+		Arena* arena, Token token, Identifier* identifier, Expression* value);
 char* LetStatementTokenLiteral(const LetStatement* statement);
 char* LetStatementString(const LetStatement* statement);
 
@@ -200,7 +304,7 @@ typedef struct {
 	Expression* returnValue;
 } ReturnStatement;
 
-ReturnStatement* CreateReturnStatement(Token token, Expression* returnValue);
+ReturnStatement* CreateReturnStatement(Arena* arena, Token token, Expression* returnValue);
 char* ReturnStatementTokenLiteral(const ReturnStatement* statement);
 char* ReturnStatementString(const ReturnStatement* statement);
 
@@ -210,7 +314,7 @@ typedef struct {
 	Expression* expression;
 } ExpressionStatement;
 
-ExpressionStatement* CreateExpressionStatement(Token token, Expression* expression);
+ExpressionStatement* CreateExpressionStatement(Arena* arena, Token token, Expression* expression);
 char* ExpressionStatementTokenLiteral(const ExpressionStatement* statement);
 char* ExpressionStatementString(const ExpressionStatement* statement);
 
@@ -220,7 +324,6 @@ typedef struct BlockStatement {
 	StatementSpan statements;
 } BlockStatement;
 
-BlockStatement* CreateBlockStatement(Token token, StatementSpan statements);
+BlockStatement* CreateBlockStatement(Arena* arena, Token token, StatementSpan statements);
 char* BlockStatementTokenLiteral(const BlockStatement* statement);
 char* BlockStatementString(const BlockStatement* statement);
-void DestroyBlockStatement(BlockStatement* statement);
@@ -0,0 +1,99 @@
+#include "monkey/code.h"
+
+#include "buffer.h"
+#include "monkey/macros.h"
+#include "monkey/string.h"
+#include "span.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+MONKEY_FILE_LOCAL const OpcodeDefinition DEFINITIONS[] = {
+#define X(name, width0, width1) \
+	{#name, (width0 != 0) + (width1 != 0), {width0, width1}},
+		OPCODES_X
+#undef X
+};
+
+const OpcodeDefinition* LookupOpcode(Opcode op) {
+	assert((size_t)op < sizeof DEFINITIONS / sizeof DEFINITIONS[0]);
+	return &DEFINITIONS[op];
+}
+
+size_t InstructionWidth(Opcode op) {
+	const OpcodeDefinition* def = LookupOpcode(op);
+	size_t width = 1;
+	for (size_t i = 0; i < def->operandCount; ++i) {
+		width += def->operandWidths[i];
+	}
+	return width;
+}
+
+MONKEY_FILE_LOCAL void writeOperand(uint8_t* ins, size_t width, uint32_t operand) {
+	for (size_t i = 0; i < width; ++i) {
+		ins[i] = (uint8_t)(operand >> (8U * (width - i - 1)));
+	}
+}
+
+uint32_t ReadOperand(const uint8_t* ins, size_t width) {
+	uint32_t operand = 0;
+	for (size_t i = 0; i < width; ++i) {
+		operand = (operand << 8U) | ins[i];
+	}
+	return operand;
+}
+
+size_t EmitInstruction(
+		Instructions* instructions, Opcode op, uint32_t operand0, uint32_t operand1) {
+	size_t position = instructions->length;
+	size_t width = InstructionWidth(op);
+	for (size_t i = 0; i < width; ++i) {
+		BUFFER_PUSH(instructions, 0);
+	}
+	instructions->data[position] = (uint8_t)op;
+	ReplaceOperands(instructions, position, operand0, operand1);
+	return position;
+}
+
+void ReplaceOperands(
+		Instructions* instructions, size_t position, uint32_t operand0, uint32_t operand1) {
+	const OpcodeDefinition* def = LookupOpcode((Opcode)instructions->data[position]);
+	uint32_t operands[OPCODE_MAX_OPERANDS] = {operand0, operand1};
+	size_t offset = position + 1;
+	for (size_t i = 0; i < def->operandCount; ++i) {
+		writeOperand(instructions->data + offset, def->operandWidths[i], operands[i]);
+		offset += def->operandWidths[i];
+	}
+}
+
+char* InstructionsString(InstructionSpan instructions) {
+	MonkeyStringBuilder out = BUFFER_INIT;
+	size_t position = 0;
+	while (position < instructions.length) {
+		const OpcodeDefinition* def = LookupOpcode((Opcode)instructions.begin[position]);
+		size_t offset = position + 1;
+		uint32_t operands[OPCODE_MAX_OPERANDS] = {0, 0};
+		for (size_t i = 0; i < def->operandCount; ++i) {
+			operands[i] = ReadOperand(instructions.begin + offset, def->operandWidths[i]);
+			offset += def->operandWidths[i];
+		}
+		switch (def->operandCount) {
+			case 0:
+				MonkeyStringBuilderAppendFormat(&out, "%04zu %s\n", position, def->name);
+				break;
+			case 1:
+				MonkeyStringBuilderAppendFormat(
+						&out, "%04zu %s %u\n", position, def->name, operands[0]);
+				break;
+			default:
+				MonkeyStringBuilderAppendFormat(&out, "%04zu %s %u %u\n", position, def->name,
+						operands[0], operands[1]);
+				break;
+		}
+		position = offset;
+	}
+	return MonkeyStringBuilderFinish(&out);
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "buffer.h"
+#include "span.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief OPCODES_X is a list of all the opcodes understood by the virtual machine, along with the
+ * byte widths of their (up to two) operands. A width of 0 means the operand is absent.
+ *
+ * Operands are stored big-endian directly after the opcode byte.
+ */
+#define OPCODES_X \
+	X(CONSTANT, 2, 0) \
+	X(POP, 0, 0) \
+	X(ADD, 0, 0) \
+	X(SUB, 0, 0) \
+	X(MUL, 0, 0) \
+	X(DIV, 0, 0) \
+	X(TRUE, 0, 0) \
+	X(FALSE, 0, 0) \
+	X(NULL, 0, 0) \
+	X(EQUAL, 0, 0) \
+	X(NOT_EQUAL, 0, 0) \
+	X(LESS_THAN, 0, 0) \
+	X(GREATER_THAN, 0, 0) \
+	X(MINUS, 0, 0) \
+	X(BANG, 0, 0) \
+	X(JUMP_NOT_TRUTHY, 2, 0) \
+	X(JUMP, 2, 0) \
+	X(GET_GLOBAL, 2, 0) \
+	X(SET_GLOBAL, 2, 0) \
+	X(GET_LOCAL, 1, 0) \
+	X(SET_LOCAL, 1, 0) \
+	X(GET_FREE, 1, 0) \
+	X(CURRENT_CLOSURE, 0, 0) \
+	X(CLOSURE, 2, 1) \
+	X(CALL, 1, 0) \
+	X(RETURN_VALUE, 0, 0) \
+	X(RETURN, 0, 0)
+
+/**
+ * @brief Opcode is an enumeration of all the instructions of the virtual machine.
+ */
+typedef enum {
+#define X(name, width0, width1) OPCODE_##name,
+	OPCODES_X
+#undef X
+} Opcode;
+
+#define OPCODE_MAX_OPERANDS 2
+
+/**
+ * @brief OpcodeDefinition describes the name and operand layout of an opcode.
+ */
+typedef struct {
+	const char* name;
+	size_t operandCount;
+	size_t operandWidths[OPCODE_MAX_OPERANDS];
+} OpcodeDefinition;
+
+/**
+ * @brief Instructions is a growable stream of encoded instructions.
+ */
+typedef BUFFER_TYPE(uint8_t) Instructions;
+
+/**
+ * @brief InstructionSpan is a view of encoded instructions.
+ */
+typedef SPAN_TYPE(uint8_t) InstructionSpan;
+
+/**
+ * @brief Returns the definition of the given opcode.
+ */
+const OpcodeDefinition* LookupOpcode(Opcode op);
+
+/**
+ * @brief Returns the encoded size in bytes of an instruction with the given opcode.
+ */
+size_t InstructionWidth(Opcode op);
+
+/**
+ * @brief Appends an encoded instruction to the stream. Operands the opcode does not take are
+ * ignored.
+ *
+ * @param instructions The stream to append to.
+ * @param op The opcode.
+ * @param operand0 The first operand.
+ * @param operand1 The second operand.
+ * @return The position of the new instruction in the stream.
+ */
+size_t EmitInstruction(Instructions* instructions, Opcode op, uint32_t operand0, uint32_t operand1);
+
+/**
+ * @brief Overwrites the operands of the instruction at the given position.
+ */
+void ReplaceOperands(
+		Instructions* instructions, size_t position, uint32_t operand0, uint32_t operand1);
+
+/**
+ * @brief Reads a big-endian operand of the given width.
+ */
+uint32_t ReadOperand(const uint8_t* ins, size_t width);
+
+/**
+ * @brief Reads a two-byte operand. The virtual machine decodes every operand inline, with this
+ * for the wide ones, rather than calling ReadOperand.
+ */
+static inline uint32_t ReadWideOperand(const uint8_t* ins) {
+	return ((uint32_t)ins[0] << 8U) | ins[1];
+}
+
+/**
+ * @brief Disassembles instructions into a human-readable listing, one instruction per line.
+ *
+ * @param instructions The instructions to disassemble.
+ * @return A new string.
+ */
+char* InstructionsString(InstructionSpan instructions);
@@ -0,0 +1,602 @@
+#include "monkey/compiler.h"
+
+#include "buffer.h"
+#include "monkey.h"
+#include "monkey/ast.h"
+#include "monkey/code.h"
+#include "monkey/heap.h"
+#include "monkey/macros.h"
+#include "monkey/object.h"
+#include "monkey/string.h"
+#include "monkey/symbol.h"
+#include "span.h"
+
+#include <assert.h>
+#include <glib.h>
+#include <hedley.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_CONSTANTS UINT16_MAX
+#define MAX_GLOBALS UINT16_MAX
+#define MAX_LOCALS UINT8_MAX
+#define MAX_ARGUMENTS UINT8_MAX
+
+#define SYMBOL_SCOPES_X \
+	X(GLOBAL) \
+	X(LOCAL) \
+	X(FREE) \
+	X(FUNCTION)
+
+typedef enum {
+#define X(name) SYMBOL_SCOPE_##name,
+	SYMBOL_SCOPES_X
+#undef X
+} SymbolScope;
+
+typedef struct {
+	const MonkeySymbol* name;
+	SymbolScope scope;
+	size_t index;
+} Symbol;
+
+typedef BUFFER_TYPE(Symbol) SymbolBuffer;
+
+typedef struct SymbolTable {
+	struct SymbolTable* outer;
+	/**
+	 * @brief store maps interned names to symbols, comparing them by pointer.
+	 */
+	GHashTable* store;
+	/**
+	 * @brief symbols owns every symbol of the table, in definition order.
+	 */
+	BUFFER_TYPE(Symbol*) symbols;
+	size_t numDefinitions;
+	/**
+	 * @brief freeSymbols are the symbols of enclosing scopes captured by this one, in order.
+	 */
+	SymbolBuffer freeSymbols;
+} SymbolTable;
+
+MONKEY_FILE_LOCAL SymbolTable* createSymbolTable(SymbolTable* outer) {
+	SymbolTable* table = calloc(1, sizeof(SymbolTable));
+	table->outer = outer;
+	table->store = g_hash_table_new(g_direct_hash, g_direct_equal);
+	return table;
+}
+
+MONKEY_FILE_LOCAL void destroySymbolTable(SymbolTable* table) {
+	g_hash_table_destroy(table->store);
+	for (size_t i = 0; i < table->symbols.length; ++i) {
+		free(table->symbols.data[i]);
+	}
+	BUFFER_FREE(table->symbols);
+	BUFFER_FREE(table->freeSymbols);
+	free(table);
+}
+
+MONKEY_FILE_LOCAL Symbol* addSymbol(
+		SymbolTable* table, const MonkeySymbol* name, SymbolScope scope, size_t index) {
+	Symbol* symbol = malloc(sizeof(Symbol));
+	symbol->name = name;
+	symbol->scope = scope;
+	symbol->index = index;
+	BUFFER_PUSH(&table->symbols, symbol);
+	g_hash_table_insert(table->store, HEDLEY_CONST_CAST(MonkeySymbol*, name), symbol);
+	return symbol;
+}
+
+MONKEY_FILE_LOCAL Symbol* defineSymbol(SymbolTable* table, const MonkeySymbol* name) {
+	SymbolScope scope = table->outer == NULL ? SYMBOL_SCOPE_GLOBAL : SYMBOL_SCOPE_LOCAL;
+	Symbol* existing = g_hash_table_lookup(table->store, name);
+	if (existing != NULL && existing->scope == scope) {
+		// re-binding a name reuses its slot
+		return existing;
+	}
+	return addSymbol(table, name, scope, table->numDefinitions++);
+}
+
+/**
+ * @private
+ *
+ * Gives a parameter a local of its own, even one named like an earlier parameter. Arguments land
+ * in their locals in order and the name refers to the last of them, as in the evaluator.
+ */
+MONKEY_FILE_LOCAL Symbol* defineParameter(SymbolTable* table, const MonkeySymbol* name) {
+	return addSymbol(table, name, SYMBOL_SCOPE_LOCAL, table->numDefinitions++);
+}
+
+MONKEY_FILE_LOCAL Symbol* defineFunctionName(SymbolTable* table, const MonkeySymbol* name) {
+	return addSymbol(table, name, SYMBOL_SCOPE_FUNCTION, 0);
+}
+
+MONKEY_FILE_LOCAL Symbol* defineFree(SymbolTable* table, const Symbol* original) {
+	BUFFER_PUSH(&table->freeSymbols, *original);
+	return addSymbol(table, original->name, SYMBOL_SCOPE_FREE, table->freeSymbols.length - 1);
+}
+
+MONKEY_FILE_LOCAL Symbol* resolveSymbol(SymbolTable* table, const MonkeySymbol* name) {
+	Symbol* symbol = g_hash_table_lookup(table->store, name);
+	if (symbol != NULL || table->outer == NULL) {
+		return symbol;
+	}
+	symbol = resolveSymbol(table->outer, name);
+	if (symbol == NULL || symbol->scope == SYMBOL_SCOPE_GLOBAL) {
+		return symbol;
+	}
+	return defineFree(table, symbol);
+}
+
+typedef struct {
+	Opcode opcode;
+	size_t position;
+} EmittedInstruction;
+
+typedef struct {
+	Instructions instructions;
+	EmittedInstruction last;
+	EmittedInstruction previous;
+} CompilationScope;
+
+typedef BUFFER_TYPE(Object*) ObjectBuffer;
+
+struct Compiler {
+	Monkey* monkey;
+	ObjectBuffer constants;
+	/**
+	 * @brief immediates maps each immediate constant to its index plus one, so that a literal
+	 * repeated across a program or a REPL session takes one entry.
+	 */
+	GHashTable* immediates;
+	MonkeyStringBuffer globalNames;
+	SymbolTable* symbols;
+	BUFFER_TYPE(CompilationScope) scopes;
+	MonkeyStringBuffer errors;
+};
+
+MONKEY_FILE_LOCAL bool compileStatement(Compiler* compiler, Statement* statement);
+MONKEY_FILE_LOCAL bool compileExpression(Compiler* compiler, Expression* expression);
+
+MONKEY_FILE_LOCAL CompilationScope* currentScope(Compiler* compiler) {
+	return &compiler->scopes.data[compiler->scopes.length - 1];
+}
+
+MONKEY_FILE_LOCAL bool HEDLEY_PRINTF_FORMAT(2, 3)
+		compileError(Compiler* compiler, const char* format, ...) {
+	va_list args;
+	va_start(args, format);
+	BUFFER_PUSH(&compiler->errors, MonkeyAvsprintf(format, args));
+	va_end(args);
+	return false;
+}
+
+MONKEY_FILE_LOCAL size_t emit(Compiler* compiler, Opcode op, uint32_t operand0, uint32_t operand1) {
+	CompilationScope* scope = currentScope(compiler);
+	size_t position = EmitInstruction(&scope->instructions, op, operand0, operand1);
+	scope->previous = scope->last;
+	scope->last = (EmittedInstruction){op, position};
+	return position;
+}
+
+MONKEY_FILE_LOCAL bool lastInstructionIs(Compiler* compiler, Opcode op) {
+	CompilationScope* scope = currentScope(compiler);
+	return scope->instructions.length > 0 && scope->last.opcode == op;
+}
+
+MONKEY_FILE_LOCAL void removeLastPop(Compiler* compiler) {
+	CompilationScope* scope = currentScope(compiler);
+	scope->instructions.length = scope->last.position;
+	scope->last = scope->previous;
+}
+
+MONKEY_FILE_LOCAL void replaceLastPopWithReturn(Compiler* compiler) {
+	CompilationScope* scope = currentScope(compiler);
+	scope->instructions.data[scope->last.position] = OPCODE_RETURN_VALUE;
+	scope->last.opcode = OPCODE_RETURN_VALUE;
+}
+
+MONKEY_FILE_LOCAL bool addConstant(Compiler* compiler, Object* obj, uint32_t* outIndex) {
+	if (compiler->constants.length >= MAX_CONSTANTS) {
+		return compileError(compiler, "too many constants");
+	}
+	BUFFER_PUSH(&compiler->constants, obj);
+	*outIndex = (uint32_t)(compiler->constants.length - 1);
+	return true;
+}
+
+/**
+ * @private
+ *
+ * Adds a constant unless an equal one is in the pool already. Only immediates are shared, since
+ * they are equal exactly when their pointers are.
+ */
+MONKEY_FILE_LOCAL bool addSharedConstant(Compiler* compiler, Object* obj, uint32_t* outIndex) {
+	if (!IsImmediateObject(obj)) {
+		return addConstant(compiler, obj, outIndex);
+	}
+	uint32_t existing = GPOINTER_TO_UINT(g_hash_table_lookup(compiler->immediates, obj));
+	if (existing != 0) {
+		*outIndex = existing - 1;
+		return true;
+	}
+	if (!addConstant(compiler, obj, outIndex)) {
+		return false;
+	}
+	g_hash_table_insert(compiler->immediates, obj, GUINT_TO_POINTER(*outIndex + 1));
+	return true;
+}
+
+MONKEY_FILE_LOCAL void enterScope(Compiler* compiler) {
+	CompilationScope scope = {BUFFER_INIT, {OPCODE_POP, 0}, {OPCODE_POP, 0}};
+	BUFFER_PUSH(&compiler->scopes, scope);
+	compiler->symbols = createSymbolTable(compiler->symbols);
+}
+
+MONKEY_FILE_LOCAL Instructions leaveScope(Compiler* compiler) {
+	Instructions instructions = currentScope(compiler)->instructions;
+	compiler->scopes.length--;
+	SymbolTable* outer = compiler->symbols->outer;
+	destroySymbolTable(compiler->symbols);
+	compiler->symbols = outer;
+	return instructions;
+}
+
+MONKEY_FILE_LOCAL void loadSymbol(Compiler* compiler, const Symbol* symbol) {
+	switch (symbol->scope) {
+		case SYMBOL_SCOPE_GLOBAL:
+			emit(compiler, OPCODE_GET_GLOBAL, (uint32_t)symbol->index, 0);
+			return;
+		case SYMBOL_SCOPE_LOCAL:
+			emit(compiler, OPCODE_GET_LOCAL, (uint32_t)symbol->index, 0);
+			return;
+		case SYMBOL_SCOPE_FREE:
+			emit(compiler, OPCODE_GET_FREE, (uint32_t)symbol->index, 0);
+			return;
+		case SYMBOL_SCOPE_FUNCTION:
+			emit(compiler, OPCODE_CURRENT_CLOSURE, 0, 0);
+			return;
+	}
+	(void)fprintf(stderr, "Unknown symbol scope: %d\n", symbol->scope);
+	assert(false);
+}
+
+MONKEY_FILE_LOCAL bool defineVariable(Compiler* compiler, const MonkeySymbol* name) {
+	size_t count = compiler->symbols->numDefinitions;
+	Symbol* symbol = defineSymbol(compiler->symbols, name);
+	bool global = symbol->scope == SYMBOL_SCOPE_GLOBAL;
+	if (symbol->index >= (global ? MAX_GLOBALS : MAX_LOCALS)) {
+		return compileError(compiler, "too many variables");
+	}
+	if (global && compiler->symbols->numDefinitions > count) {
+		BUFFER_PUSH(&compiler->globalNames, MonkeyStringViewDup(name->name));
+	}
+	emit(compiler, global ? OPCODE_SET_GLOBAL : OPCODE_SET_LOCAL, (uint32_t)symbol->index, 0);
+	return true;
+}
+
+MONKEY_FILE_LOCAL bool compileBlockStatements(Compiler* compiler, StatementSpan statements) {
+	for (size_t i = 0; i < statements.length; ++i) {
+		if (!compileStatement(compiler, statements.begin[i])) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * @private
+ *
+ * Compiles a block so that it leaves exactly one value on the stack: the value of its last
+ * expression statement, or null.
+ */
+MONKEY_FILE_LOCAL bool compileBlockValue(Compiler* compiler, BlockStatement* block) {
+	if (!compileBlockStatements(compiler, block->statements)) {
+		return false;
+	}
+	if (lastInstructionIs(compiler, OPCODE_POP)) {
+		removeLastPop(compiler);
+	} else {
+		emit(compiler, OPCODE_NULL, 0, 0);
+	}
+	return true;
+}
+
+MONKEY_FILE_LOCAL MonkeyStringSpan localNames(SymbolTable* table) {
+	char** names = calloc(table->numDefinitions, sizeof(char*));
+	for (size_t i = 0; i < table->symbols.length; ++i) {
+		Symbol* symbol = table->symbols.data[i];
+		if (symbol->scope == SYMBOL_SCOPE_LOCAL && names[symbol->index] == NULL) {
+			names[symbol->index] = MonkeyStringViewDup(symbol->name->name);
+		}
+	}
+	return (MonkeyStringSpan)SPAN_WITH_LENGTH(names, table->numDefinitions);
+}
+
+MONKEY_FILE_LOCAL bool compileFunctionLiteral(
+		Compiler* compiler, FunctionLiteral* func, const Identifier* name) {
+	enterScope(compiler);
+	if (name != NULL) {
+		defineFunctionName(compiler->symbols, name->symbol);
+	}
+	for (size_t i = 0; i < func->parameters.length; ++i) {
+		defineParameter(compiler->symbols, func->parameters.begin[i]->symbol);
+	}
+	if (compiler->symbols->numDefinitions > MAX_LOCALS) {
+		compileError(compiler, "too many parameters");
+		free(leaveScope(compiler).data);
+		return false;
+	}
+
+	if (!compileBlockStatements(compiler, func->body->statements)) {
+		free(leaveScope(compiler).data);
+		return false;
+	}
+	if (lastInstructionIs(compiler, OPCODE_POP)) {
+		replaceLastPopWithReturn(compiler);
+	}
+	if (!lastInstructionIs(compiler, OPCODE_RETURN_VALUE)) {
+		emit(compiler, OPCODE_RETURN, 0, 0);
+	}
+
+	SymbolBuffer freeSymbols = compiler->symbols->freeSymbols;
+	compiler->symbols->freeSymbols = (SymbolBuffer)BUFFER_INIT;
+	MonkeyStringSpan names = localNames(compiler->symbols);
+	Instructions instructions = leaveScope(compiler);
+
+	char* text = InspectFunctionParts(func->parameters, func->body);
+	CompiledFunctionObject* compiled = CreateCompiledFunctionObject(
+			MonkeyGetHeap(compiler->monkey), instructions, func->parameters.length, names, text);
+	uint32_t index;
+	bool ok = addConstant(compiler, &compiled->base, &index);
+	if (ok) {
+		for (size_t i = 0; i < freeSymbols.length; ++i) {
+			loadSymbol(compiler, &freeSymbols.data[i]);
+		}
+		emit(compiler, OPCODE_CLOSURE, index, (uint32_t)freeSymbols.length);
+	}
+	BUFFER_FREE(freeSymbols);
+	return ok;
+}
+
+MONKEY_FILE_LOCAL bool compileInfixExpression(Compiler* compiler, InfixExpression* infix) {
+	if (!compileExpression(compiler, infix->left) || !compileExpression(compiler, infix->right)) {
+		return false;
+	}
+	switch (infix->op) {
+		case OPERATOR_PLUS:
+			emit(compiler, OPCODE_ADD, 0, 0);
+			return true;
+		case OPERATOR_MINUS:
+			emit(compiler, OPCODE_SUB, 0, 0);
+			return true;
+		case OPERATOR_ASTERISK:
+			emit(compiler, OPCODE_MUL, 0, 0);
+			return true;
+		case OPERATOR_SLASH:
+			emit(compiler, OPCODE_DIV, 0, 0);
+			return true;
+		case OPERATOR_LT:
+			emit(compiler, OPCODE_LESS_THAN, 0, 0);
+			return true;
+		case OPERATOR_GT:
+			emit(compiler, OPCODE_GREATER_THAN, 0, 0);
+			return true;
+		case OPERATOR_EQ:
+			emit(compiler, OPCODE_EQUAL, 0, 0);
+			return true;
+		case OPERATOR_NOT_EQ:
+			emit(compiler, OPCODE_NOT_EQUAL, 0, 0);
+			return true;
+		case OPERATOR_BANG:
+			break;
+	}
+	return compileError(compiler, "unknown operator: %s", OperatorText(infix->op));
+}
+
+MONKEY_FILE_LOCAL bool compileIfExpression(Compiler* compiler, IfExpression* exp) {
+	if (!compileExpression(compiler, exp->condition)) {
+		return false;
+	}
+	size_t jumpNotTruthy = emit(compiler, OPCODE_JUMP_NOT_TRUTHY, 0, 0);
+	if (!compileBlockValue(compiler, exp->consequence)) {
+		return false;
+	}
+	size_t jump = emit(compiler, OPCODE_JUMP, 0, 0);
+
+	Instructions* instructions = &currentScope(compiler)->instructions;
+	ReplaceOperands(instructions, jumpNotTruthy, (uint32_t)instructions->length, 0);
+	if (exp->alternative == NULL) {
+		emit(compiler, OPCODE_NULL, 0, 0);
+	} else if (!compileBlockValue(compiler, exp->alternative)) {
+		return false;
+	}
+	instructions = &currentScope(compiler)->instructions;
+	if (instructions->length > UINT16_MAX) {
+		return compileError(compiler, "jump target out of range");
+	}
+	ReplaceOperands(instructions, jump, (uint32_t)instructions->length, 0);
+	return true;
+}
+
+MONKEY_FILE_LOCAL bool compileExpression(Compiler* compiler, Expression* expression) {
+	if (expression == NULL) {
+		// the parser already reported why
+		return compileError(compiler, "missing expression");
+	}
+	switch (expression->type) {
+		case EXPRESSION_TYPE_INTEGER_LITERAL: {
+			IntegerLiteral* lit = (IntegerLiteral*)expression;
+			uint32_t index;
+			Object* value = IntegerToObject(MonkeyGetHeap(compiler->monkey), lit->value);
+			if (!addSharedConstant(compiler, value, &index)) {
+				return false;
+			}
+			emit(compiler, OPCODE_CONSTANT, index, 0);
+			return true;
+		}
+		case EXPRESSION_TYPE_BOOLEAN_LITERAL: {
+			BooleanLiteral* lit = (BooleanLiteral*)expression;
+			emit(compiler, lit->value ? OPCODE_TRUE : OPCODE_FALSE, 0, 0);
+			return true;
+		}
+		case EXPRESSION_TYPE_PREFIX: {
+			PrefixExpression* prefix = (PrefixExpression*)expression;
+			if (!compileExpression(compiler, prefix->right)) {
+				return false;
+			}
+			switch (prefix->op) {
+				case OPERATOR_BANG:
+					emit(compiler, OPCODE_BANG, 0, 0);
+					return true;
+				case OPERATOR_MINUS:
+					emit(compiler, OPCODE_MINUS, 0, 0);
+					return true;
+				default:
+					break;
+			}
+			return compileError(compiler, "unknown operator: %s", OperatorText(prefix->op));
+		}
+		case EXPRESSION_TYPE_INFIX:
+			return compileInfixExpression(compiler, (InfixExpression*)expression);
+		case EXPRESSION_TYPE_IF:
+			return compileIfExpression(compiler, (IfExpression*)expression);
+		case EXPRESSION_TYPE_IDENTIFIER: {
+			Identifier* identifier = (Identifier*)expression;
+			Symbol* symbol = resolveSymbol(compiler->symbols, identifier->symbol);
+			if (symbol == NULL) {
+				return compileError(compiler, "identifier not found: %.*s",
+						(int)identifier->value.length, identifier->value.begin);
+			}
+			loadSymbol(compiler, symbol);
+			return true;
+		}
+		case EXPRESSION_TYPE_FUNCTION_LITERAL:
+			return compileFunctionLiteral(compiler, (FunctionLiteral*)expression, NULL);
+		case EXPRESSION_TYPE_CALL: {
+			CallExpression* call = (CallExpression*)expression;
+			if (call->arguments.length > MAX_ARGUMENTS) {
+				return compileError(compiler, "too many arguments");
+			}
+			if (!compileExpression(compiler, call->function)) {
+				return false;
+			}
+			for (size_t i = 0; i < call->arguments.length; ++i) {
+				if (!compileExpression(compiler, call->arguments.begin[i])) {
+					return false;
+				}
+			}
+			emit(compiler, OPCODE_CALL, (uint32_t)call->arguments.length, 0);
+			return true;
+		}
+	}
+	(void)fprintf(stderr, "Unknown expression type: %d\n", expression->type);
+	assert(false);
+	return false;
+}
+
+MONKEY_FILE_LOCAL bool compileStatement(Compiler* compiler, Statement* statement) {
+	switch (statement->type) {
+		case STATEMENT_TYPE_EXPRESSION:
+			if (!compileExpression(compiler, ((ExpressionStatement*)statement)->expression)) {
+				return false;
+			}
+			emit(compiler, OPCODE_POP, 0, 0);
+			return true;
+		case STATEMENT_TYPE_RETURN:
+			if (!compileExpression(compiler, ((ReturnStatement*)statement)->returnValue)) {
+				return false;
+			}
+			emit(compiler, OPCODE_RETURN_VALUE, 0, 0);
+			return true;
+		case STATEMENT_TYPE_LET: {
+			LetStatement* let = (LetStatement*)statement;
+			bool ok = let->value != NULL && let->value->type == EXPRESSION_TYPE_FUNCTION_LITERAL
+					? compileFunctionLiteral(
+							  compiler, (FunctionLiteral*)let->value, let->identifier)
+					: compileExpression(compiler, let->value);
+			return ok && defineVariable(compiler, let->identifier->symbol);
+		}
+		case STATEMENT_TYPE_BLOCK:
+			return compileBlockStatements(compiler, ((BlockStatement*)statement)->statements);
+	}
+	(void)fprintf(stderr, "Unknown statement type: %d\n", statement->type);
+	assert(false);
+	return false;
+}
+
+MONKEY_FILE_LOCAL void traceCompiler(Heap* heap, void* context) {
+	Compiler* compiler = context;
+	for (size_t i = 0; i < compiler->constants.length; ++i) {
+		HeapMark(heap, compiler->constants.data[i]);
+	}
+}
+
+Compiler* CreateCompiler(Monkey* monkey) {
+	Compiler* compiler = calloc(1, sizeof(Compiler));
+	compiler->monkey = monkey;
+	compiler->immediates = g_hash_table_new(g_direct_hash, g_direct_equal);
+	enterScope(compiler);
+	HeapAddTracer(MonkeyGetHeap(monkey), traceCompiler, compiler);
+	return compiler;
+}
+
+MONKEY_FILE_LOCAL void clearErrors(Compiler* compiler) {
+	for (size_t i = 0; i < compiler->errors.length; i++) {
+		free(compiler->errors.data[i]);
+	}
+	compiler->errors.length = 0;
+}
+
+bool Compile(Compiler* compiler, Program* program) {
+	clearErrors(compiler);
+	currentScope(compiler)->instructions.length = 0;
+
+	for (size_t i = 0; i < program->statements.length; ++i) {
+		Statement* statement = program->statements.begin[i];
+		if (!compileStatement(compiler, statement)) {
+			// nested functions may have moved the scopes, so the main one is looked up again
+			currentScope(compiler)->instructions.length = 0;
+			return false;
+		}
+		if (statement->type == STATEMENT_TYPE_LET) {
+			// like the evaluator, a let statement's value is null
+			emit(compiler, OPCODE_NULL, 0, 0);
+			emit(compiler, OPCODE_POP, 0, 0);
+		}
+	}
+	return true;
+}
+
+Bytecode CompilerBytecode(Compiler* compiler) {
+	Bytecode bytecode = {
+			.instructions = (InstructionSpan)BUFFER_AS_SPAN(compiler->scopes.data[0].instructions),
+			.constants = (ObjectSpan)BUFFER_AS_SPAN(compiler->constants),
+			.globalNames = (MonkeyStringSpan)BUFFER_AS_SPAN(compiler->globalNames),
+	};
+	return bytecode;
+}
+
+MonkeyStringBuffer CompilerErrors(Compiler* compiler) {
+	return compiler->errors;
+}
+
+void DestroyCompiler(Compiler* compiler) {
+	free(leaveScope(compiler).data);
+	BUFFER_FREE(compiler->scopes);
+	HeapRemoveTracer(MonkeyGetHeap(compiler->monkey), traceCompiler, compiler);
+	BUFFER_FREE(compiler->constants);
+	g_hash_table_destroy(compiler->immediates);
+	for (size_t i = 0; i < compiler->globalNames.length; ++i) {
+		free(compiler->globalNames.data[i]);
+	}
+	BUFFER_FREE(compiler->globalNames);
+	clearErrors(compiler);
+	BUFFER_FREE(compiler->errors);
+	free(compiler);
+}
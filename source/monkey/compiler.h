@@ -0,0 +1,72 @@
+#pragma once
+
+#include "monkey.h"
+#include "monkey/ast.h"
+#include "monkey/code.h"
+#include "monkey/object.h"
+#include "monkey/string.h"
+
+#include <stdbool.h>
+
+/**
+ * @brief Compiler lowers a Program into bytecode for the virtual machine.
+ *
+ * Global names and the constant pool persist across calls to Compile, so that a REPL can compile
+ * one line at a time against the same virtual machine.
+ */
+typedef struct Compiler Compiler;
+
+/**
+ * @brief Bytecode is the result of a compilation. Everything in it is borrowed from the compiler
+ * and stays valid until the next call to Compile.
+ */
+typedef struct {
+	/**
+	 * @brief instructions are the top-level instructions of the program.
+	 */
+	InstructionSpan instructions;
+	/**
+	 * @brief constants is the constant pool the instructions refer to.
+	 */
+	ObjectSpan constants;
+	/**
+	 * @brief globalNames holds the name of every global slot, for error messages.
+	 */
+	MonkeyStringSpan globalNames;
+} Bytecode;
+
+/**
+ * @brief CreateCompiler creates a new compiler.
+ * @param monkey The library instance.
+ * @return A new compiler.
+ */
+Compiler* CreateCompiler(Monkey* monkey);
+
+/**
+ * @brief Compile compiles a program, replacing the top-level instructions of the previous
+ * compilation.
+ * @param compiler The compiler to use.
+ * @param program The program to compile.
+ * @return Whether compilation succeeded. On failure, see CompilerErrors.
+ */
+bool Compile(Compiler* compiler, Program* program);
+
+/**
+ * @brief CompilerBytecode obtains the result of the last compilation.
+ * @param compiler The compiler to use.
+ * @return The bytecode.
+ */
+Bytecode CompilerBytecode(Compiler* compiler);
+
+/**
+ * @brief Obtain the list of errors from the last compilation.
+ * @param compiler The compiler to use.
+ * @return The list of errors.
+ */
+MonkeyStringBuffer CompilerErrors(Compiler* compiler);
+
+/**
+ * @brief DestroyCompiler destroys a compiler. Its constant pool is left to the garbage collector.
+ * @param compiler The compiler to destroy.
+ */
+void DestroyCompiler(Compiler* compiler);
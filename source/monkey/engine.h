@@ -0,0 +1,15 @@
+#pragma once
+
+/**
+ * @brief MonkeyEngine selects how programs are executed.
+ */
+typedef enum {
+	/**
+	 * @brief MONKEY_ENGINE_EVALUATOR walks the AST directly.
+	 */
+	MONKEY_ENGINE_EVALUATOR,
+	/**
+	 * @brief MONKEY_ENGINE_VM compiles to bytecode and runs it on the virtual machine.
+	 */
+	MONKEY_ENGINE_VM,
+} MonkeyEngine;
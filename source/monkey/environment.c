@@ -1,55 +1,131 @@
 #include "monkey/environment.h"
 
+#include "monkey.h"
+#include "monkey/heap.h"
 #include "monkey/macros.h"
 #include "monkey/object.h"
+#include "monkey/symbol.h"
 
 #include <glib.h>
+#include <hedley.h>
 #include <stdbool.h>
-#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
 
 struct Environment {
+	Object base;
 	Environment* outer;
+	/**
+	 * @brief store holds the variables of a name-keyed scope, and is NULL for function scopes.
+	 */
 	GHashTable* store;
+	/**
+	 * @brief heap and version are only used by name-keyed scopes. The version is taken from the
+	 * heap whenever the scope changes.
+	 */
+	Heap* heap;
+	uint64_t version;
+	size_t slotCount;
+	Object* slots[];
 };
 
-MONKEY_FILE_LOCAL void tblDestroyObject(void* obj) {
-	DestroyObject(obj);
+Environment* CreateEnvironment(Monkey* monkey, Environment* outer) {
+	Environment* env = (Environment*)HeapAllocate(
+			MonkeyGetHeap(monkey), OBJECT_TYPE_ENVIRONMENT, sizeof(Environment));
+	env->base.pinned = true;
+	env->outer = outer;
+	// keys are interned symbols, which compare by pointer and are owned by the symbol table
+	env->store = g_hash_table_new(g_direct_hash, g_direct_equal);
+	env->heap = MonkeyGetHeap(monkey);
+	env->version = HeapNextVersion(env->heap);
+	env->slotCount = 0;
+	return env;
 }
 
-Environment* CreateEnvironment(Environment* outer) {
-	Environment* env = malloc(sizeof(Environment));
+Environment* CreateFunctionEnvironment(Heap* heap, Environment* outer, size_t slotCount) {
+	Environment* env = (Environment*)HeapAllocate(
+			heap, OBJECT_TYPE_ENVIRONMENT, sizeof(Environment) + slotCount * sizeof(Object*));
 	env->outer = outer;
-	env->store = g_hash_table_new_full(g_str_hash, g_str_equal, free, tblDestroyObject);
+	env->store = NULL;
+	env->heap = NULL;
+	env->version = 0;
+	env->slotCount = slotCount;
+	for (size_t i = 0; i < slotCount; ++i) {
+		env->slots[i] = NULL;
+	}
 	return env;
 }
 
 void DestroyEnvironment(Environment* env) {
-	g_hash_table_destroy(env->store);
-	free(env);
+	env->base.pinned = false;
 }
 
-MONKEY_FILE_LOCAL void tblCopyKv(gpointer key, gpointer value, gpointer userData) {
-	GHashTable* dest = userData;
-	g_hash_table_insert(dest, key, value);
+MONKEY_FILE_LOCAL void tblMarkValue(gpointer key, gpointer value, gpointer heap) {
+	(void)key;
+	HeapMark(heap, value);
 }
 
-Environment* CopyEnvironment(Environment* env) {
-	Environment* result = CreateEnvironment(env->outer);
-	g_hash_table_foreach(env->store, &tblCopyKv, result->store);
-	return result;
+void TraceEnvironment(Heap* heap, Environment* env) {
+	HeapMark(heap, (Object*)env->outer);
+	if (env->store != NULL) {
+		g_hash_table_foreach(env->store, tblMarkValue, heap);
+	}
+	for (size_t i = 0; i < env->slotCount; ++i) {
+		HeapMark(heap, env->slots[i]);
+	}
 }
 
-Object* GetEnvironment(Environment* env, const char* name) {
-	Object* result = g_hash_table_lookup(env->store, name);
-	if (result != NULL) {
-		return result;
+size_t FreeEnvironment(Environment* env) {
+	size_t size = sizeof(Environment) + env->slotCount * sizeof(Object*);
+	if (env->store != NULL) {
+		g_hash_table_destroy(env->store);
 	}
-	if (env->outer != NULL) {
-		return GetEnvironment(env->outer, name);
+	return size;
+}
+
+Object* GetEnvironment(Environment* env, const MonkeySymbol* name) {
+	for (; env != NULL; env = env->outer) {
+		if (env->store == NULL) {
+			continue;
+		}
+		Object* result = g_hash_table_lookup(env->store, name);
+		if (result != NULL) {
+			return result;
+		}
 	}
 	return NULL;
 }
 
-bool PutEnvironment(Environment* env, char* name, Object* val) {
-	return g_hash_table_insert(env->store, name, val);
+bool PutEnvironment(Environment* env, const MonkeySymbol* name, Object* val) {
+	env->version = HeapNextVersion(env->heap);
+	return g_hash_table_insert(env->store, HEDLEY_CONST_CAST(MonkeySymbol*, name), val);
+}
+
+Environment* GetNamedScope(Environment* env) {
+	while (env != NULL && env->store == NULL) {
+		env = env->outer;
+	}
+	return env;
+}
+
+uint64_t GetEnvironmentVersion(const Environment* scope) {
+	// every change takes a version newer than all before, so the newest one changes with them
+	uint64_t version = 0;
+	for (; scope != NULL; scope = scope->outer) {
+		if (scope->version > version) {
+			version = scope->version;
+		}
+	}
+	return version;
+}
+
+Object* GetEnvironmentSlot(Environment* env, size_t depth, size_t slot) {
+	for (size_t i = 0; i < depth; ++i) {
+		env = env->outer;
+	}
+	return env->slots[slot];
+}
+
+void SetEnvironmentSlot(Environment* env, size_t slot, Object* val) {
+	env->slots[slot] = val;
 }
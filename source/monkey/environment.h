@@ -1,49 +1,122 @@
 #pragma once
 
+#include "monkey.h"
+#include "monkey/heap.h"
+#include "monkey/macros.h"
 #include "monkey/object.h"
+#include "monkey/symbol.h"
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
+/**
+ * @brief Environment holds the variables of one scope.
+ *
+ * The global scope is keyed by name, so that a REPL can keep adding to it. Function scopes are flat
+ * arrays of slots, which identifiers index directly using the depth and slot the resolver assigned
+ * to them.
+ *
+ * Environments are garbage collected objects. Closures share the environment they were created in
+ * rather than copying it.
+ */
 typedef struct Environment Environment;
 
 /**
- * @brief Create an Environment for holding key-value pairs.
+ * @brief Create an Environment for holding key-value pairs. It is pinned, so that it and
+ * everything in it stays alive until DestroyEnvironment.
  *
+ * @param monkey the library instance
  * @param outer the parent environment, or NULL for a root environment
  * @return Environment* the environment, or NULL if unsuccessful
  */
-Environment* CreateEnvironment(Environment* outer);
+Environment* CreateEnvironment(Monkey* monkey, Environment* outer);
+
+/**
+ * @brief Create an Environment for a function call, with every slot empty.
+ *
+ * @param heap the heap to allocate from
+ * @param outer the environment the function was created in
+ * @param slotCount the number of parameters and local variables of the function
+ * @return Environment* the environment, which the caller must keep reachable
+ */
+Environment* CreateFunctionEnvironment(Heap* heap, Environment* outer, size_t slotCount);
 
 /**
- * @brief Destroy a created Environment. Frees all internal data.
+ * @brief Unpin an Environment made by CreateEnvironment. The garbage collector frees it once
+ * nothing refers to it any more.
  *
  * @param env the environment
  */
 void DestroyEnvironment(Environment* env);
 
 /**
- * @brief Copy an Environment, including its data.
+ * @private
  *
- * @param env the environment
- * @return Environment* the copy
+ * Marks the outer environment and every value of env (see TraceObject).
+ */
+MONKEY_INTERNAL void TraceEnvironment(Heap* heap, Environment* env);
+
+/**
+ * @private
+ *
+ * Frees what an environment the garbage collector found unreachable owns (see FreeObject).
  */
-Environment* CopyEnvironment(Environment* env);
+MONKEY_INTERNAL size_t FreeEnvironment(Environment* env);
 
 /**
- * @brief Get a value from the Environment.
+ * @brief Get a value from the Environment by name, looking in the name-keyed scopes.
  *
  * @param env the environment
  * @param name the value's key
  * @return Object* the value, or NULL if not found
  */
-Object* GetEnvironment(Environment* env, const char* name);
+Object* GetEnvironment(Environment* env, const MonkeySymbol* name);
 
 /**
- * @brief Put a value into the Environment. The Environment owns the provided data.
+ * @brief Put a value into the Environment. Names are interned, so nothing is copied.
  *
- * @param env the environment
+ * @param env the environment, which must be name-keyed
  * @param name the key to store the value under
  * @param val the value
  * @return bool whether there was already a value with this name
  */
-bool PutEnvironment(Environment* env, char* name, Object* val);
+bool PutEnvironment(Environment* env, const MonkeySymbol* name, Object* val);
+
+/**
+ * @brief Returns the innermost name-keyed scope of env, which is env itself unless it is a
+ * function scope, or NULL if there is none.
+ */
+Environment* GetNamedScope(Environment* env);
+
+/**
+ * @brief Returns the version of a name-keyed scope, which changes whenever a value is put into it
+ * or a scope around it.
+ *
+ * Lookups by name from scope find the same values for as long as it has the same version. This
+ * holds even if scope is freed and another one takes its address, since versions are never reused
+ * by the scopes of a library instance.
+ *
+ * @param scope the scope, which may be NULL
+ * @return uint64_t the version, or 0 if scope is NULL
+ */
+uint64_t GetEnvironmentVersion(const Environment* scope);
+
+/**
+ * @brief Get a value from a function scope slot.
+ *
+ * @param env the environment
+ * @param depth how many function scopes to go outwards, 0 being env itself
+ * @param slot the slot within that scope
+ * @return Object* the value, or NULL if the slot was never assigned
+ */
+Object* GetEnvironmentSlot(Environment* env, size_t depth, size_t slot);
+
+/**
+ * @brief Put a value into a slot of a function scope.
+ *
+ * @param env the environment, which must be a function scope
+ * @param slot the slot
+ * @param val the value
+ */
+void SetEnvironmentSlot(Environment* env, size_t slot, Object* val);
@@ -2,14 +2,18 @@
 
 #include "monkey.h"
 #include "monkey/ast.h"
+#include "buffer.h"
 #include "monkey/environment.h"
+#include "monkey/heap.h"
 #include "monkey/macros.h"
 #include "monkey/object.h"
+#include "monkey/resolver.h"
 #include "monkey/string.h"
 #include "span.h"
 
 #include <assert.h>
 #include <hedley.h>
+#include <inttypes.h>
 #include <stdarg.h>
 #include <stdbool.h>
 #include <stddef.h>
@@ -18,37 +22,101 @@
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+/**
+ * @private
+ *
+ * Unwind says why statements stopped running before the end of their block.
+ */
+typedef enum {
+	UNWIND_NONE,
+	/**
+	 * @brief UNWIND_RETURN is a return statement, which stops the function it is in.
+	 */
+	UNWIND_RETURN,
+	/**
+	 * @brief UNWIND_ERROR is an error, which stops everything.
+	 */
+	UNWIND_ERROR,
+} Unwind;
+
 typedef struct {
 	MonkeyInternedObjects interns;
+	Heap* heap;
 	Environment* env;
+	/**
+	 * @brief roots holds the values that are in use but only referenced from C locals, such as
+	 * the left operand while the right one is evaluated, so that the garbage collector sees them.
+	 */
+	BUFFER_TYPE(Object*) roots;
+	/**
+	 * @brief tailCall is set when a call in tail position is left for the applyFunction running
+	 * the enclosing function to make, in place of the call that is returning. Its function and
+	 * the environment holding its arguments are the topmost roots.
+	 */
+	bool tailCall;
+	/**
+	 * @brief unwind is set along with the value that stops the statements being run, which is
+	 * returned like any other.
+	 */
+	Unwind unwind;
+	/**
+	 * @brief depth counts the calls being run, up to maxDepth.
+	 */
+	size_t depth;
+	size_t maxDepth;
+	/**
+	 * @brief stackBase is where the C stack was when Eval was called, and stackLimit is how far
+	 * from there calls may start.
+	 */
+	uintptr_t stackBase;
+	size_t stackLimit;
 } EvaluatorState;
 
 MONKEY_FILE_LOCAL Object* evalStatement(EvaluatorState* state, Statement* statement);
 MONKEY_FILE_LOCAL Object* evalExpression(EvaluatorState* state, Expression* expression);
 
-MONKEY_FILE_LOCAL Object* HEDLEY_PRINTF_FORMAT(1, 2) newError(const char* format, ...) {
+MONKEY_FILE_LOCAL void traceState(Heap* heap, void* context) {
+	EvaluatorState* state = context;
+	HeapMark(heap, (Object*)state->env);
+	for (size_t i = 0; i < state->roots.length; ++i) {
+		HeapMark(heap, state->roots.data[i]);
+	}
+}
+
+MONKEY_FILE_LOCAL void pushRoot(EvaluatorState* state, Object* obj) {
+	BUFFER_PUSH(&state->roots, obj);
+}
+
+MONKEY_FILE_LOCAL void popRoots(EvaluatorState* state, size_t count) {
+	state->roots.length -= count;
+}
+
+/**
+ * @private
+ *
+ * Create an error for the expression starting at offset.
+ */
+MONKEY_FILE_LOCAL Object* HEDLEY_PRINTF_FORMAT(3, 4)
+		newError(EvaluatorState* state, size_t offset, const char* format, ...) {
 	va_list args;
 	va_start(args, format);
 	char* message = MonkeyAvsprintf(format, args);
 	va_end(args);
 
-	return (Object*)CreateErrorObject(message);
+	state->unwind = UNWIND_ERROR;
+	return (Object*)CreateErrorObject(state->heap, message, offset);
 }
 
 MONKEY_FILE_LOCAL Object* evalProgram(EvaluatorState* state, Program* program) {
 	Object* result = NULL;
 
 	for (size_t i = 0; i < program->statements.length; i++) {
-		DestroyObject(result);
 		result = evalStatement(state, program->statements.begin[i]);
-		if (result != NULL && result->type == OBJECT_TYPE_RETURN_VALUE) {
-			ReturnValueObject* toFree = (ReturnValueObject*)result;
-			result = toFree->value;
-			toFree->value = NULL;
-			DestroyObject(&toFree->base);
-			return result;
-		}
-		if (result != NULL && result->type == OBJECT_TYPE_ERROR) {
+		if (state->unwind != UNWIND_NONE) {
 			return result;
 		}
 	}
@@ -60,10 +128,8 @@ MONKEY_FILE_LOCAL Object* evalBlockStatement(EvaluatorState* state, BlockStateme
 	Object* result = NULL;
 
 	for (size_t i = 0; i < block->statements.length; i++) {
-		DestroyObject(result);
 		result = evalStatement(state, block->statements.begin[i]);
-		if (result != NULL &&
-				(result->type == OBJECT_TYPE_RETURN_VALUE || result->type == OBJECT_TYPE_ERROR)) {
+		if (state->unwind != UNWIND_NONE) {
 			return result;
 		}
 	}
@@ -75,97 +141,148 @@ MONKEY_FILE_LOCAL bool isTruthy(EvaluatorState* state, Object* value) {
 	return !(value == state->interns.falseObj || value == state->interns.nullObj);
 }
 
-MONKEY_FILE_LOCAL bool isError(Object* value) {
-	return value != NULL && value->type == OBJECT_TYPE_ERROR;
+MONKEY_FILE_LOCAL bool failed(const EvaluatorState* state) {
+	return state->unwind == UNWIND_ERROR;
 }
 
 MONKEY_FILE_LOCAL Object* nativeBoolToBooleanObject(EvaluatorState* state, bool value) {
 	return value ? state->interns.trueObj : state->interns.falseObj;
 }
 
-MONKEY_FILE_LOCAL ObjectSpan evalExpressions(EvaluatorState* state, ExpressionSpan exps) {
-	Object** rawResult = calloc(exps.length, sizeof(Object*));
+/**
+ * @private
+ *
+ * Returns an address in the C stack frame of the caller, or 0 where there is no way to tell.
+ */
+HEDLEY_ALWAYS_INLINE MONKEY_FILE_LOCAL uintptr_t stackPosition(void) {
+#if defined(__GNUC__)
+	return (uintptr_t)__builtin_frame_address(0);
+#elif defined(_MSC_VER)
+	return (uintptr_t)_AddressOfReturnAddress();
+#else
+	return 0;
+#endif
+}
 
-	for (size_t i = 0; i < exps.length; ++i) {
-		Object* evaluated = evalExpression(state, exps.begin[i]);
-		if (isError(evaluated)) {
-			for (size_t j = 0; j < i; ++j) {
-				DestroyObject(rawResult[i]);
-			}
-			free(rawResult);
-			rawResult = malloc(1 * sizeof(Object*));
-			rawResult[0] = evaluated;
-			return (ObjectSpan)SPAN_WITH_LENGTH(rawResult, 1);
-		}
-		rawResult[i] = evaluated;
+MONKEY_FILE_LOCAL bool stackExhausted(EvaluatorState* state) {
+	uintptr_t position = stackPosition();
+	// stacks grow down nearly everywhere, but nothing depends on it
+	size_t used = position < state->stackBase ? state->stackBase - position
+											  : position - state->stackBase;
+	return state->depth >= state->maxDepth || used > state->stackLimit;
+}
+
+/**
+ * @private
+ *
+ * Calls a function. The function and the environment of the call, with the arguments already in
+ * its first slots, are the topmost roots, and are popped. Tail calls the body makes are made here
+ * in turn, each replacing the function that made it, so that loops written as tail recursion run
+ * in constant C stack.
+ */
+MONKEY_FILE_LOCAL Object* applyFunction(EvaluatorState* state, size_t offset) {
+	if (HEDLEY_UNLIKELY(stackExhausted(state))) {
+		popRoots(state, 2);
+		return newError(state, offset, "stack overflow");
 	}
+	++state->depth;
+	Environment* callerEnv = state->env;
+	Object* result = NULL;
+	while (true) {
+		Object** call = &state->roots.data[state->roots.length - 2];
+		FunctionObject* function = (FunctionObject*)call[0];
+		state->env = (Environment*)call[1];
+		// the function stays rooted while its body runs, and so does the caller's environment
+		call[1] = (Object*)callerEnv;
+		result = evalBlockStatement(state, function->body);
+		state->env = callerEnv;
+		if (state->unwind == UNWIND_RETURN) {
+			state->unwind = UNWIND_NONE;
+		}
+		if (HEDLEY_LIKELY(!state->tailCall)) {
+			popRoots(state, 2);
+			break;
+		}
 
-	return (ObjectSpan)SPAN_WITH_LENGTH(rawResult, exps.length);
+		// the tail call takes the place of this one, whose roots may have moved while it ran
+		state->tailCall = false;
+		call = &state->roots.data[state->roots.length - 4];
+		memmove(call, call + 2, 2 * sizeof(Object*));
+		popRoots(state, 2);
+	}
+	--state->depth;
+	return result;
 }
 
-MONKEY_FILE_LOCAL Environment* extendFunctionEnv(FunctionObject* function, ObjectSpan arguments) {
-	Environment* env = CreateEnvironment(function->env);
-
-	for (size_t i = 0; i < function->parameters.length; ++i) {
-		PutEnvironment(env, MonkeyStrdup(function->parameters.begin[i]->value), arguments.begin[i]);
+MONKEY_FILE_LOCAL Object* evalIdentifier(EvaluatorState* state, Identifier* identifier) {
+	Object* val = identifier->scope == IDENTIFIER_SCOPE_LOCAL
+			? GetEnvironmentSlot(state->env, identifier->depth, identifier->slot)
+			: GetEnvironment(state->env, identifier->symbol);
+	if (val == NULL) {
+		return newError(state, identifier->token.offset, "identifier not found: %.*s",
+				(int)identifier->value.length, identifier->value.begin);
 	}
 
-	return env;
+	return val;
 }
 
-MONKEY_FILE_LOCAL Object* unwrapReturnValue(Object* obj) {
-	if (obj->type == OBJECT_TYPE_RETURN_VALUE) {
-		ReturnValueObject* rv = (ReturnValueObject*)obj;
-		Object* result = rv->value;
-		rv->value = NULL;
-		DestroyObject(&rv->base);
-		return result;
+/**
+ * @private
+ *
+ * Evaluates the function a call is made to. Global names are looked up through the call's inline
+ * cache, and checked is set if the function came from it, since only functions that take the
+ * call's arguments are cached.
+ */
+MONKEY_FILE_LOCAL Object* evalCallee(EvaluatorState* state, CallExpression* call, bool* checked) {
+	if (call->function->type != EXPRESSION_TYPE_IDENTIFIER
+			|| ((Identifier*)call->function)->scope != IDENTIFIER_SCOPE_GLOBAL) {
+		return evalExpression(state, call->function);
+	}
+	CallCache* cache = &call->cache;
+	const Environment* scope = GetNamedScope(state->env);
+	uint64_t version = GetEnvironmentVersion(scope);
+	if (HEDLEY_LIKELY(scope != NULL && cache->scope == scope && cache->version == version)) {
+		*checked = true;
+		return cache->function;
 	}
-	return obj;
-}
 
-MONKEY_FILE_LOCAL Object* applyFunction(
-		EvaluatorState* state, Object* functionObj, ObjectSpan arguments) {
-	if (functionObj->type != OBJECT_TYPE_FUNCTION) {
-		ObjectType funcType = functionObj->type;
-		DestroyObject(functionObj);
-		for (size_t i = 0; i < arguments.length; ++i) {
-			DestroyObject(arguments.begin[i]);
-		}
-		free(arguments.begin);
-		return newError("not a function: %s", ObjectTypeText(funcType));
+	Object* function = evalIdentifier(state, (Identifier*)call->function);
+	if (ObjectTypeOf(function) == OBJECT_TYPE_FUNCTION
+			&& ((FunctionObject*)function)->parameters.length == call->arguments.length) {
+		*cache = (CallCache){scope, version, function};
 	}
-	FunctionObject* function = (FunctionObject*)functionObj;
-
-	Environment* extendedEnv = extendFunctionEnv(function, arguments);
-	Environment* oldEnvironment = state->env;
-	state->env = extendedEnv;
-	Object* result = evalBlockStatement(state, function->body);
-	DestroyObject(functionObj);
-	free(arguments.begin);
-	DestroyEnvironment(extendedEnv);
-	state->env = oldEnvironment;
-	return unwrapReturnValue(result);
+	return function;
 }
 
-MONKEY_FILE_LOCAL Object* evalIdentifier(EvaluatorState* state, Identifier* identifier) {
-	Object* val = GetEnvironment(state->env, identifier->value);
-	if (val == NULL) {
-		return newError("identifier not found: %s", identifier->value);
+/**
+ * @private
+ *
+ * Fails a call to something that cannot take its arguments. They are evaluated anyway, since
+ * their errors come first.
+ */
+MONKEY_FILE_LOCAL Object* failCall(EvaluatorState* state, CallExpression* call, Object* function) {
+	ObjectType type = ObjectTypeOf(function);
+	size_t parameterCount =
+			type == OBJECT_TYPE_FUNCTION ? ((FunctionObject*)function)->parameters.length : 0;
+	for (size_t i = 0; i < call->arguments.length; ++i) {
+		Object* argument = evalExpression(state, call->arguments.begin[i]);
+		if (failed(state)) {
+			return argument;
+		}
 	}
-
-	return CopyObject(val);
+	if (type != OBJECT_TYPE_FUNCTION) {
+		return newError(state, call->token.offset, "not a function: %s", ObjectTypeText(type));
+	}
+	return newError(state, call->token.offset, "wrong number of arguments: want=%zu, got=%zu",
+			parameterCount, call->arguments.length);
 }
 
 MONKEY_FILE_LOCAL Object* evalIfExpression(EvaluatorState* state, IfExpression* exp) {
 	Object* condition = evalExpression(state, exp->condition);
-	if (isError(condition)) {
+	if (failed(state)) {
 		return condition;
 	}
-	bool truthy = isTruthy(state, condition);
-	DestroyObject(condition);
-
-	if (truthy) {
+	if (isTruthy(state, condition)) {
 		return evalBlockStatement(state, exp->consequence);
 	}
 	if (exp->alternative != NULL) {
@@ -178,72 +295,84 @@ MONKEY_FILE_LOCAL Object* evalBangOperatorExpression(EvaluatorState* state, Obje
 	return nativeBoolToBooleanObject(state, !isTruthy(state, right));
 }
 
-MONKEY_FILE_LOCAL Object* evalMinusPrefixOperatorExpression(Object* right) {
-	if (right->type != OBJECT_TYPE_INTEGER) {
-		return newError("unknown operator: -%s", ObjectTypeText(right->type));
+MONKEY_FILE_LOCAL Object* evalMinusPrefixOperatorExpression(
+		EvaluatorState* state, Object* right, size_t offset) {
+	if (ObjectTypeOf(right) != OBJECT_TYPE_INTEGER) {
+		return newError(
+				state, offset, "unknown operator: -%s", ObjectTypeText(ObjectTypeOf(right)));
 	}
 
-	int64_t value = ((IntegerObject*)right)->value;
-	return (Object*)CreateIntegerObject(-value);
+	int64_t value = ObjectToInteger(right);
+	if (value == INT64_MIN) {
+		return newError(state, offset, "integer overflow: -%" PRId64, value);
+	}
+	return IntegerToObject(state->heap, -value);
 }
 
 MONKEY_FILE_LOCAL Object* evalPrefixExpression(
-		EvaluatorState* state, const char* op, Object* right) {
-	if (strcmp(op, "!") == 0) {
-		return evalBangOperatorExpression(state, right);
-	}
-	if (strcmp(op, "-") == 0) {
-		return evalMinusPrefixOperatorExpression(right);
+		EvaluatorState* state, Operator op, Object* right, size_t offset) {
+	switch (op) {
+		case OPERATOR_BANG:
+			return evalBangOperatorExpression(state, right);
+		case OPERATOR_MINUS:
+			return evalMinusPrefixOperatorExpression(state, right, offset);
+		default:
+			break;
 	}
-	return newError("unknown operator: %s%s", op, ObjectTypeText(right->type));
+	return newError(state, offset, "unknown operator: %s%s", OperatorText(op),
+			ObjectTypeText(ObjectTypeOf(right)));
 }
 
 MONKEY_FILE_LOCAL Object* evalIntegerInfixExpression(
-		EvaluatorState* state, const char* op, IntegerObject* left, IntegerObject* right) {
-	if (strcmp(op, "+") == 0) {
-		return (Object*)CreateIntegerObject(left->value + right->value);
-	}
-	if (strcmp(op, "-") == 0) {
-		return (Object*)CreateIntegerObject(left->value - right->value);
-	}
-	if (strcmp(op, "*") == 0) {
-		return (Object*)CreateIntegerObject(left->value * right->value);
-	}
-	if (strcmp(op, "/") == 0) {
-		return (Object*)CreateIntegerObject(left->value / right->value);
-	}
-	if (strcmp(op, "<") == 0) {
-		return nativeBoolToBooleanObject(state, left->value < right->value);
-	}
-	if (strcmp(op, ">") == 0) {
-		return nativeBoolToBooleanObject(state, left->value > right->value);
-	}
-	if (strcmp(op, "==") == 0) {
-		return nativeBoolToBooleanObject(state, left->value == right->value);
-	}
-	if (strcmp(op, "!=") == 0) {
-		return nativeBoolToBooleanObject(state, left->value != right->value);
+		EvaluatorState* state, Operator op, int64_t left, int64_t right, size_t offset) {
+	int64_t result;
+	switch (op) {
+		case OPERATOR_PLUS:
+		case OPERATOR_MINUS:
+		case OPERATOR_ASTERISK:
+		case OPERATOR_SLASH:
+			if (ApplyIntegerOperator(op, left, right, &result)) {
+				return IntegerToObject(state->heap, result);
+			}
+			if (op == OPERATOR_SLASH && right == 0) {
+				return newError(state, offset, "division by zero");
+			}
+			return newError(state, offset, "integer overflow: %" PRId64 " %s %" PRId64, left,
+					OperatorText(op), right);
+		case OPERATOR_LT:
+			return nativeBoolToBooleanObject(state, left < right);
+		case OPERATOR_GT:
+			return nativeBoolToBooleanObject(state, left > right);
+		case OPERATOR_EQ:
+			return nativeBoolToBooleanObject(state, left == right);
+		case OPERATOR_NOT_EQ:
+			return nativeBoolToBooleanObject(state, left != right);
+		case OPERATOR_BANG:
+			break;
 	}
-	return newError("unknown operator: INTEGER %s INTEGER", op);
+	return newError(state, offset, "unknown operator: INTEGER %s INTEGER", OperatorText(op));
 }
 
 MONKEY_FILE_LOCAL Object* evalInfixExpression(
-		EvaluatorState* state, const char* op, Object* left, Object* right) {
-	if (left->type == OBJECT_TYPE_INTEGER && right->type == OBJECT_TYPE_INTEGER) {
-		return evalIntegerInfixExpression(state, op, (IntegerObject*)left, (IntegerObject*)right);
+		EvaluatorState* state, Operator op, Object* left, Object* right, size_t offset) {
+	ObjectType leftType = ObjectTypeOf(left);
+	ObjectType rightType = ObjectTypeOf(right);
+	if (leftType == OBJECT_TYPE_INTEGER && rightType == OBJECT_TYPE_INTEGER) {
+		return evalIntegerInfixExpression(
+				state, op, ObjectToInteger(left), ObjectToInteger(right), offset);
 	}
-	if (strcmp(op, "==") == 0) {
+	if (op == OPERATOR_EQ) {
 		return nativeBoolToBooleanObject(state, left == right);
 	}
-	if (strcmp(op, "!=") == 0) {
+	if (op == OPERATOR_NOT_EQ) {
 		return nativeBoolToBooleanObject(state, left != right);
 	}
-	if (left->type != right->type) {
-		return newError("type mismatch: %s %s %s", ObjectTypeText(left->type), op,
-				ObjectTypeText(right->type));
+	if (leftType != rightType) {
+		return newError(state, offset, "type mismatch: %s %s %s", ObjectTypeText(leftType),
+				OperatorText(op), ObjectTypeText(rightType));
 	}
-	return newError("unknown operator: %s %s %s", ObjectTypeText(left->type), op,
-			ObjectTypeText(right->type));
+	return newError(state, offset, "unknown operator: %s %s %s", ObjectTypeText(leftType),
+			OperatorText(op), ObjectTypeText(rightType));
 }
 
 MONKEY_FILE_LOCAL Object* evalStatement(EvaluatorState* state, Statement* statement) {
@@ -253,19 +382,23 @@ MONKEY_FILE_LOCAL Object* evalStatement(EvaluatorState* state, Statement* statem
 		case STATEMENT_TYPE_RETURN: {
 			ReturnStatement* ret = (ReturnStatement*)statement;
 			Object* val = evalExpression(state, ret->returnValue);
-			if (isError(val)) {
-				return val;
+			if (!failed(state)) {
+				state->unwind = UNWIND_RETURN;
 			}
-			return (Object*)CreateReturnValueObject(val);
+			return val;
 		}
 		case STATEMENT_TYPE_LET: {
 			LetStatement* let = (LetStatement*)statement;
 			Object* val = evalExpression(state, let->value);
-			if (isError(val)) {
+			if (failed(state)) {
 				return val;
 			}
 
-			PutEnvironment(state->env, MonkeyStrdup(let->identifier->value), val);
+			if (let->identifier->scope == IDENTIFIER_SCOPE_LOCAL) {
+				SetEnvironmentSlot(state->env, let->identifier->slot, val);
+			} else {
+				PutEnvironment(state->env, let->identifier->symbol, val);
+			}
 			return state->interns.nullObj;
 		}
 		case STATEMENT_TYPE_BLOCK:
@@ -279,7 +412,7 @@ MONKEY_FILE_LOCAL Object* evalExpression(EvaluatorState* state, Expression* expr
 	switch (expression->type) {
 		case EXPRESSION_TYPE_INTEGER_LITERAL: {
 			IntegerLiteral* lit = (IntegerLiteral*)expression;
-			return (Object*)CreateIntegerObject(lit->value);
+			return IntegerToObject(state->heap, lit->value);
 		}
 		case EXPRESSION_TYPE_BOOLEAN_LITERAL: {
 			BooleanLiteral* lit = (BooleanLiteral*)expression;
@@ -288,29 +421,25 @@ MONKEY_FILE_LOCAL Object* evalExpression(EvaluatorState* state, Expression* expr
 		case EXPRESSION_TYPE_PREFIX: {
 			PrefixExpression* prefix = (PrefixExpression*)expression;
 			Object* right = evalExpression(state, prefix->right);
-			if (isError(right)) {
+			if (failed(state)) {
 				return right;
 			}
-			Object* result = evalPrefixExpression(state, prefix->op, right);
-
-			DestroyObject(right);
-			return result;
+			return evalPrefixExpression(state, prefix->op, right, prefix->token.offset);
 		}
 		case EXPRESSION_TYPE_INFIX: {
 			InfixExpression* infix = (InfixExpression*)expression;
 			Object* left = evalExpression(state, infix->left);
-			if (isError(left)) {
+			if (failed(state)) {
 				return left;
 			}
+			pushRoot(state, left);
 			Object* right = evalExpression(state, infix->right);
-			if (isError(right)) {
+			popRoots(state, 1);
+			if (failed(state)) {
 				return right;
 			}
 
-			Object* result = evalInfixExpression(state, infix->op, left, right);
-			DestroyObject(right);
-			DestroyObject(left);
-			return result;
+			return evalInfixExpression(state, infix->op, left, right, infix->token.offset);
 		}
 		case EXPRESSION_TYPE_IF:
 			return evalIfExpression(state, (IfExpression*)expression);
@@ -318,41 +447,76 @@ MONKEY_FILE_LOCAL Object* evalExpression(EvaluatorState* state, Expression* expr
 			return evalIdentifier(state, (Identifier*)expression);
 		case EXPRESSION_TYPE_FUNCTION_LITERAL: {
 			FunctionLiteral* func = (FunctionLiteral*)expression;
-			return (Object*)CreateFunctionObject(func, CopyEnvironment(state->env));
+			return (Object*)CreateFunctionObject(state->heap, func, state->env);
 		}
 		case EXPRESSION_TYPE_CALL: {
 			CallExpression* call = (CallExpression*)expression;
-			Object* function = evalExpression(state, call->function);
-			if (isError(function)) {
+			bool checked = false;
+			Object* function = evalCallee(state, call, &checked);
+			if (failed(state)) {
 				return function;
 			}
-			ObjectSpan args = evalExpressions(state, call->arguments);
-			if (args.length == 1 && isError(args.begin[0])) {
-				Object* result = args.begin[0];
-				free(args.begin);
-				DestroyObject(function);
-				return result;
+			if (!checked
+					&& (ObjectTypeOf(function) != OBJECT_TYPE_FUNCTION
+							|| ((FunctionObject*)function)->parameters.length
+									!= call->arguments.length)) {
+				return failCall(state, call, function);
 			}
-			return applyFunction(state, function, args);
+
+			// arguments go straight into the slots the resolver gave the parameters in the call's
+			// environment
+			FunctionObject* callee = (FunctionObject*)function;
+			pushRoot(state, function);
+			Environment* env =
+					CreateFunctionEnvironment(state->heap, callee->env, callee->slotCount);
+			pushRoot(state, (Object*)env);
+			for (size_t i = 0; i < call->arguments.length; ++i) {
+				Object* argument = evalExpression(state, call->arguments.begin[i]);
+				if (failed(state)) {
+					popRoots(state, 2);
+					return argument;
+				}
+				SetEnvironmentSlot(env, callee->parameters.begin[i]->slot, argument);
+			}
+			if (call->tail) {
+				// the value does not matter, since the function returns as soon as it is known
+				state->tailCall = true;
+				return state->interns.nullObj;
+			}
+			return applyFunction(state, call->token.offset);
 		}
 	}
 	(void)fprintf(stderr, "Unknown expression type: %d\n", expression->type);
 	assert(false);
 }
 
-Object* Eval(Monkey* monkey, Environment* env, Node* node) {
-	EvaluatorState state = {
-			.interns = MonkeyGetInterns(monkey),
-			.env = env,
-	};
+MONKEY_FILE_LOCAL Object* evalNode(EvaluatorState* state, Node* node) {
 	switch (node->type) {
 		case NODE_TYPE_PROGRAM:
-			return evalProgram(&state, (Program*)node);
+			ResolveProgram((Program*)node);
+			return evalProgram(state, (Program*)node);
 		case NODE_TYPE_STATEMENT:
-			return evalStatement(&state, (Statement*)node);
+			return evalStatement(state, (Statement*)node);
 		case NODE_TYPE_EXPRESSION:
-			return evalExpression(&state, (Expression*)node);
+			return evalExpression(state, (Expression*)node);
 	}
 	(void)fprintf(stderr, "Unknown node type: %d\n", node->type);
 	assert(false);
 }
+
+Object* Eval(Monkey* monkey, Environment* env, Node* node) {
+	EvaluatorState state = {
+			.interns = MonkeyGetInterns(monkey),
+			.heap = MonkeyGetHeap(monkey),
+			.env = env,
+			.roots = BUFFER_INIT,
+			.maxDepth = MonkeyGetMaxCallDepth(monkey),
+			.stackBase = stackPosition(),
+			.stackLimit = MonkeyGetStackLimit(monkey),
+	};
+	HeapAddTracer(state.heap, traceState, &state);
+	Object* result = evalNode(&state, node);
+	HeapRemoveTracer(state.heap, traceState, &state);
+	BUFFER_FREE(state.roots);
+	return result;
+}
@@ -5,4 +5,14 @@
 #include "monkey/environment.h"
 #include "monkey/object.h"
 
+/**
+ * @brief Eval evaluates a node. Programs are resolved (see ResolveProgram) first; any other node
+ * must come from a program that was already resolved.
+ *
+ * @param monkey The library instance.
+ * @param env The root environment.
+ * @param node The node to evaluate.
+ * @return The value of the node. It is only guaranteed to stay valid until the next allocation on
+ * the library instance, e.g. the next call to Eval.
+ */
 Object* Eval(Monkey* monkey, Environment* env, Node* node);
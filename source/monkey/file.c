@@ -0,0 +1,114 @@
+#ifndef _WIN32
+// mmap and friends are POSIX, not C11
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include "monkey/file.h"
+
+#include "monkey/string.h"
+#include "span.h"
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdlib.h>
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+struct MappedFile {
+	/**
+	 * @brief data is NULL for an empty file, which cannot be mapped.
+	 */
+	void* data;
+	size_t length;
+};
+
+MappedFile* MapFile(const char* path) {
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+			FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) {
+		return NULL;
+	}
+	if (GetFileType(file) != FILE_TYPE_DISK) {
+		CloseHandle(file);
+		errno = ENODEV;
+		return NULL;
+	}
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size)) {
+		CloseHandle(file);
+		return NULL;
+	}
+	void* data = NULL;
+	if (size.QuadPart > 0) {
+		HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (mapping != NULL) {
+			data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+			CloseHandle(mapping);
+		}
+		if (data == NULL) {
+			CloseHandle(file);
+			return NULL;
+		}
+	}
+	CloseHandle(file);
+	size_t length = (size_t)size.QuadPart;
+#else
+	int fd = open(path, O_RDONLY);
+	if (fd == -1) {
+		return NULL;
+	}
+	struct stat info;
+	if (fstat(fd, &info) == -1) {
+		(void)close(fd);
+		return NULL;
+	}
+	if (!S_ISREG(info.st_mode)) {
+		(void)close(fd);
+		// the size of anything else says nothing about what can be read from it
+		errno = S_ISDIR(info.st_mode) ? EISDIR : ENODEV;
+		return NULL;
+	}
+	void* data = NULL;
+	size_t length = (size_t)info.st_size;
+	if (length > 0) {
+		data = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (data == MAP_FAILED) {
+			(void)close(fd);
+			return NULL;
+		}
+		// the whole file is about to be lexed front to back
+		(void)posix_madvise(data, length, POSIX_MADV_SEQUENTIAL);
+	}
+	// the mapping stays valid after the descriptor is closed
+	(void)close(fd);
+#endif
+	MappedFile* result = malloc(sizeof(MappedFile));
+	result->data = data;
+	result->length = length;
+	return result;
+}
+
+MonkeyStringView MappedFileContents(const MappedFile* file) {
+	if (file->data == NULL) {
+		return MonkeyStringViewFrom("");
+	}
+	return (MonkeyStringView)SPAN_WITH_LENGTH((const char*)file->data, file->length);
+}
+
+void UnmapFile(MappedFile* file) {
+	if (file->data != NULL) {
+#ifdef _WIN32
+		UnmapViewOfFile(file->data);
+#else
+		(void)munmap(file->data, file->length);
+#endif
+	}
+	free(file);
+}
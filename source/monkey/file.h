@@ -0,0 +1,32 @@
+#pragma once
+
+#include "monkey/string.h"
+
+/**
+ * @brief MappedFile is a file whose contents have been mapped into memory, read-only.
+ *
+ * Mapping lets the lexer work directly on the page cache instead of copying the file into a
+ * buffer first.
+ */
+typedef struct MappedFile MappedFile;
+
+/**
+ * @brief MapFile maps a whole file into memory.
+ *
+ * Only regular files are mapped. Directories fail with EISDIR, and anything else that cannot be
+ * mapped, such as a pipe or a terminal, with ENODEV; those can still be read as a stream.
+ *
+ * @param path The path of the file.
+ * @return The mapped file, or NULL if it could not be opened or mapped. errno says why.
+ */
+MappedFile* MapFile(const char* path);
+
+/**
+ * @brief MappedFileContents returns the contents of a mapped file, which are not NUL-terminated.
+ */
+MonkeyStringView MappedFileContents(const MappedFile* file);
+
+/**
+ * @brief UnmapFile unmaps and closes a file. Its contents must not be used afterwards.
+ */
+void UnmapFile(MappedFile* file);
@@ -0,0 +1,155 @@
+#include "monkey/heap.h"
+
+#include "buffer.h"
+#include "monkey/macros.h"
+#include "monkey/object.h"
+#include "monkey/pool.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+typedef struct {
+	HeapTracer tracer;
+	void* context;
+} TracerEntry;
+
+struct Heap {
+	Object* objects;
+	size_t objectCount;
+	size_t peakObjectCount;
+	/**
+	 * @brief pool is where the memory of objects comes from, and goes back to when they are freed.
+	 */
+	Pool* pool;
+	/**
+	 * @brief allocated is the size of every object in the heap, as passed to HeapAllocate.
+	 */
+	size_t allocated;
+	size_t nextCollection;
+	size_t threshold;
+	BUFFER_TYPE(TracerEntry) tracers;
+	/**
+	 * @brief gray holds the marked objects whose references have not been traced yet. It is kept
+	 * between collections to avoid reallocating it.
+	 */
+	BUFFER_TYPE(Object*) gray;
+	uint64_t lastVersion;
+};
+
+Heap* CreateHeap(void) {
+	Heap* heap = calloc(1, sizeof(Heap));
+	heap->pool = CreatePool();
+	HeapSetThreshold(heap, HEAP_DEFAULT_THRESHOLD);
+	return heap;
+}
+
+void DestroyHeap(Heap* heap) {
+	Object* obj = heap->objects;
+	while (obj != NULL) {
+		Object* next = obj->next;
+		PoolFree(heap->pool, obj, FreeObject(obj));
+		obj = next;
+	}
+	DestroyPool(heap->pool);
+	BUFFER_FREE(heap->tracers);
+	BUFFER_FREE(heap->gray);
+	free(heap);
+}
+
+MONKEY_FILE_LOCAL void scheduleCollection(Heap* heap) {
+	if (heap->threshold == 0) {
+		heap->nextCollection = 0;
+		return;
+	}
+	size_t growth = heap->allocated > heap->threshold ? heap->allocated : heap->threshold;
+	heap->nextCollection = heap->allocated + growth;
+}
+
+Object* HeapAllocate(Heap* heap, ObjectType type, size_t size) {
+	if (heap->allocated + size > heap->nextCollection) {
+		CollectGarbage(heap);
+	}
+	Object* obj = PoolAllocate(heap->pool, size);
+	obj->type = type;
+	obj->marked = false;
+	obj->pinned = false;
+	obj->next = heap->objects;
+	heap->objects = obj;
+	if (++heap->objectCount > heap->peakObjectCount) {
+		heap->peakObjectCount = heap->objectCount;
+	}
+	heap->allocated += size;
+	return obj;
+}
+
+void HeapMark(Heap* heap, Object* obj) {
+	if (obj == NULL || IsImmediateObject(obj) || obj->marked) {
+		return;
+	}
+	obj->marked = true;
+	BUFFER_PUSH(&heap->gray, obj);
+}
+
+void HeapAddTracer(Heap* heap, HeapTracer tracer, void* context) {
+	TracerEntry entry = {tracer, context};
+	BUFFER_PUSH(&heap->tracers, entry);
+}
+
+void HeapRemoveTracer(Heap* heap, HeapTracer tracer, void* context) {
+	for (size_t i = 0; i < heap->tracers.length; ++i) {
+		TracerEntry entry = heap->tracers.data[i];
+		if (entry.tracer == tracer && entry.context == context) {
+			heap->tracers.data[i] = heap->tracers.data[--heap->tracers.length];
+			return;
+		}
+	}
+}
+
+void HeapSetThreshold(Heap* heap, size_t bytes) {
+	heap->threshold = bytes;
+	scheduleCollection(heap);
+}
+
+void CollectGarbage(Heap* heap) {
+	for (Object* obj = heap->objects; obj != NULL; obj = obj->next) {
+		if (obj->pinned) {
+			HeapMark(heap, obj);
+		}
+	}
+	for (size_t i = 0; i < heap->tracers.length; ++i) {
+		heap->tracers.data[i].tracer(heap, heap->tracers.data[i].context);
+	}
+	while (heap->gray.length > 0) {
+		TraceObject(heap, heap->gray.data[--heap->gray.length]);
+	}
+
+	Object** link = &heap->objects;
+	while (*link != NULL) {
+		Object* obj = *link;
+		if (obj->marked) {
+			obj->marked = false;
+			link = &obj->next;
+		} else {
+			*link = obj->next;
+			--heap->objectCount;
+			size_t size = FreeObject(obj);
+			PoolFree(heap->pool, obj, size);
+			heap->allocated -= size;
+		}
+	}
+	scheduleCollection(heap);
+}
+
+size_t HeapObjectCount(const Heap* heap) {
+	return heap->objectCount;
+}
+
+size_t HeapPeakObjectCount(const Heap* heap) {
+	return heap->peakObjectCount;
+}
+
+uint64_t HeapNextVersion(Heap* heap) {
+	return ++heap->lastVersion;
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "monkey/macros.h"
+#include "monkey/object.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Heap is the garbage collector that owns every heap-allocated Object of a Monkey instance.
+ *
+ * It is a non-moving mark-and-sweep collector. Objects are marked starting from the roots, which
+ * are pinned objects (such as environments created with CreateEnvironment) and whatever the
+ * registered tracers mark, e.g. the stack of a running VM. Everything left unmarked is freed.
+ *
+ * A collection can only start inside HeapAllocate, so objects held in C locals are safe until the
+ * next allocation. The memory of freed objects is kept in a Pool for the next ones.
+ */
+typedef struct Heap Heap;
+
+/**
+ * @brief HeapTracer marks the roots held by some part of the interpreter, using HeapMark.
+ */
+typedef void (*HeapTracer)(Heap* heap, void* context);
+
+#define HEAP_DEFAULT_THRESHOLD ((size_t)1 << 20U)
+
+/**
+ * @private
+ */
+MONKEY_INTERNAL Heap* CreateHeap(void);
+
+/**
+ * @private
+ *
+ * Frees every object, reachable or not.
+ */
+MONKEY_INTERNAL void DestroyHeap(Heap* heap);
+
+/**
+ * @brief Allocate an object of the given type and size, collecting garbage first if the heap has
+ * grown enough since the last collection.
+ *
+ * @param heap the heap
+ * @param type the type of the object
+ * @param size the size of the object, including its Object header
+ * @return Object* the object, with only its header initialized
+ */
+Object* HeapAllocate(Heap* heap, ObjectType type, size_t size);
+
+/**
+ * @brief Mark an object as reachable. Immediates and NULL are ignored.
+ */
+void HeapMark(Heap* heap, Object* obj);
+
+/**
+ * @brief Register a tracer, which every collection calls to mark roots.
+ */
+void HeapAddTracer(Heap* heap, HeapTracer tracer, void* context);
+
+/**
+ * @brief Unregister a tracer that was registered with the same arguments.
+ */
+void HeapRemoveTracer(Heap* heap, HeapTracer tracer, void* context);
+
+/**
+ * @brief Set how many bytes may be allocated between collections. The heap is also allowed to
+ * double in size, whichever is more. Zero collects before every allocation, which is useful for
+ * testing that everything in use is reachable from the roots.
+ */
+void HeapSetThreshold(Heap* heap, size_t bytes);
+
+/**
+ * @brief Collect garbage now.
+ */
+void CollectGarbage(Heap* heap);
+
+/**
+ * @brief Returns how many objects the heap currently holds, reachable or not.
+ */
+size_t HeapObjectCount(const Heap* heap);
+
+/**
+ * @brief Returns the most objects the heap has held at once.
+ */
+size_t HeapPeakObjectCount(const Heap* heap);
+
+/**
+ * @private
+ *
+ * Returns a number greater than any this heap returned before, for versioning objects in a way
+ * that survives their memory being reused by another object.
+ */
+MONKEY_INTERNAL uint64_t HeapNextVersion(Heap* heap);
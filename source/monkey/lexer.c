@@ -1,10 +1,17 @@
 #include "monkey/lexer.h"
 
 #include "monkey.h"
+#include "monkey/arena.h"
+#include "monkey/location.h"
 #include "monkey/macros.h"
+#include "monkey/scan.h"
+#include "monkey/stream.h"
 #include "monkey/string.h"
+#include "monkey/symbol.h"
 #include "monkey/token.h"
+#include "span.h"
 
+#include <hedley.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
@@ -12,15 +19,83 @@
 
 struct Lexer {
 	Monkey* monkey;
+	/**
+	 * @brief input is the whole text, or the window onto the stream when there is one.
+	 */
 	const char* input;
 	size_t inputLength;
 	uint64_t position;
 	uint64_t readPosition;
 	char ch;
+	const Scanner* scanner;
+	/**
+	 * @brief tokenStart is where in input the token being lexed starts.
+	 */
+	size_t tokenStart;
+	/**
+	 * @brief lines indexes the input, which for text in memory only happens once a location is
+	 * asked for.
+	 */
+	LineIndex* lines;
+
+	// The rest is only used when lexing a stream.
+	Stream* stream;
+	/**
+	 * @brief window holds the text from the start of the current token up to as much of the
+	 * stream as has been read.
+	 */
+	char* window;
+	size_t windowCapacity;
+	/**
+	 * @brief windowOffset is the offset in the stream of the start of the window.
+	 */
+	size_t windowOffset;
+	bool streamEnded;
+	/**
+	 * @brief arena holds the literals that cannot point anywhere more permanent than the window.
+	 */
+	Arena* arena;
 };
 
+/**
+ * @private
+ *
+ * Slide the current token to the front of the window and read the next chunk of the stream after
+ * it, growing the window when the token alone fills it.
+ *
+ * @return whether any more text was read
+ */
+HEDLEY_NEVER_INLINE MONKEY_FILE_LOCAL bool refill(Lexer* lexer) {
+	if (lexer->stream == NULL || lexer->streamEnded) {
+		return false;
+	}
+	size_t done = lexer->tokenStart;
+	size_t kept = lexer->inputLength - done;
+	memmove(lexer->window, lexer->window + done, kept);
+	lexer->windowOffset += done;
+	lexer->tokenStart = 0;
+	lexer->position -= done;
+	lexer->readPosition -= done;
+	if (kept == lexer->windowCapacity) {
+		lexer->windowCapacity *= 2;
+		lexer->window = realloc(lexer->window, lexer->windowCapacity);
+		lexer->input = lexer->window;
+	}
+
+	int64_t read = ReadStream(lexer->stream, lexer->window + kept, lexer->windowCapacity - kept);
+	if (read <= 0) {
+		lexer->streamEnded = true;
+		lexer->inputLength = kept;
+		return false;
+	}
+	// the text is gone once the window moves on, so it is indexed as it arrives
+	LineIndexAdd(lexer->lines, lexer->window + kept, (size_t)read);
+	lexer->inputLength = kept + (size_t)read;
+	return true;
+}
+
 MONKEY_FILE_LOCAL char peekChar(Lexer* lexer) {
-	if (lexer->readPosition >= lexer->inputLength) {
+	if (HEDLEY_UNLIKELY(lexer->readPosition >= lexer->inputLength) && !refill(lexer)) {
 		return 0;
 	}
 	return lexer->input[lexer->readPosition];
@@ -34,21 +109,39 @@ MONKEY_FILE_LOCAL void readChar(Lexer* lexer) {
 
 /**
  * @private
+ *
+ * Point the literal of a token lexed from a stream somewhere that outlives the window: the name of
+ * its symbol, the text of its type for operators and punctuation, or else a copy in the arena.
+ *
+ * The window may have moved while looking past the token, so its text is found from tokenStart.
  */
-typedef struct {
-	TokenType type;
-	char literal;
-} NewTokenArgs;
+HEDLEY_NEVER_INLINE MONKEY_FILE_LOCAL void detachLiteral(Lexer* lexer, Token* token) {
+	if (token->symbol != NULL) {
+		token->literal = token->symbol->name;
+	} else if (token->type == TOKEN_TYPE_INT || token->type == TOKEN_TYPE_ILLEGAL) {
+		const char* copy =
+				ArenaCopy(lexer->arena, lexer->input + lexer->tokenStart, token->literal.length);
+		token->literal = (MonkeyStringView)SPAN_WITH_LENGTH(copy, token->literal.length);
+	} else {
+		token->literal = (MonkeyStringView)SPAN_WITH_LENGTH(
+				TokenTypeText(token->type), token->literal.length);
+	}
+}
 
-MONKEY_FILE_LOCAL Token newToken(NewTokenArgs args) {
+MONKEY_FILE_LOCAL Token newToken(Lexer* lexer, TokenType type) {
 	Token token;
-	token.type = args.type;
-	token.literal = malloc(sizeof(char) * 2);
-	token.literal[0] = args.literal;
-	token.literal[1] = '\0';
+	token.type = type;
+	token.symbol = NULL;
+	token.literal = (MonkeyStringView)SPAN_WITH_LENGTH(
+			lexer->input + lexer->tokenStart, lexer->readPosition - lexer->tokenStart);
+	token.offset = lexer->windowOffset + lexer->tokenStart;
 	return token;
 }
 
+MONKEY_FILE_LOCAL bool isWhitespace(char ch) {
+	return ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r';
+}
+
 MONKEY_FILE_LOCAL bool isLetter(char ch) {
 	return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || ch == '_';
 }
@@ -57,115 +150,208 @@ MONKEY_FILE_LOCAL bool isDigit(char ch) {
 	return ch >= '0' && ch <= '9';
 }
 
-MONKEY_FILE_LOCAL char* readIdentifier(Lexer* lexer) {
-	size_t position = lexer->position;
-	while (isLetter(lexer->ch)) {
-		readChar(lexer);
+/**
+ * @private
+ *
+ * Runs up to this long are checked in place, since most tokens and gaps between them are short
+ * enough that calling out to a vectorized scanner would cost more than it saves.
+ */
+#define SHORT_RUN 8
+
+/**
+ * @private
+ *
+ * Returns the length of the run of characters in a class at the start of text.
+ */
+HEDLEY_ALWAYS_INLINE MONKEY_FILE_LOCAL size_t scanRun(
+		const char* text, size_t available, bool (*inClass)(char), ScanFn scan) {
+	size_t length = 0;
+	while (length < SHORT_RUN && length < available && inClass(text[length])) {
+		++length;
 	}
-	return MonkeyStrndup(lexer->input + position, lexer->position - position);
+	if (length == SHORT_RUN) {
+		length += scan(text + length, available - length);
+	}
+	return length;
 }
 
-MONKEY_FILE_LOCAL char* readNumber(Lexer* lexer) {
-	size_t position = lexer->position;
-	while (isDigit(lexer->ch)) {
-		readChar(lexer);
+/**
+ * @private
+ *
+ * Carry on a run that reached the end of the window into the next chunks of the stream. Unless the
+ * run is kept, the part of it already scanned is let go of before each chunk is read, so that the
+ * window does not grow to hold it.
+ *
+ * @return the length of the run from the current position
+ */
+HEDLEY_NEVER_INLINE MONKEY_FILE_LOCAL size_t continueRun(
+		Lexer* lexer, size_t length, ScanFn scan, bool keep) {
+	while (lexer->position + length >= lexer->inputLength) {
+		if (!keep) {
+			lexer->position += length;
+			lexer->tokenStart = lexer->position;
+			length = 0;
+		}
+		if (!refill(lexer)) {
+			break;
+		}
+		size_t end = lexer->position + length;
+		length += scan(lexer->input + end, lexer->inputLength - end);
 	}
-	return MonkeyStrndup(lexer->input + position, lexer->position - position);
+	return length;
 }
 
-MONKEY_FILE_LOCAL void skipWhitespace(Lexer* lexer) {
-	while (lexer->ch == ' ' || lexer->ch == '\t' || lexer->ch == '\n' || lexer->ch == '\r') {
-		readChar(lexer);
+/**
+ * @private
+ *
+ * Move past the run of characters in a class starting at the current one, leaving the lexer on the
+ * first character after it.
+ *
+ * @return the run, which is only all of it when keep is set
+ */
+HEDLEY_ALWAYS_INLINE MONKEY_FILE_LOCAL MonkeyStringView readRun(
+		Lexer* lexer, bool (*inClass)(char), ScanFn scan, bool keep) {
+	size_t length = 0;
+	if (lexer->position < lexer->inputLength) {
+		length = scanRun(lexer->input + lexer->position, lexer->inputLength - lexer->position,
+				inClass, scan);
 	}
+	if (HEDLEY_UNLIKELY(lexer->position + length >= lexer->inputLength) && lexer->stream != NULL) {
+		length = continueRun(lexer, length, scan, keep);
+	}
+	size_t start = lexer->position;
+	size_t end = start + length;
+	lexer->position = end;
+	lexer->readPosition = end + 1;
+	lexer->ch = end < lexer->inputLength ? lexer->input[end] : '\0';
+	return (MonkeyStringView)SPAN_WITH_LENGTH(lexer->input + start, length);
+}
+
+MONKEY_FILE_LOCAL MonkeyStringView readIdentifier(Lexer* lexer) {
+	return readRun(lexer, isLetter, lexer->scanner->letters, true);
+}
+
+MONKEY_FILE_LOCAL MonkeyStringView readNumber(Lexer* lexer) {
+	return readRun(lexer, isDigit, lexer->scanner->digits, true);
 }
 
-#define NEW_TOKEN(...) newToken((NewTokenArgs){__VA_ARGS__})
+MONKEY_FILE_LOCAL void skipWhitespace(Lexer* lexer) {
+	readRun(lexer, isWhitespace, lexer->scanner->whitespace, false);
+}
 
 Lexer* CreateLexer(Monkey* monkey, const char* input) {
-	Lexer* lexer = malloc(sizeof(Lexer));
+	return CreateLexerFromView(monkey, (MonkeyStringView)SPAN_WITH_LENGTH(input, strlen(input)));
+}
+
+Lexer* CreateLexerFromView(Monkey* monkey, MonkeyStringView input) {
+	Lexer* lexer = calloc(1, sizeof(Lexer));
 	lexer->monkey = monkey;
-	lexer->input = input;
-	lexer->inputLength = strlen(input);
-	lexer->position = 0;
-	lexer->readPosition = 0;
-	lexer->ch = '\0';
+	lexer->input = input.begin;
+	lexer->inputLength = input.length;
+	lexer->scanner = GetScanner();
 	readChar(lexer);
 	return lexer;
 }
 
-Token LexerNextToken(Lexer* lexer) {
+Lexer* CreateStreamLexer(Monkey* monkey, Stream* input, size_t chunkSize) {
+	Lexer* lexer = calloc(1, sizeof(Lexer));
+	lexer->monkey = monkey;
+	lexer->scanner = GetScanner();
+	lexer->stream = input;
+	lexer->windowCapacity = chunkSize;
+	lexer->window = malloc(chunkSize);
+	lexer->input = lexer->window;
+	lexer->arena = CreateArena();
+	lexer->lines = CreateLineIndex();
+	readChar(lexer);
+	return lexer;
+}
+
+Arena* LexerArena(Lexer* lexer) {
+	return lexer->arena;
+}
+
+MONKEY_FILE_LOCAL Token lexToken(Lexer* lexer) {
 	Token tok;
 
+	lexer->tokenStart = lexer->position;
 	skipWhitespace(lexer);
+	lexer->tokenStart = lexer->position;
 
 	switch (lexer->ch) {
 		case '=':
 			if (peekChar(lexer) == '=') {
 				readChar(lexer);
-				tok = (Token){.type = TOKEN_TYPE_EQ, .literal = MonkeyStrdup("==")};
+				tok = newToken(lexer, TOKEN_TYPE_EQ);
 			} else {
-				tok = NEW_TOKEN(.type = TOKEN_TYPE_ASSIGN, .literal = lexer->ch);
+				tok = newToken(lexer, TOKEN_TYPE_ASSIGN);
 			}
 			break;
 		case '!':
 			if (peekChar(lexer) == '=') {
 				readChar(lexer);
-				tok = (Token){.type = TOKEN_TYPE_NOT_EQ, .literal = MonkeyStrdup("!=")};
+				tok = newToken(lexer, TOKEN_TYPE_NOT_EQ);
 			} else {
-				tok = NEW_TOKEN(.type = TOKEN_TYPE_BANG, .literal = lexer->ch);
+				tok = newToken(lexer, TOKEN_TYPE_BANG);
 			}
 			break;
 		case ';':
-			tok = NEW_TOKEN(.type = TOKEN_TYPE_SEMICOLON, .literal = lexer->ch);
+			tok = newToken(lexer, TOKEN_TYPE_SEMICOLON);
 			break;
 		case '(':
-			tok = NEW_TOKEN(.type = TOKEN_TYPE_LPAREN, .literal = lexer->ch);
+			tok = newToken(lexer, TOKEN_TYPE_LPAREN);
 			break;
 		case ')':
-			tok = NEW_TOKEN(.type = TOKEN_TYPE_RPAREN, .literal = lexer->ch);
+			tok = newToken(lexer, TOKEN_TYPE_RPAREN);
 			break;
 		case ',':
-			tok = NEW_TOKEN(.type = TOKEN_TYPE_COMMA, .literal = lexer->ch);
+			tok = newToken(lexer, TOKEN_TYPE_COMMA);
 			break;
 		case '+':
-			tok = NEW_TOKEN(.type = TOKEN_TYPE_PLUS, .literal = lexer->ch);
+			tok = newToken(lexer, TOKEN_TYPE_PLUS);
 			break;
 		case '{':
-			tok = NEW_TOKEN(.type = TOKEN_TYPE_LBRACE, .literal = lexer->ch);
+			tok = newToken(lexer, TOKEN_TYPE_LBRACE);
 			break;
 		case '}':
-			tok = NEW_TOKEN(.type = TOKEN_TYPE_RBRACE, .literal = lexer->ch);
+			tok = newToken(lexer, TOKEN_TYPE_RBRACE);
 			break;
 		case '-':
-			tok = NEW_TOKEN(.type = TOKEN_TYPE_MINUS, .literal = lexer->ch);
+			tok = newToken(lexer, TOKEN_TYPE_MINUS);
 			break;
 		case '*':
-			tok = NEW_TOKEN(.type = TOKEN_TYPE_ASTERISK, .literal = lexer->ch);
+			tok = newToken(lexer, TOKEN_TYPE_ASTERISK);
 			break;
 		case '/':
-			tok = NEW_TOKEN(.type = TOKEN_TYPE_SLASH, .literal = lexer->ch);
+			tok = newToken(lexer, TOKEN_TYPE_SLASH);
 			break;
 		case '<':
-			tok = NEW_TOKEN(.type = TOKEN_TYPE_LT, .literal = lexer->ch);
+			tok = newToken(lexer, TOKEN_TYPE_LT);
 			break;
 		case '>':
-			tok = NEW_TOKEN(.type = TOKEN_TYPE_GT, .literal = lexer->ch);
+			tok = newToken(lexer, TOKEN_TYPE_GT);
 			break;
 		case 0:
 			tok.type = TOKEN_TYPE_END_OF_FILE;
-			tok.literal = MonkeyStrdup("");
-			break;
+			tok.symbol = NULL;
+			tok.literal = (MonkeyStringView)SPAN_WITH_LENGTH(lexer->input + lexer->inputLength, 0);
+			tok.offset = lexer->windowOffset + lexer->inputLength;
+			return tok;
 		default:
 			if (isLetter(lexer->ch)) {
 				tok.literal = readIdentifier(lexer);
-				tok.type = LookupIdent(lexer->monkey, tok.literal);
+				tok.symbol = MonkeyIntern(lexer->monkey, tok.literal);
+				tok.type = tok.symbol->tokenType;
+				tok.offset = lexer->windowOffset + lexer->tokenStart;
 				return tok;
 			} else if (isDigit(lexer->ch)) {
 				tok.type = TOKEN_TYPE_INT;
+				tok.symbol = NULL;
 				tok.literal = readNumber(lexer);
+				tok.offset = lexer->windowOffset + lexer->tokenStart;
 				return tok;
 			} else {
-				tok = NEW_TOKEN(.type = TOKEN_TYPE_ILLEGAL, .literal = lexer->ch);
+				tok = newToken(lexer, TOKEN_TYPE_ILLEGAL);
 			}
 			break;
 	}
@@ -174,6 +360,34 @@ Token LexerNextToken(Lexer* lexer) {
 	return tok;
 }
 
+SourceLocation LexerLocate(Lexer* lexer, size_t offset) {
+	if (lexer->lines == NULL) {
+		lexer->lines = CreateLineIndex();
+	}
+	size_t indexed = LineIndexLength(lexer->lines);
+	if (lexer->stream == NULL && offset > indexed) {
+		size_t end = offset < lexer->inputLength ? offset : lexer->inputLength;
+		LineIndexAdd(lexer->lines, lexer->input + indexed, end - indexed);
+	}
+	return LineIndexLocate(lexer->lines, offset);
+}
+
+Token LexerNextToken(Lexer* lexer) {
+	if (HEDLEY_LIKELY(lexer->stream == NULL)) {
+		return lexToken(lexer);
+	}
+	Token token = lexToken(lexer);
+	detachLiteral(lexer, &token);
+	return token;
+}
+
 void DestroyLexer(Lexer* lexer) {
+	free(lexer->window);
+	if (lexer->lines != NULL) {
+		DestroyLineIndex(lexer->lines);
+	}
+	if (lexer->arena != NULL) {
+		ReleaseArena(lexer->arena);
+	}
 	free(lexer);
 }
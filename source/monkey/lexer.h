@@ -1,6 +1,11 @@
 #pragma once
 
 #include "monkey.h"
+#include "monkey/arena.h"
+#include "monkey/location.h"
+#include "monkey/macros.h"
+#include "monkey/stream.h"
+#include "monkey/string.h"
 #include "monkey/token.h"
 
 #include <stddef.h>
@@ -18,6 +23,40 @@ typedef struct Lexer Lexer;
  */
 Lexer* CreateLexer(Monkey* monkey, const char* input);
 
+/**
+ * @brief Creates a new lexer over input that need not be NUL-terminated, like a mapped file.
+ * @param input The input to lex, which must outlive the tokens.
+ * @return A new lexer.
+ */
+Lexer* CreateLexerFromView(Monkey* monkey, MonkeyStringView input);
+
+/**
+ * @brief LEXER_CHUNK_SIZE is a reasonable number of bytes for a stream lexer to read at a time.
+ */
+#define LEXER_CHUNK_SIZE ((size_t)16 << 10U)
+
+/**
+ * @brief Creates a new lexer that reads its input from a stream as it goes.
+ *
+ * Only the token being lexed is kept in memory, in a window that holds chunkSize bytes and grows
+ * if a single token is longer than that. Token literals are moved out of the window once a token
+ * is complete, so tokens (and the AST parsed from them) stay valid after the lexer moves on.
+ *
+ * @param input The stream to read from, which the lexer does not close.
+ * @param chunkSize How many bytes to read from the stream at a time (at least one), like
+ * LEXER_CHUNK_SIZE.
+ * @return A new lexer.
+ */
+Lexer* CreateStreamLexer(Monkey* monkey, Stream* input, size_t chunkSize);
+
+/**
+ * @private
+ *
+ * Returns the arena that a stream lexer keeps literals in, or NULL for a lexer over text in
+ * memory. Whatever keeps tokens from a stream lexer must retain it.
+ */
+MONKEY_INTERNAL Arena* LexerArena(Lexer* lexer);
+
 /**
  * @brief LexerNextToken gets the next token from the lexer.
  * @param lexer The lexer to get the next token from.
@@ -25,6 +64,18 @@ Lexer* CreateLexer(Monkey* monkey, const char* input);
  */
 Token LexerNextToken(Lexer* lexer);
 
+/**
+ * @brief LexerLocate finds the line and column of a token offset.
+ *
+ * Lexers over text in memory only index its lines the first time this is called, so that locations
+ * cost nothing until something (usually an error) needs one.
+ *
+ * @param lexer The lexer the offset came from.
+ * @param offset The offset of a token.
+ * @return The location of the offset.
+ */
+SourceLocation LexerLocate(Lexer* lexer, size_t offset);
+
 /**
  * @brief DestroyLexer destroys a lexer.
  * @param lexer The lexer to destroy.
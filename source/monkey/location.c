@@ -0,0 +1,58 @@
+#include "monkey/location.h"
+
+#include "buffer.h"
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct LineIndex {
+	/**
+	 * @brief lineStarts holds the offset of the start of every line, in order.
+	 */
+	BUFFER_TYPE(size_t) lineStarts;
+	size_t length;
+};
+
+LineIndex* CreateLineIndex(void) {
+	LineIndex* index = calloc(1, sizeof(LineIndex));
+	BUFFER_PUSH(&index->lineStarts, 0);
+	return index;
+}
+
+void LineIndexAdd(LineIndex* index, const char* text, size_t length) {
+	const char* end = text + length;
+	const char* newline = memchr(text, '\n', length);
+	while (newline != NULL) {
+		BUFFER_PUSH(&index->lineStarts, index->length + (size_t)(newline - text) + 1);
+		newline = memchr(newline + 1, '\n', (size_t)(end - newline - 1));
+	}
+	index->length += length;
+}
+
+size_t LineIndexLength(const LineIndex* index) {
+	return index->length;
+}
+
+SourceLocation LineIndexLocate(const LineIndex* index, size_t offset) {
+	// find the last line that starts at or before the offset
+	size_t low = 0;
+	size_t high = index->lineStarts.length;
+	while (high - low > 1) {
+		size_t middle = low + (high - low) / 2;
+		if (index->lineStarts.data[middle] <= offset) {
+			low = middle;
+		} else {
+			high = middle;
+		}
+	}
+	return (SourceLocation){
+			.line = low + 1,
+			.column = offset - index->lineStarts.data[low] + 1,
+	};
+}
+
+void DestroyLineIndex(LineIndex* index) {
+	BUFFER_FREE(index->lineStarts);
+	free(index);
+}
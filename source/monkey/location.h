@@ -0,0 +1,53 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief SourceLocation is a position in source text as people count it: the line and column both
+ * start at one, and columns are counted in bytes.
+ */
+typedef struct {
+	size_t line;
+	size_t column;
+} SourceLocation;
+
+/**
+ * @brief NO_SOURCE_OFFSET is the offset of things that do not come from anywhere in the source.
+ */
+#define NO_SOURCE_OFFSET SIZE_MAX
+
+/**
+ * @brief LineIndex records where each line of a text starts, so that byte offsets (which is all
+ * tokens carry) can be turned into locations when they have to be shown.
+ */
+typedef struct LineIndex LineIndex;
+
+/**
+ * @brief Create an index of a text with nothing added to it yet.
+ */
+LineIndex* CreateLineIndex(void);
+
+/**
+ * @brief Add the next part of the text to an index.
+ *
+ * @param index the index
+ * @param text the text following whatever was added before
+ * @param length the length of text
+ */
+void LineIndexAdd(LineIndex* index, const char* text, size_t length);
+
+/**
+ * @brief Returns how much of the text has been added to an index.
+ */
+size_t LineIndexLength(const LineIndex* index);
+
+/**
+ * @brief Find the location of a byte offset in the text added to an index so far.
+ */
+SourceLocation LineIndexLocate(const LineIndex* index, size_t offset);
+
+/**
+ * @brief Destroy an index.
+ */
+void DestroyLineIndex(LineIndex* index);
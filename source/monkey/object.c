@@ -1,8 +1,10 @@
 #include "monkey/object.h"
 
 #include "buffer.h"
+#include "monkey/arena.h"
 #include "monkey/ast.h"
 #include "monkey/environment.h"
+#include "monkey/heap.h"
 #include "monkey/macros.h"
 #include "monkey/string.h"
 #include "span.h"
@@ -32,165 +34,107 @@ char* InspectObject(const Object* obj) {
 	if (obj == NULL) {
 		return MonkeyStrdup("<NULL>");
 	}
-	switch (obj->type) {
+	switch (ObjectTypeOf(obj)) {
 		case OBJECT_TYPE_INTEGER:
-			return InspectIntegerObject((const IntegerObject*)obj);
+			return MonkeyAsprintf("%" PRId64, ObjectToInteger(obj));
 		case OBJECT_TYPE_BOOLEAN:
-			return InspectBooleanObject((const BooleanObject*)obj);
+			return MonkeyStrdup(ObjectToBoolean(obj) ? "true" : "false");
 		case OBJECT_TYPE_NULL:
-			return InspectNullObject((const NullObject*)obj);
-		case OBJECT_TYPE_RETURN_VALUE:
-			return InspectReturnValueObject((const ReturnValueObject*)obj);
+			return MonkeyStrdup("null");
 		case OBJECT_TYPE_ERROR:
 			return InspectErrorObject((const ErrorObject*)obj);
 		case OBJECT_TYPE_FUNCTION:
 			return InspectFunctionObject((const FunctionObject*)obj);
+		case OBJECT_TYPE_COMPILED_FUNCTION:
+			return InspectCompiledFunctionObject((const CompiledFunctionObject*)obj);
+		case OBJECT_TYPE_CLOSURE:
+			return InspectClosureObject((const ClosureObject*)obj);
+		case OBJECT_TYPE_ENVIRONMENT:
+			return MonkeyStrdup("<environment>");
 	}
 	(void)fprintf(stderr, "Unknown object type: %d\n", obj->type);
 	assert(false);
 }
 
-void DestroyObject(Object* obj) {
-	if (obj == NULL) {
-		return;
-	}
-	if (obj->freeable == OBJECT_DISALLOW_FREE) {
-		return;
-	}
+void TraceObject(Heap* heap, Object* obj) {
 	switch (obj->type) {
-		case OBJECT_TYPE_INTEGER:
-			DestroyIntegerObject((IntegerObject*)obj);
-			return;
-		case OBJECT_TYPE_BOOLEAN:
-			DestroyBooleanObject((BooleanObject*)obj);
+		case OBJECT_TYPE_FUNCTION:
+			HeapMark(heap, (Object*)((FunctionObject*)obj)->env);
 			return;
-		case OBJECT_TYPE_NULL:
-			DestroyNullObject((NullObject*)obj);
+		case OBJECT_TYPE_CLOSURE: {
+			ClosureObject* closure = (ClosureObject*)obj;
+			HeapMark(heap, &closure->function->base);
+			for (size_t i = 0; i < closure->freeVariables.length; ++i) {
+				HeapMark(heap, closure->freeVariables.begin[i]);
+			}
 			return;
-		case OBJECT_TYPE_RETURN_VALUE:
-			DestroyReturnValueObject((ReturnValueObject*)obj);
+		}
+		case OBJECT_TYPE_ENVIRONMENT:
+			TraceEnvironment(heap, (Environment*)obj);
 			return;
+		case OBJECT_TYPE_INTEGER:
+		case OBJECT_TYPE_BOOLEAN:
+		case OBJECT_TYPE_NULL:
 		case OBJECT_TYPE_ERROR:
-			DestroyErrorObject((ErrorObject*)obj);
-			return;
-		case OBJECT_TYPE_FUNCTION:
-			DestroyFunctionObject((FunctionObject*)obj);
+		case OBJECT_TYPE_COMPILED_FUNCTION:
 			return;
 	}
 	(void)fprintf(stderr, "Unknown object type: %d\n", obj->type);
 	assert(false);
 }
 
-MONKEY_FILE_LOCAL FunctionObject* rawCreateFunctionObject(FunctionAstOwnership astOwnership,
-		IdentifierSpan parameters, BlockStatement* body, Environment* env) {
-	FunctionObject* obj = malloc(sizeof(FunctionObject));
-	obj->base.type = OBJECT_TYPE_FUNCTION;
-	obj->base.freeable = OBJECT_ALLOW_FREE;
-	obj->astOwnership = astOwnership;
-	obj->parameters = parameters;
-	obj->body = body;
-	obj->env = env;
-	return obj;
-}
-
-MONKEY_FILE_LOCAL FunctionObject* copyFunctionObject(FunctionObject* obj) {
-	return rawCreateFunctionObject(
-			FUNCTION_AST_BORROWED, obj->parameters, obj->body, CopyEnvironment(obj->env));
+MONKEY_FILE_LOCAL size_t freeFunctionObject(FunctionObject* obj) {
+	ReleaseArena(obj->arena);
+	return sizeof(FunctionObject);
 }
 
-Object* CopyObject(Object* obj) {
-	if (obj->freeable == OBJECT_DISALLOW_FREE) {
-		return obj;
+MONKEY_FILE_LOCAL size_t freeCompiledFunctionObject(CompiledFunctionObject* obj) {
+	free(obj->instructions.begin);
+	for (size_t i = 0; i < obj->localNames.length; ++i) {
+		free(obj->localNames.begin[i]);
 	}
+	free(obj->localNames.begin);
+	free(obj->text);
+	return sizeof(CompiledFunctionObject);
+}
 
+size_t FreeObject(Object* obj) {
 	switch (obj->type) {
 		case OBJECT_TYPE_INTEGER:
-			return (Object*)CreateIntegerObject(((IntegerObject*)obj)->value);
+			return sizeof(IntegerObject);
 		case OBJECT_TYPE_BOOLEAN:
-			return (Object*)CreateBooleanObject(((BooleanObject*)obj)->value);
 		case OBJECT_TYPE_NULL:
-			return (Object*)CreateNullObject();
-		case OBJECT_TYPE_RETURN_VALUE:
-			return (Object*)CreateReturnValueObject(CopyObject(((ReturnValueObject*)obj)->value));
+			// always immediate
+			break;
 		case OBJECT_TYPE_ERROR:
-			return (Object*)CreateErrorObject(MonkeyStrdup(((ErrorObject*)obj)->message));
+			free(((ErrorObject*)obj)->message);
+			return sizeof(ErrorObject);
 		case OBJECT_TYPE_FUNCTION:
-			return (Object*)copyFunctionObject((FunctionObject*)obj);
+			return freeFunctionObject((FunctionObject*)obj);
+		case OBJECT_TYPE_COMPILED_FUNCTION:
+			return freeCompiledFunctionObject((CompiledFunctionObject*)obj);
+		case OBJECT_TYPE_CLOSURE:
+			free(((ClosureObject*)obj)->freeVariables.begin);
+			return sizeof(ClosureObject);
+		case OBJECT_TYPE_ENVIRONMENT:
+			return FreeEnvironment((Environment*)obj);
 	}
 	(void)fprintf(stderr, "Unknown object type: %d\n", obj->type);
 	assert(false);
+	return 0;
 }
 
-IntegerObject* CreateIntegerObject(int64_t value) {
-	IntegerObject* obj = malloc(sizeof(IntegerObject));
-	obj->base.type = OBJECT_TYPE_INTEGER;
-	obj->base.freeable = OBJECT_ALLOW_FREE;
+IntegerObject* CreateIntegerObject(Heap* heap, int64_t value) {
+	IntegerObject* obj =
+			(IntegerObject*)HeapAllocate(heap, OBJECT_TYPE_INTEGER, sizeof(IntegerObject));
 	obj->value = value;
 	return obj;
 }
 
-char* InspectIntegerObject(const IntegerObject* obj) {
-	return MonkeyAsprintf("%" PRId64, obj->value);
-}
-
-void DestroyIntegerObject(IntegerObject* obj) {
-	free(obj);
-}
-
-BooleanObject* CreateBooleanObject(bool value) {
-	BooleanObject* obj = malloc(sizeof(BooleanObject));
-	obj->base.type = OBJECT_TYPE_BOOLEAN;
-	obj->base.freeable = OBJECT_ALLOW_FREE;
-	obj->value = value;
-	return obj;
-}
-
-char* InspectBooleanObject(const BooleanObject* obj) {
-	return MonkeyStrdup(obj->value ? "true" : "false");
-}
-
-void DestroyBooleanObject(BooleanObject* obj) {
-	free(obj);
-}
-
-NullObject* CreateNullObject(void) {
-	NullObject* obj = malloc(sizeof(NullObject));
-	obj->base.type = OBJECT_TYPE_NULL;
-	obj->base.freeable = OBJECT_ALLOW_FREE;
-	return obj;
-}
-
-char* InspectNullObject(const NullObject* obj) {
-	(void)obj;
-	return MonkeyStrdup("null");
-}
-
-void DestroyNullObject(NullObject* obj) {
-	free(obj);
-}
-
-ReturnValueObject* CreateReturnValueObject(Object* value) {
-	ReturnValueObject* obj = malloc(sizeof(ReturnValueObject));
-	obj->base.type = OBJECT_TYPE_RETURN_VALUE;
-	obj->base.freeable = OBJECT_ALLOW_FREE;
-	obj->value = value;
-	return obj;
-}
-
-char* InspectReturnValueObject(const ReturnValueObject* obj) {
-	return InspectObject(obj->value);
-}
-
-void DestroyReturnValueObject(ReturnValueObject* obj) {
-	DestroyObject(obj->value);
-	free(obj);
-}
-
-ErrorObject* CreateErrorObject(char* message) {
-	ErrorObject* obj = malloc(sizeof(ErrorObject));
-	obj->base.type = OBJECT_TYPE_ERROR;
-	obj->base.freeable = OBJECT_ALLOW_FREE;
+ErrorObject* CreateErrorObject(Heap* heap, char* message, size_t offset) {
+	ErrorObject* obj = (ErrorObject*)HeapAllocate(heap, OBJECT_TYPE_ERROR, sizeof(ErrorObject));
 	obj->message = message;
+	obj->offset = offset;
 	return obj;
 }
 
@@ -198,47 +142,61 @@ char* InspectErrorObject(const ErrorObject* obj) {
 	return MonkeyAsprintf("ERROR: %s", obj->message);
 }
 
-void DestroyErrorObject(ErrorObject* obj) {
-	free(obj->message);
-	free(obj);
-}
-
-FunctionObject* CreateFunctionObject(FunctionLiteral* func, Environment* env) {
+FunctionObject* CreateFunctionObject(Heap* heap, const FunctionLiteral* func, Environment* env) {
 	FunctionObject* obj =
-			rawCreateFunctionObject(FUNCTION_AST_OWNED, func->parameters, func->body, env);
-	func->parameters = (IdentifierSpan)SPAN_EMPTY;
-	func->body = NULL;
+			(FunctionObject*)HeapAllocate(heap, OBJECT_TYPE_FUNCTION, sizeof(FunctionObject));
+	obj->parameters = func->parameters;
+	obj->body = func->body;
+	obj->slotCount = func->slotCount;
+	obj->env = env;
+	obj->arena = RetainArena(func->arena);
 	return obj;
 }
 
 char* InspectFunctionObject(const FunctionObject* obj) {
-	MonkeyStringBuffer out = BUFFER_INIT;
-	BUFFER_PUSH(&out, MonkeyStrdup("fn("));
-	for (size_t i = 0; i < obj->parameters.length; ++i) {
+	return InspectFunctionParts(obj->parameters, obj->body);
+}
+
+char* InspectFunctionParts(IdentifierSpan parameters, const BlockStatement* body) {
+	MonkeyStringBuilder out = BUFFER_INIT;
+	MonkeyStringBuilderAppend(&out, "fn(");
+	for (size_t i = 0; i < parameters.length; ++i) {
 		if (i > 0) {
-			BUFFER_PUSH(&out, MonkeyStrdup(", "));
+			MonkeyStringBuilderAppend(&out, ", ");
 		}
-		BUFFER_PUSH(&out, IdentifierString(obj->parameters.begin[i]));
+		MonkeyStringBuilderAppendView(&out, parameters.begin[i]->value);
 	}
-	BUFFER_PUSH(&out, MonkeyStrdup(") {\n"));
-	BUFFER_PUSH(&out, BlockStatementString(obj->body));
-	BUFFER_PUSH(&out, MonkeyStrdup("\n}"));
-	char* result = MonkeyStringJoin((MonkeyStringSpan)BUFFER_AS_SPAN(out));
-	for (size_t i = 0; i < out.length; ++i) {
-		free(out.data[i]);
-	}
-	BUFFER_FREE(out);
-	return result;
+	MonkeyStringBuilderAppend(&out, ") {\n");
+	AppendStatementString(&out, &body->base);
+	MonkeyStringBuilderAppend(&out, "\n}");
+	return MonkeyStringBuilderFinish(&out);
+}
+
+CompiledFunctionObject* CreateCompiledFunctionObject(Heap* heap, Instructions instructions,
+		size_t numParameters, MonkeyStringSpan localNames, char* text) {
+	CompiledFunctionObject* obj = (CompiledFunctionObject*)HeapAllocate(
+			heap, OBJECT_TYPE_COMPILED_FUNCTION, sizeof(CompiledFunctionObject));
+	obj->instructions = (InstructionSpan)BUFFER_AS_SPAN(instructions);
+	obj->numLocals = localNames.length;
+	obj->numParameters = numParameters;
+	obj->localNames = localNames;
+	obj->text = text;
+	return obj;
 }
 
-void DestroyFunctionObject(FunctionObject* obj) {
-	if (obj->astOwnership == FUNCTION_AST_OWNED) {
-		for (size_t i = 0; i < obj->parameters.length; ++i) {
-			DestroyIdentifier(obj->parameters.begin[i]);
-		}
-		free(obj->parameters.begin);
-		DestroyBlockStatement(obj->body);
-	}
-	DestroyEnvironment(obj->env);
-	free(obj);
+char* InspectCompiledFunctionObject(const CompiledFunctionObject* obj) {
+	return MonkeyStrdup(obj->text);
+}
+
+ClosureObject* CreateClosureObject(
+		Heap* heap, CompiledFunctionObject* function, ObjectSpan freeVariables) {
+	ClosureObject* obj =
+			(ClosureObject*)HeapAllocate(heap, OBJECT_TYPE_CLOSURE, sizeof(ClosureObject));
+	obj->function = function;
+	obj->freeVariables = freeVariables;
+	return obj;
+}
+
+char* InspectClosureObject(const ClosureObject* obj) {
+	return InspectCompiledFunctionObject(obj->function);
 }
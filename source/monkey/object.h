@@ -1,18 +1,29 @@
 #pragma once
 
+#include "monkey/arena.h"
 #include "monkey/ast.h"
+#include "monkey/code.h"
+#include "monkey/location.h"
+#include "monkey/macros.h"
+#include "monkey/string.h"
 #include "span.h"
 
 #include <stdbool.h>
 #include <stdint.h>
 
+/**
+ * ENVIRONMENT is never a Monkey value. Environments are objects so that the garbage collector can
+ * manage them along with the values they hold.
+ */
 #define OBJECT_TYPES_X \
 	X(INTEGER) \
 	X(BOOLEAN) \
 	X(NULL) \
-	X(RETURN_VALUE) \
 	X(ERROR) \
-	X(FUNCTION)
+	X(FUNCTION) \
+	X(COMPILED_FUNCTION) \
+	X(CLOSURE) \
+	X(ENVIRONMENT)
 
 typedef enum {
 #define X(x) OBJECT_TYPE_##x,
@@ -22,93 +33,211 @@ typedef enum {
 
 const char* ObjectTypeText(ObjectType type);
 
-typedef enum {
-	OBJECT_ALLOW_FREE,
-	OBJECT_DISALLOW_FREE,
-} ObjectFreeableType;
+// avoid cyclic include with heap.h here
+typedef struct Heap Heap;
 
+/**
+ * @brief Object is the header of every value that is not an immediate.
+ *
+ * Objects are allocated from a Heap and freed by its garbage collector, never by hand, so they
+ * can be shared freely by pointer.
+ */
 typedef struct Object {
+	/**
+	 * @brief type is only valid for heap objects, use ObjectTypeOf to also handle immediates.
+	 */
 	ObjectType type;
 	/**
-	 * @brief freeable is used to determine if the object should be freed when
-	 * DestroyObject is called.
-	 *
-	 * It is always OBJECT_ALLOW_FREE by default.
-	 * Will be set to OBJECT_DISALLOW_FREE if the object is not freeable
-	 * (the usual case is when the object is a boolean or null).
+	 * @brief marked is set while the garbage collector finds the object reachable.
+	 */
+	bool marked;
+	/**
+	 * @brief pinned objects are always reachable.
 	 */
-	ObjectFreeableType freeable;
+	bool pinned;
+	/**
+	 * @brief next links every object of a heap together.
+	 */
+	struct Object* next;
 } Object;
 
 typedef SPAN_TYPE(Object*) ObjectSpan;
 
 char* InspectObject(const Object* obj);
-void DestroyObject(Object* obj);
-Object* CopyObject(Object* obj);
 
+/**
+ * @private
+ *
+ * Marks every object that obj refers to (see HeapMark).
+ */
+MONKEY_INTERNAL void TraceObject(Heap* heap, Object* obj);
+
+/**
+ * @private
+ *
+ * Frees what an object the garbage collector found unreachable owns. The object itself belongs to
+ * the heap, which frees it afterwards.
+ *
+ * @return size_t the number of bytes the object was allocated with
+ */
+MONKEY_INTERNAL size_t FreeObject(Object* obj);
+
+/**
+ * @brief IntegerObject is a boxed integer, used only for values too large to be immediates.
+ */
 typedef struct {
 	Object base;
 	int64_t value;
 } IntegerObject;
 
-IntegerObject* CreateIntegerObject(int64_t value);
-char* InspectIntegerObject(const IntegerObject* obj);
-void DestroyIntegerObject(IntegerObject* obj);
-
-typedef struct {
-	Object base;
-	bool value;
-} BooleanObject;
+IntegerObject* CreateIntegerObject(Heap* heap, int64_t value);
+
+/**
+ * Integers, booleans and null are not allocated: they are encoded in the Object pointer itself.
+ * Heap objects are at least 4-byte aligned, so the low two bits of their address are clear. An
+ * immediate integer has the low bit set and its value in the remaining bits; booleans and null
+ * have the low bits 10. Immediates must never be dereferenced.
+ */
+#define OBJECT_TAG_MASK ((uintptr_t)3)
+#define OBJECT_TAG_INTEGER ((uintptr_t)1)
+#define OBJECT_FALSE_BITS ((uintptr_t)0x2)
+#define OBJECT_TRUE_BITS ((uintptr_t)0x6)
+#define OBJECT_NULL_BITS ((uintptr_t)0xA)
+
+#define OBJECT_IMMEDIATE_INTEGER_MIN (INTPTR_MIN / 2)
+#define OBJECT_IMMEDIATE_INTEGER_MAX (INTPTR_MAX / 2)
+
+/**
+ * @brief Returns whether obj is encoded in the pointer rather than allocated.
+ */
+static inline bool IsImmediateObject(const Object* obj) {
+	return ((uintptr_t)obj & OBJECT_TAG_MASK) != 0;
+}
+
+/**
+ * @brief Returns the type of any object, immediate or not.
+ */
+static inline ObjectType ObjectTypeOf(const Object* obj) {
+	uintptr_t bits = (uintptr_t)obj;
+	if ((bits & OBJECT_TAG_INTEGER) != 0) {
+		return OBJECT_TYPE_INTEGER;
+	}
+	if ((bits & OBJECT_TAG_MASK) != 0) {
+		return bits == OBJECT_NULL_BITS ? OBJECT_TYPE_NULL : OBJECT_TYPE_BOOLEAN;
+	}
+	return obj->type;
+}
+
+/**
+ * @brief Returns an integer object, which is immediate whenever the value fits.
+ */
+static inline Object* IntegerToObject(Heap* heap, int64_t value) {
+	if (value < OBJECT_IMMEDIATE_INTEGER_MIN || value > OBJECT_IMMEDIATE_INTEGER_MAX) {
+		return (Object*)CreateIntegerObject(heap, value);
+	}
+	return (Object*)(((uintptr_t)(intptr_t)value << 1U) | OBJECT_TAG_INTEGER);
+}
+
+/**
+ * @brief Returns the value of an integer object.
+ */
+static inline int64_t ObjectToInteger(const Object* obj) {
+	if (((uintptr_t)obj & OBJECT_TAG_INTEGER) == 0) {
+		return ((const IntegerObject*)obj)->value;
+	}
+	return (int64_t)((intptr_t)(uintptr_t)obj >> 1);
+}
+
+static inline Object* BooleanToObject(bool value) {
+	return (Object*)(value ? OBJECT_TRUE_BITS : OBJECT_FALSE_BITS);
+}
+
+/**
+ * @brief Returns the value of a boolean object.
+ */
+static inline bool ObjectToBoolean(const Object* obj) {
+	return (uintptr_t)obj == OBJECT_TRUE_BITS;
+}
+
+static inline Object* NullToObject(void) {
+	return (Object*)OBJECT_NULL_BITS;
+}
 
-BooleanObject* CreateBooleanObject(bool value);
-char* InspectBooleanObject(const BooleanObject* obj);
-void DestroyBooleanObject(BooleanObject* obj);
-
-typedef struct {
-	Object base;
-} NullObject;
-
-NullObject* CreateNullObject(void);
-char* InspectNullObject(const NullObject* obj);
-void DestroyNullObject(NullObject* obj);
-
-typedef struct {
-	Object base;
-	Object* value;
-} ReturnValueObject;
-
-ReturnValueObject* CreateReturnValueObject(Object* value);
-char* InspectReturnValueObject(const ReturnValueObject* obj);
-void DestroyReturnValueObject(ReturnValueObject* obj);
 
 typedef struct {
 	Object base;
 	char* message;
+	/**
+	 * @brief offset is where in the source the expression that failed starts, or NO_SOURCE_OFFSET
+	 * when that is not known.
+	 */
+	size_t offset;
 } ErrorObject;
 
-ErrorObject* CreateErrorObject(char* message);
+ErrorObject* CreateErrorObject(Heap* heap, char* message, size_t offset);
 char* InspectErrorObject(const ErrorObject* obj);
-void DestroyErrorObject(ErrorObject* obj);
-
-#define FUNCTION_AST_OWNERSHIP_X \
-	X(OWNED) \
-	X(BORROWED)
-
-typedef enum {
-#define X(x) FUNCTION_AST_##x,
-	FUNCTION_AST_OWNERSHIP_X
-#undef X
-} FunctionAstOwnership;
 
+/**
+ * @brief FunctionObject is a function value of the evaluator. It shares the parameters and body of
+ * the literal it was created from, and keeps the arena they live in alive until it is collected.
+ */
 typedef struct {
 	Object base;
-	FunctionAstOwnership astOwnership;
 	IdentifierSpan parameters;
 	BlockStatement* body;
+	size_t slotCount;
+	Arena* arena;
+	/**
+	 * @brief env is the environment the function was created in.
+	 */
 	// avoid cyclic include with environment.h here
 	struct Environment* env;
 } FunctionObject;
 
-FunctionObject* CreateFunctionObject(FunctionLiteral* func, struct Environment* env);
+FunctionObject* CreateFunctionObject(
+		Heap* heap, const FunctionLiteral* func, struct Environment* env);
 char* InspectFunctionObject(const FunctionObject* obj);
-void DestroyFunctionObject(FunctionObject* obj);
+
+/**
+ * @brief Formats a function the way InspectObject shows function values.
+ */
+char* InspectFunctionParts(IdentifierSpan parameters, const BlockStatement* body);
+
+/**
+ * @brief CompiledFunctionObject is the bytecode of a function literal, shared by every closure
+ * made from it.
+ */
+typedef struct {
+	Object base;
+	InstructionSpan instructions;
+	size_t numLocals;
+	size_t numParameters;
+	/**
+	 * @brief localNames holds the name of every local slot, for error messages.
+	 */
+	MonkeyStringSpan localNames;
+	/**
+	 * @brief text is what InspectObject shows for closures of this function.
+	 */
+	char* text;
+} CompiledFunctionObject;
+
+CompiledFunctionObject* CreateCompiledFunctionObject(Heap* heap, Instructions instructions,
+		size_t numParameters, MonkeyStringSpan localNames, char* text);
+char* InspectCompiledFunctionObject(const CompiledFunctionObject* obj);
+
+/**
+ * @brief ClosureObject is a compiled function together with the free variables it captured.
+ */
+typedef struct {
+	Object base;
+	CompiledFunctionObject* function;
+	ObjectSpan freeVariables;
+} ClosureObject;
+
+/**
+ * @brief Create a closure, which takes ownership of the freeVariables array.
+ */
+ClosureObject* CreateClosureObject(
+		Heap* heap, CompiledFunctionObject* function, ObjectSpan freeVariables);
+char* InspectClosureObject(const ClosureObject* obj);
@@ -0,0 +1,313 @@
+#include "monkey/optimizer.h"
+
+#include "monkey/arena.h"
+#include "monkey/ast.h"
+#include "monkey/macros.h"
+#include "monkey/token.h"
+#include "span.h"
+
+#include <assert.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+typedef struct {
+	Arena* arena;
+} Optimizer;
+
+MONKEY_FILE_LOCAL void optimizeStatements(Optimizer* optimizer, StatementSpan statements);
+MONKEY_FILE_LOCAL Expression* optimizeExpression(Optimizer* optimizer, Expression* expression);
+
+MONKEY_FILE_LOCAL Expression* createInteger(Optimizer* optimizer, size_t offset, int64_t value) {
+	char text[24];
+	int length = snprintf(text, sizeof text, "%" PRId64, value);
+	const char* literal = ArenaCopy(optimizer->arena, text, (size_t)length);
+	Token token = {
+			.type = TOKEN_TYPE_INT,
+			.literal = SPAN_WITH_LENGTH(literal, (size_t)length),
+			.offset = offset,
+	};
+	return &CreateIntegerLiteral(optimizer->arena, token, value)->base;
+}
+
+MONKEY_FILE_LOCAL Expression* createBoolean(Optimizer* optimizer, size_t offset, bool value) {
+	Token token = {
+			.type = value ? TOKEN_TYPE_TRUE : TOKEN_TYPE_FALSE,
+			.literal = MonkeyStringViewFrom(value ? "true" : "false"),
+			.offset = offset,
+	};
+	return &CreateBooleanLiteral(optimizer->arena, token, value)->base;
+}
+
+MONKEY_FILE_LOCAL bool isInteger(const Expression* expression) {
+	return expression->type == EXPRESSION_TYPE_INTEGER_LITERAL;
+}
+
+MONKEY_FILE_LOCAL bool isBoolean(const Expression* expression) {
+	return expression->type == EXPRESSION_TYPE_BOOLEAN_LITERAL;
+}
+
+MONKEY_FILE_LOCAL int64_t integerValue(const Expression* expression) {
+	return ((const IntegerLiteral*)expression)->value;
+}
+
+MONKEY_FILE_LOCAL bool booleanValue(const Expression* expression) {
+	return ((const BooleanLiteral*)expression)->value;
+}
+
+MONKEY_FILE_LOCAL Expression* foldPrefix(Optimizer* optimizer, PrefixExpression* prefix) {
+	prefix->right = optimizeExpression(optimizer, prefix->right);
+	Expression* right = prefix->right;
+	size_t offset = prefix->token.offset;
+	switch (prefix->op) {
+		case OPERATOR_BANG:
+			// integers are always truthy
+			if (isInteger(right)) {
+				return createBoolean(optimizer, offset, false);
+			}
+			if (isBoolean(right)) {
+				return createBoolean(optimizer, offset, !booleanValue(right));
+			}
+			break;
+		case OPERATOR_MINUS:
+			if (isInteger(right) && integerValue(right) != INT64_MIN) {
+				return createInteger(optimizer, offset, -integerValue(right));
+			}
+			break;
+		default:
+			break;
+	}
+	return &prefix->base;
+}
+
+MONKEY_FILE_LOCAL Expression* foldInfix(Optimizer* optimizer, InfixExpression* infix) {
+	infix->left = optimizeExpression(optimizer, infix->left);
+	infix->right = optimizeExpression(optimizer, infix->right);
+	Expression* left = infix->left;
+	Expression* right = infix->right;
+	size_t offset = infix->token.offset;
+
+	if (isInteger(left) && isInteger(right)) {
+		int64_t a = integerValue(left);
+		int64_t b = integerValue(right);
+		int64_t result;
+		switch (infix->op) {
+			case OPERATOR_LT:
+				return createBoolean(optimizer, offset, a < b);
+			case OPERATOR_GT:
+				return createBoolean(optimizer, offset, a > b);
+			case OPERATOR_EQ:
+				return createBoolean(optimizer, offset, a == b);
+			case OPERATOR_NOT_EQ:
+				return createBoolean(optimizer, offset, a != b);
+			default:
+				if (ApplyIntegerOperator(infix->op, a, b, &result)) {
+					return createInteger(optimizer, offset, result);
+				}
+				return &infix->base;
+		}
+	}
+	if (isBoolean(left) && isBoolean(right)) {
+		// any other operator on booleans is an error, which is left to happen at run time
+		if (infix->op == OPERATOR_EQ) {
+			return createBoolean(optimizer, offset, booleanValue(left) == booleanValue(right));
+		}
+		if (infix->op == OPERATOR_NOT_EQ) {
+			return createBoolean(optimizer, offset, booleanValue(left) != booleanValue(right));
+		}
+	}
+	return &infix->base;
+}
+
+MONKEY_FILE_LOCAL bool statementsDeclare(StatementSpan statements);
+
+/**
+ * @private
+ *
+ * Whether evaluating an expression can define a variable in the enclosing scope, which lets in the
+ * blocks of if-expressions do. Function literals have scopes of their own.
+ */
+MONKEY_FILE_LOCAL bool expressionDeclares(const Expression* expression) {
+	if (expression == NULL) {
+		return false;
+	}
+	switch (expression->type) {
+		case EXPRESSION_TYPE_IDENTIFIER:
+		case EXPRESSION_TYPE_INTEGER_LITERAL:
+		case EXPRESSION_TYPE_BOOLEAN_LITERAL:
+		case EXPRESSION_TYPE_FUNCTION_LITERAL:
+			return false;
+		case EXPRESSION_TYPE_PREFIX:
+			return expressionDeclares(((const PrefixExpression*)expression)->right);
+		case EXPRESSION_TYPE_INFIX: {
+			const InfixExpression* infix = (const InfixExpression*)expression;
+			return expressionDeclares(infix->left) || expressionDeclares(infix->right);
+		}
+		case EXPRESSION_TYPE_IF: {
+			const IfExpression* exp = (const IfExpression*)expression;
+			return expressionDeclares(exp->condition) ||
+					statementsDeclare(exp->consequence->statements) ||
+					(exp->alternative != NULL && statementsDeclare(exp->alternative->statements));
+		}
+		case EXPRESSION_TYPE_CALL: {
+			const CallExpression* call = (const CallExpression*)expression;
+			if (expressionDeclares(call->function)) {
+				return true;
+			}
+			for (size_t i = 0; i < call->arguments.length; ++i) {
+				if (expressionDeclares(call->arguments.begin[i])) {
+					return true;
+				}
+			}
+			return false;
+		}
+	}
+	return false;
+}
+
+MONKEY_FILE_LOCAL bool statementsDeclare(StatementSpan statements) {
+	for (size_t i = 0; i < statements.length; ++i) {
+		const Statement* statement = statements.begin[i];
+		switch (statement->type) {
+			case STATEMENT_TYPE_LET:
+				return true;
+			case STATEMENT_TYPE_RETURN:
+				if (expressionDeclares(((const ReturnStatement*)statement)->returnValue)) {
+					return true;
+				}
+				break;
+			case STATEMENT_TYPE_EXPRESSION:
+				if (expressionDeclares(((const ExpressionStatement*)statement)->expression)) {
+					return true;
+				}
+				break;
+			case STATEMENT_TYPE_BLOCK:
+				if (statementsDeclare(((const BlockStatement*)statement)->statements)) {
+					return true;
+				}
+				break;
+		}
+	}
+	return false;
+}
+
+/**
+ * @private
+ *
+ * Drops the branch of an if-expression that its literal condition rules out. A branch that
+ * defines variables stays, since the resolver gives them slots (and the compiler symbols) whether
+ * or not it runs, and later uses of the names depend on that.
+ */
+MONKEY_FILE_LOCAL Expression* pruneIf(Optimizer* optimizer, IfExpression* exp) {
+	exp->condition = optimizeExpression(optimizer, exp->condition);
+	optimizeStatements(optimizer, exp->consequence->statements);
+	if (exp->alternative != NULL) {
+		optimizeStatements(optimizer, exp->alternative->statements);
+	}
+
+	if (!isInteger(exp->condition) && !isBoolean(exp->condition)) {
+		return &exp->base;
+	}
+	// integers are always truthy
+	bool truthy = isInteger(exp->condition) || booleanValue(exp->condition);
+	BlockStatement* taken = truthy ? exp->consequence : exp->alternative;
+	BlockStatement* dead = truthy ? exp->alternative : exp->consequence;
+	if (dead != NULL && statementsDeclare(dead->statements)) {
+		return &exp->base;
+	}
+
+	// a block of one expression statement has the value of the expression
+	if (taken != NULL && taken->statements.length == 1 &&
+			taken->statements.begin[0]->type == STATEMENT_TYPE_EXPRESSION) {
+		return ((ExpressionStatement*)taken->statements.begin[0])->expression;
+	}
+	if (taken == NULL) {
+		// the condition is false and there is no else, so the value is null
+		taken = CreateBlockStatement(
+				optimizer->arena, exp->consequence->token, (StatementSpan)SPAN_EMPTY);
+	} else if (taken == exp->alternative) {
+		exp->condition = createBoolean(optimizer, exp->token.offset, true);
+	}
+	exp->consequence = taken;
+	exp->alternative = NULL;
+	return &exp->base;
+}
+
+MONKEY_FILE_LOCAL void optimizeStatement(Optimizer* optimizer, Statement* statement) {
+	switch (statement->type) {
+		case STATEMENT_TYPE_EXPRESSION: {
+			ExpressionStatement* stmt = (ExpressionStatement*)statement;
+			stmt->expression = optimizeExpression(optimizer, stmt->expression);
+			return;
+		}
+		case STATEMENT_TYPE_RETURN: {
+			ReturnStatement* ret = (ReturnStatement*)statement;
+			ret->returnValue = optimizeExpression(optimizer, ret->returnValue);
+			return;
+		}
+		case STATEMENT_TYPE_LET: {
+			LetStatement* let = (LetStatement*)statement;
+			let->value = optimizeExpression(optimizer, let->value);
+			return;
+		}
+		case STATEMENT_TYPE_BLOCK:
+			optimizeStatements(optimizer, ((BlockStatement*)statement)->statements);
+			return;
+	}
+	(void)fprintf(stderr, "Unknown statement type: %d\n", statement->type);
+	assert(false);
+}
+
+MONKEY_FILE_LOCAL void optimizeStatements(Optimizer* optimizer, StatementSpan statements) {
+	for (size_t i = 0; i < statements.length; ++i) {
+		optimizeStatement(optimizer, statements.begin[i]);
+	}
+}
+
+/**
+ * @private
+ *
+ * Optimizes the children of an expression in place, and returns what should replace it.
+ */
+MONKEY_FILE_LOCAL Expression* optimizeExpression(Optimizer* optimizer, Expression* expression) {
+	if (expression == NULL) {
+		return NULL;
+	}
+	switch (expression->type) {
+		case EXPRESSION_TYPE_IDENTIFIER:
+		case EXPRESSION_TYPE_INTEGER_LITERAL:
+		case EXPRESSION_TYPE_BOOLEAN_LITERAL:
+			return expression;
+		case EXPRESSION_TYPE_PREFIX:
+			return foldPrefix(optimizer, (PrefixExpression*)expression);
+		case EXPRESSION_TYPE_INFIX:
+			return foldInfix(optimizer, (InfixExpression*)expression);
+		case EXPRESSION_TYPE_IF:
+			return pruneIf(optimizer, (IfExpression*)expression);
+		case EXPRESSION_TYPE_FUNCTION_LITERAL: {
+			FunctionLiteral* func = (FunctionLiteral*)expression;
+			if (func->body != NULL) {
+				optimizeStatements(optimizer, func->body->statements);
+			}
+			return expression;
+		}
+		case EXPRESSION_TYPE_CALL: {
+			CallExpression* call = (CallExpression*)expression;
+			call->function = optimizeExpression(optimizer, call->function);
+			for (size_t i = 0; i < call->arguments.length; ++i) {
+				call->arguments.begin[i] = optimizeExpression(optimizer, call->arguments.begin[i]);
+			}
+			return expression;
+		}
+	}
+	(void)fprintf(stderr, "Unknown expression type: %d\n", expression->type);
+	assert(false);
+	return expression;
+}
+
+void OptimizeProgram(Program* program) {
+	Optimizer optimizer = {program->arena};
+	optimizeStatements(&optimizer, program->statements);
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "monkey/ast.h"
+
+/**
+ * @brief OptimizeProgram simplifies a program ahead of running it, without changing what it does.
+ *
+ * Prefix and infix expressions over integer and boolean literals are folded into literals, and
+ * if-expressions with a literal condition lose the branch they can never take. Only subtrees made
+ * entirely of literals fold: `x * 60 * 60` is left as it is, since regrouping it would change which
+ * step overflows and so the error it reports. Whatever would fail at run time, such as a division
+ * by zero or an overflow, is left alone so that it still does, with the same message.
+ *
+ * The pass is optional: programs that are not optimized keep the tree (and ProgramString) they
+ * were parsed into. Optimized programs print their folded literals instead. It must run before
+ * the program is resolved or compiled, and new nodes come from the program's arena.
+ *
+ * @param program The program to optimize.
+ */
+void OptimizeProgram(Program* program);
@@ -1,15 +1,22 @@
 #include "monkey/parser.h"
 
 #include "buffer.h"
+#include "monkey/arena.h"
 #include "monkey/ast.h"
 #include "monkey/lexer.h"
+#include "monkey/location.h"
 #include "monkey/macros.h"
 #include "monkey/string.h"
 #include "monkey/token.h"
+#include "span.h"
 
+#include <assert.h>
+#include <hedley.h>
+#include <stdarg.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
 
 typedef Expression*(PrefixParseFn)(Parser*);
@@ -61,10 +68,34 @@ struct Parser {
 
 	Token currentToken;
 	Token peekToken;
+
+	/**
+	 * @brief panicking is set by an error, and makes the parser report nothing more until it has
+	 * skipped to the end of the statement the error was in.
+	 */
+	bool panicking;
+	/**
+	 * @brief stopped is set once PARSER_ERROR_LIMIT errors have been reported.
+	 */
+	bool stopped;
+
+	/**
+	 * @brief arena is where the nodes of the program being parsed are allocated.
+	 */
+	Arena* arena;
 };
 
 typedef BUFFER_TYPE(Statement*) StatementBuffer;
 
+/**
+ * @brief Copy the contents of a buffer into the arena and free the buffer.
+ */
+MONKEY_FILE_LOCAL void* moveToArena(Parser* parser, void* data, size_t size) {
+	void* result = ArenaCopy(parser->arena, data, size);
+	free(data);
+	return result;
+}
+
 MONKEY_FILE_LOCAL void nextToken(Parser* parser) {
 	DestroyToken(&parser->currentToken);
 	parser->currentToken = parser->peekToken;
@@ -87,15 +118,45 @@ MONKEY_FILE_LOCAL bool peekTokenIs(Parser* parser, TokenType type) {
 	return parser->peekToken.type == type;
 }
 
+/**
+ * @private
+ *
+ * Report an error at the line and column of a token, unless an earlier error in the same statement
+ * was reported already, since whatever goes wrong after that is most likely caused by it.
+ */
+MONKEY_FILE_LOCAL void HEDLEY_PRINTF_FORMAT(3, 4)
+		addError(Parser* parser, const Token* token, const char* format, ...) {
+	if (parser->panicking) {
+		return;
+	}
+	parser->panicking = true;
+	if (parser->errors.length == PARSER_ERROR_LIMIT) {
+		SourceLocation location = LexerLocate(parser->lexer, token->offset);
+		BUFFER_PUSH(&parser->errors, MonkeyAsprintf("%zu:%zu: too many errors, stopping",
+											 location.line, location.column));
+		parser->stopped = true;
+		return;
+	}
+
+	va_list args;
+	va_start(args, format);
+	char* message = MonkeyAvsprintf(format, args);
+	va_end(args);
+
+	SourceLocation location = LexerLocate(parser->lexer, token->offset);
+	BUFFER_PUSH(&parser->errors,
+			MonkeyAsprintf("%zu:%zu: %s", location.line, location.column, message));
+	free(message);
+}
+
 MONKEY_FILE_LOCAL void peekError(Parser* parser, TokenType t) {
-	char* message = MonkeyAsprintf("expected next token to be %s, got %s instead", TokenTypeText(t),
-			TokenTypeText(parser->peekToken.type));
-	BUFFER_PUSH(&parser->errors, message);
+	addError(parser, &parser->peekToken, "expected next token to be %s, got %s instead",
+			TokenTypeText(t), TokenTypeText(parser->peekToken.type));
 }
 
 MONKEY_FILE_LOCAL void noPrefixParseFnError(Parser* parser, TokenType t) {
-	char* message = MonkeyAsprintf("no prefix parse function for %s found", TokenTypeText(t));
-	BUFFER_PUSH(&parser->errors, message);
+	addError(parser, &parser->currentToken, "no prefix parse function for %s found",
+			TokenTypeText(t));
 }
 
 MONKEY_FILE_LOCAL bool expectPeek(Parser* parser, TokenType t) {
@@ -121,39 +182,64 @@ Parser* CreateParser(Lexer* lexer) {
 MONKEY_FILE_LOCAL Expression* parseExpression(Parser* parser, Precedence precedence);
 
 MONKEY_FILE_LOCAL Expression* parseIdentifier(Parser* parser) {
-	return (Expression*)CreateIdentifier(
-			CopyToken(&parser->currentToken), MonkeyStrdup(parser->currentToken.literal));
+	return (Expression*)CreateIdentifier(parser->arena,
+			CopyToken(&parser->currentToken), parser->currentToken.literal);
 }
 
 MONKEY_FILE_LOCAL Expression* parseIntegerLiteral(Parser* parser) {
 	Token token = CopyToken(&parser->currentToken);
 
-	char* errptr = NULL;
 	enum { BASE_10 = 10 };
-	int64_t value = strtoll(token.literal, &errptr, BASE_10);
-	if (errptr != NULL && *errptr != '\0') {
-		char* message = MonkeyAsprintf("could not parse \"%s\" as integer", token.literal);
-		BUFFER_PUSH(&parser->errors, message);
-		return NULL;
+	int64_t value = 0;
+	for (size_t i = 0; i < token.literal.length; ++i) {
+		char ch = token.literal.begin[i];
+		int64_t digit = ch - '0';
+		if (ch < '0' || ch > '9' || value > (INT64_MAX - digit) / BASE_10) {
+			addError(parser, &token, "could not parse \"%.*s\" as integer",
+					(int)token.literal.length, token.literal.begin);
+			return NULL;
+		}
+		value = value * BASE_10 + digit;
 	}
-	return (Expression*)CreateIntegerLiteral(token, value);
+	return (Expression*)CreateIntegerLiteral(parser->arena, token, value);
 }
 
 MONKEY_FILE_LOCAL Expression* parseBoolean(Parser* parser) {
 	Token token = CopyToken(&parser->currentToken);
 
-	return (Expression*)CreateBooleanLiteral(token, curTokenIs(parser, TOKEN_TYPE_TRUE));
+	return (Expression*)CreateBooleanLiteral(
+			parser->arena, token, curTokenIs(parser, TOKEN_TYPE_TRUE));
+}
+
+/**
+ * @private
+ *
+ * Only tokens registered with prefix or infix parse functions for operators reach this.
+ */
+MONKEY_FILE_LOCAL Operator tokenOperator(TokenType type) {
+	switch (type) {
+#define X(name, string) \
+	case TOKEN_TYPE_##name: \
+		return OPERATOR_##name;
+		OPERATORS_X
+#undef X
+		default:
+			break;
+	}
+	(void)fprintf(stderr, "Not an operator token: %s\n", TokenTypeText(type));
+	assert(false);
+	return OPERATOR_PLUS;
 }
 
 MONKEY_FILE_LOCAL Expression* parsePrefixExpression(Parser* parser) {
 	Token token = CopyToken(&parser->currentToken);
-	char* op = MonkeyStrdup(token.literal);
+	Operator op = tokenOperator(token.type);
 
 	nextToken(parser);
 
 	Expression* right = parseExpression(parser, PRECEDENCE_PREFIX);
 
-	return (Expression*)CreatePrefixExpression(token, op, right);
+	return (Expression*)CreatePrefixExpression(parser->arena, token, op, right);
 }
 
 MONKEY_FILE_LOCAL Expression* parseGroupedExpression(Parser* parser) {
@@ -162,7 +248,6 @@ MONKEY_FILE_LOCAL Expression* parseGroupedExpression(Parser* parser) {
 	Expression* exp = parseExpression(parser, PRECEDENCE_LOWEST);
 
 	if (!expectPeek(parser, TOKEN_TYPE_RPAREN)) {
-		DestroyExpression(exp);
 		return NULL;
 	}
 
@@ -182,7 +267,6 @@ MONKEY_FILE_LOCAL Expression* parseIfExpression(Parser* parser) {
 	nextToken(parser);
 	Expression* condition = parseExpression(parser, PRECEDENCE_LOWEST);
 	if (!expectPeek(parser, TOKEN_TYPE_RPAREN) || !expectPeek(parser, TOKEN_TYPE_LBRACE)) {
-		DestroyExpression(condition);
 		DestroyToken(&token);
 		return NULL;
 	}
@@ -194,8 +278,6 @@ MONKEY_FILE_LOCAL Expression* parseIfExpression(Parser* parser) {
 	if (peekTokenIs(parser, TOKEN_TYPE_ELSE)) {
 		nextToken(parser);
 		if (!expectPeek(parser, TOKEN_TYPE_LBRACE)) {
-			DestroyBlockStatement(consequence);
-			DestroyExpression(condition);
 			DestroyToken(&token);
 			return NULL;
 		}
@@ -203,7 +285,8 @@ MONKEY_FILE_LOCAL Expression* parseIfExpression(Parser* parser) {
 		alternative = parseBlockStatement(parser);
 	}
 
-	return (Expression*)CreateIfExpression(token, condition, consequence, alternative);
+	return (Expression*)CreateIfExpression(
+			parser->arena, token, condition, consequence, alternative);
 }
 
 MONKEY_FILE_LOCAL bool parseFunctionParameters(Parser* parser, IdentifierSpan* outParameters) {
@@ -211,32 +294,31 @@ MONKEY_FILE_LOCAL bool parseFunctionParameters(Parser* parser, IdentifierSpan* o
 
 	if (peekTokenIs(parser, TOKEN_TYPE_RPAREN)) {
 		nextToken(parser);
-		*outParameters = (IdentifierSpan)BUFFER_AS_SPAN(identifiers);
+		*outParameters = (IdentifierSpan)SPAN_EMPTY;
 		return true;
 	}
 
 	nextToken(parser);
 	BUFFER_PUSH(&identifiers,
-			CreateIdentifier(
-					CopyToken(&parser->currentToken), MonkeyStrdup(parser->currentToken.literal)));
+			CreateIdentifier(parser->arena, CopyToken(&parser->currentToken),
+					parser->currentToken.literal));
 
 	while (peekTokenIs(parser, TOKEN_TYPE_COMMA)) {
 		nextToken(parser);
 		nextToken(parser);
 		BUFFER_PUSH(&identifiers,
-				CreateIdentifier(CopyToken(&parser->currentToken),
-						MonkeyStrdup(parser->currentToken.literal)));
+				CreateIdentifier(parser->arena, CopyToken(&parser->currentToken),
+						parser->currentToken.literal));
 	}
 
 	if (!expectPeek(parser, TOKEN_TYPE_RPAREN)) {
-		for (size_t i = 0; i < identifiers.length; ++i) {
-			DestroyIdentifier(identifiers.data[i]);
-		}
 		BUFFER_FREE(identifiers);
 		return false;
 	}
 
-	*outParameters = (IdentifierSpan)BUFFER_AS_SPAN(identifiers);
+	Identifier** parameters =
+			moveToArena(parser, identifiers.data, identifiers.length * sizeof(Identifier*));
+	*outParameters = (IdentifierSpan)SPAN_WITH_LENGTH(parameters, identifiers.length);
 	return true;
 }
 
@@ -255,27 +337,24 @@ MONKEY_FILE_LOCAL Expression* parseFunctionLiteral(Parser* parser) {
 	}
 
 	if (!expectPeek(parser, TOKEN_TYPE_LBRACE)) {
-		for (size_t i = 0; i < parameters.length; ++i) {
-			DestroyIdentifier(parameters.begin[i]);
-		}
 		DestroyToken(&token);
 		return NULL;
 	}
 
 	BlockStatement* body = parseBlockStatement(parser);
 
-	return (Expression*)CreateFunctionLiteral(token, parameters, body);
+	return (Expression*)CreateFunctionLiteral(parser->arena, token, parameters, body);
 }
 
 MONKEY_FILE_LOCAL Expression* parseInfixExpression(Parser* parser, Expression* left) {
 	Token token = CopyToken(&parser->currentToken);
-	char* op = MonkeyStrdup(token.literal);
+	Operator op = tokenOperator(token.type);
 
 	Precedence precedence = curPrecedence(parser);
 	nextToken(parser);
 	Expression* right = parseExpression(parser, precedence);
 
-	return (Expression*)CreateInfixExpression(token, left, op, right);
+	return (Expression*)CreateInfixExpression(parser->arena, token, left, op, right);
 }
 
 MONKEY_FILE_LOCAL bool parseCallArguments(Parser* parser, ExpressionSpan* outArguments) {
@@ -283,7 +362,7 @@ MONKEY_FILE_LOCAL bool parseCallArguments(Parser* parser, ExpressionSpan* outArg
 
 	if (peekTokenIs(parser, TOKEN_TYPE_RPAREN)) {
 		nextToken(parser);
-		*outArguments = (ExpressionSpan)BUFFER_AS_SPAN(arguments);
+		*outArguments = (ExpressionSpan)SPAN_EMPTY;
 		return true;
 	}
 
@@ -297,14 +376,13 @@ MONKEY_FILE_LOCAL bool parseCallArguments(Parser* parser, ExpressionSpan* outArg
 	}
 
 	if (!expectPeek(parser, TOKEN_TYPE_RPAREN)) {
-		for (size_t i = 0; i < arguments.length; ++i) {
-			DestroyExpression(arguments.data[i]);
-		}
 		BUFFER_FREE(arguments);
 		return false;
 	}
 
-	*outArguments = (ExpressionSpan)BUFFER_AS_SPAN(arguments);
+	Expression** data =
+			moveToArena(parser, arguments.data, arguments.length * sizeof(Expression*));
+	*outArguments = (ExpressionSpan)SPAN_WITH_LENGTH(data, arguments.length);
 	return true;
 }
 
@@ -317,10 +395,13 @@ MONKEY_FILE_LOCAL Expression* parseCallExpression(Parser* parser, Expression* fu
 		return NULL;
 	}
 
-	return (Expression*)CreateCallExpression(token, function, arguments);
+	return (Expression*)CreateCallExpression(parser->arena, token, function, arguments);
 }
 
 MONKEY_FILE_LOCAL Expression* parseExpression(Parser* parser, Precedence precedence) {
+	if (parser->panicking) {
+		return NULL;
+	}
 	PrefixParseFn* prefix = getPrefixParser(parser->currentToken.type);
 	if (prefix == NULL) {
 		noPrefixParseFnError(parser, parser->currentToken.type);
@@ -345,21 +426,62 @@ MONKEY_FILE_LOCAL Expression* parseExpression(Parser* parser, Precedence precede
 
 MONKEY_FILE_LOCAL Statement* parseStatement(Parser* parser);
 
-MONKEY_FILE_LOCAL BlockStatement* parseBlockStatement(Parser* parser) {
-	Token token = CopyToken(&parser->currentToken);
-	StatementBuffer statements = BUFFER_INIT;
-
-	nextToken(parser);
-
-	while (!curTokenIs(parser, TOKEN_TYPE_RBRACE) && !curTokenIs(parser, TOKEN_TYPE_END_OF_FILE)) {
+/**
+ * @private
+ *
+ * Recover from an error by skipping to the last token of the statement it was in: the next `;`,
+ * or the token before the `}` closing the enclosing block. Blocks opened on the way are skipped
+ * whole.
+ */
+MONKEY_FILE_LOCAL void synchronize(Parser* parser) {
+	size_t depth = 0;
+	while (!curTokenIs(parser, TOKEN_TYPE_END_OF_FILE)) {
+		if (curTokenIs(parser, TOKEN_TYPE_LBRACE)) {
+			++depth;
+		} else if (curTokenIs(parser, TOKEN_TYPE_RBRACE) && depth > 0) {
+			--depth;
+		}
+		bool atEnd = curTokenIs(parser, TOKEN_TYPE_SEMICOLON) ||
+				peekTokenIs(parser, TOKEN_TYPE_RBRACE);
+		if (depth == 0 && atEnd) {
+			break;
+		}
+		nextToken(parser);
+	}
+	parser->panicking = false;
+}
+
+/**
+ * @private
+ *
+ * Parse statements up to the end of the input or the token that ends, which is not consumed.
+ */
+MONKEY_FILE_LOCAL void parseStatements(
+		Parser* parser, StatementBuffer* statements, TokenType end) {
+	while (!curTokenIs(parser, end) && !curTokenIs(parser, TOKEN_TYPE_END_OF_FILE) &&
+			!parser->stopped) {
 		Statement* stmt = parseStatement(parser);
 		if (stmt != NULL) {
-			BUFFER_PUSH(&statements, stmt);
+			BUFFER_PUSH(statements, stmt);
+		}
+		if (parser->panicking) {
+			synchronize(parser);
 		}
 		nextToken(parser);
 	}
+}
+
+MONKEY_FILE_LOCAL BlockStatement* parseBlockStatement(Parser* parser) {
+	Token token = CopyToken(&parser->currentToken);
+	StatementBuffer statements = BUFFER_INIT;
 
-	return CreateBlockStatement(token, (StatementSpan)BUFFER_AS_SPAN(statements));
+	nextToken(parser);
+	parseStatements(parser, &statements, TOKEN_TYPE_RBRACE);
+
+	Statement** data =
+			moveToArena(parser, statements.data, statements.length * sizeof(Statement*));
+	return CreateBlockStatement(
+			parser->arena, token, (StatementSpan)SPAN_WITH_LENGTH(data, statements.length));
 }
 
 MONKEY_FILE_LOCAL Statement* parseLetStatement(Parser* parser) {
@@ -371,11 +493,10 @@ MONKEY_FILE_LOCAL Statement* parseLetStatement(Parser* parser) {
 	}
 
 	Identifier* name = CreateIdentifier(
-			CopyToken(&parser->currentToken), MonkeyStrdup(parser->currentToken.literal));
+			parser->arena, CopyToken(&parser->currentToken), parser->currentToken.literal);
 
 	if (!expectPeek(parser, TOKEN_TYPE_ASSIGN)) {
 		DestroyToken(&token);
-		DestroyIdentifier(name);
 		return NULL;
 	}
 
@@ -385,7 +506,7 @@ MONKEY_FILE_LOCAL Statement* parseLetStatement(Parser* parser) {
 		nextToken(parser);
 	}
 
-	return (Statement*)CreateLetStatement(token, name, value);
+	return (Statement*)CreateLetStatement(parser->arena, token, name, value);
 }
 
 MONKEY_FILE_LOCAL Statement* parseReturnStatement(Parser* parser) {
@@ -398,7 +519,7 @@ MONKEY_FILE_LOCAL Statement* parseReturnStatement(Parser* parser) {
 		nextToken(parser);
 	}
 
-	return (Statement*)CreateReturnStatement(token, returnValue);
+	return (Statement*)CreateReturnStatement(parser->arena, token, returnValue);
 }
 
 MONKEY_FILE_LOCAL Statement* parseExpressionStatement(Parser* parser) {
@@ -410,7 +531,7 @@ MONKEY_FILE_LOCAL Statement* parseExpressionStatement(Parser* parser) {
 		nextToken(parser);
 	}
 
-	return (Statement*)CreateExpressionStatement(token, expression);
+	return (Statement*)CreateExpressionStatement(parser->arena, token, expression);
 }
 
 MONKEY_FILE_LOCAL Statement* parseStatement(Parser* parser) {
@@ -425,17 +546,15 @@ MONKEY_FILE_LOCAL Statement* parseStatement(Parser* parser) {
 }
 
 Program* ParseProgram(Parser* parser) {
+	// literals from a stream lexer live in its arena, which the program keeps alive with its nodes
+	Arena* literals = LexerArena(parser->lexer);
+	parser->arena = literals != NULL ? RetainArena(literals) : CreateArena();
 	StatementBuffer statements = BUFFER_INIT;
+	parseStatements(parser, &statements, TOKEN_TYPE_END_OF_FILE);
 
-	while (parser->currentToken.type != TOKEN_TYPE_END_OF_FILE) {
-		Statement* statement = parseStatement(parser);
-		if (statement != NULL) {
-			BUFFER_PUSH(&statements, statement);
-		}
-		nextToken(parser);
-	}
-
-	return CreateProgram((StatementSpan)BUFFER_AS_SPAN(statements));
+	Statement** data =
+			moveToArena(parser, statements.data, statements.length * sizeof(Statement*));
+	return CreateProgram(parser->arena, (StatementSpan)SPAN_WITH_LENGTH(data, statements.length));
 }
 
 void DestroyParser(Parser* parser) {
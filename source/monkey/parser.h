@@ -6,6 +6,12 @@
 
 typedef struct Parser Parser;
 
+/**
+ * @brief PARSER_ERROR_LIMIT is how many errors a parser reports before it gives up on the rest of
+ * the input.
+ */
+#define PARSER_ERROR_LIMIT 100
+
 /**
  * @brief CreateParser creates a new parser.
  * @param lexer The lexer to use.
@@ -15,8 +21,12 @@ Parser* CreateParser(Lexer* lexer);
 
 /**
  * @brief ParseProgram parses the program.
+ *
+ * After an error the parser skips to the end of the statement the error was in and carries on, so
+ * that one pass reports the first error of every broken statement, up to PARSER_ERROR_LIMIT.
+ *
  * @param parser The parser to use.
- * @return The program.
+ * @return The program, which is incomplete if there were errors.
  */
 Program* ParseProgram(Parser* parser);
 
@@ -29,6 +39,6 @@ void DestroyParser(Parser* parser);
 /**
  * @brief Obtain the list of parser errors.
  * @param parser The parser to use.
- * @return The list of errors.
+ * @return The list of errors, each starting with the "line:column: " it was found at.
  */
 MonkeyStringBuffer ParserErrors(Parser* parser);
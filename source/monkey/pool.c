@@ -0,0 +1,114 @@
+#include "monkey/pool.h"
+
+#include "monkey/macros.h"
+
+#include <hedley.h>
+#include <stdalign.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+#if defined(__SANITIZE_ADDRESS__)
+#define POOL_USE_ASAN 1
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define POOL_USE_ASAN 1
+#endif
+#endif
+
+#ifdef POOL_USE_ASAN
+#include <sanitizer/asan_interface.h>
+// free blocks stay poisoned, so that AddressSanitizer still catches objects used after a collection
+#define POOL_POISON(block, size) ASAN_POISON_MEMORY_REGION(block, size)
+#define POOL_UNPOISON(block, size) ASAN_UNPOISON_MEMORY_REGION(block, size)
+#else
+#define POOL_POISON(block, size) ((void)(block), (void)(size))
+#define POOL_UNPOISON(block, size) ((void)(block), (void)(size))
+#endif
+
+#define POOL_GRANULARITY alignof(max_align_t)
+#define POOL_CLASS_COUNT (POOL_MAX_SIZE / POOL_GRANULARITY)
+#define POOL_SLAB_SIZE ((size_t)16 << 10U)
+
+typedef struct PoolSlab {
+	struct PoolSlab* previous;
+	alignas(max_align_t) unsigned char data[];
+} PoolSlab;
+
+typedef struct PoolBlock {
+	struct PoolBlock* next;
+} PoolBlock;
+
+struct Pool {
+	/**
+	 * @brief freeBlocks holds the free list of each size class, the smallest first.
+	 */
+	PoolBlock* freeBlocks[POOL_CLASS_COUNT];
+	/**
+	 * @brief slab is the slab new blocks are cut from, which links to the full ones.
+	 */
+	PoolSlab* slab;
+	size_t slabUsed;
+};
+
+MONKEY_FILE_LOCAL size_t sizeClass(size_t size) {
+	return (size - 1) / POOL_GRANULARITY;
+}
+
+Pool* CreatePool(void) {
+	Pool* pool = calloc(1, sizeof(Pool));
+	// start with a full slab of nothing, so that the first block makes a real one
+	pool->slabUsed = POOL_SLAB_SIZE;
+	return pool;
+}
+
+MONKEY_FILE_LOCAL void* cutBlock(Pool* pool, size_t size) {
+	if (POOL_SLAB_SIZE - pool->slabUsed < size) {
+		PoolSlab* slab = malloc(sizeof(PoolSlab) + POOL_SLAB_SIZE);
+		slab->previous = pool->slab;
+		pool->slab = slab;
+		pool->slabUsed = 0;
+		POOL_POISON(slab->data, POOL_SLAB_SIZE);
+	}
+	void* block = pool->slab->data + pool->slabUsed;
+	pool->slabUsed += size;
+	return block;
+}
+
+void* PoolAllocate(Pool* pool, size_t size) {
+	if (HEDLEY_UNLIKELY(size > POOL_MAX_SIZE)) {
+		return malloc(size);
+	}
+	size_t index = sizeClass(size);
+	size_t classSize = (index + 1) * POOL_GRANULARITY;
+	PoolBlock* block = pool->freeBlocks[index];
+	if (block != NULL) {
+		POOL_UNPOISON(block, sizeof(PoolBlock));
+		pool->freeBlocks[index] = block->next;
+	} else {
+		block = cutBlock(pool, classSize);
+	}
+	POOL_UNPOISON(block, classSize);
+	return block;
+}
+
+void PoolFree(Pool* pool, void* block, size_t size) {
+	if (HEDLEY_UNLIKELY(size > POOL_MAX_SIZE)) {
+		free(block);
+		return;
+	}
+	size_t index = sizeClass(size);
+	PoolBlock* freed = block;
+	freed->next = pool->freeBlocks[index];
+	pool->freeBlocks[index] = freed;
+	POOL_POISON(freed, (index + 1) * POOL_GRANULARITY);
+}
+
+void DestroyPool(Pool* pool) {
+	PoolSlab* slab = pool->slab;
+	while (slab != NULL) {
+		PoolSlab* previous = slab->previous;
+		free(slab);
+		slab = previous;
+	}
+	free(pool);
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <stddef.h>
+
+/**
+ * @brief Pool is an allocator for the small blocks that objects are made of, which it recycles
+ * instead of handing them back to malloc.
+ *
+ * Sizes are rounded up to a few size classes, each with a free list of the blocks freed in it.
+ * New blocks are cut from large slabs, so that allocating or freeing is a few pointer moves.
+ * Blocks larger than POOL_MAX_SIZE come from malloc. Slabs are only freed with the pool.
+ */
+typedef struct Pool Pool;
+
+/**
+ * @brief POOL_MAX_SIZE is the size of the largest blocks a pool recycles.
+ */
+#define POOL_MAX_SIZE ((size_t)256)
+
+/**
+ * @brief Create an empty pool.
+ */
+Pool* CreatePool(void);
+
+/**
+ * @brief Allocate a block from a pool, aligned for any type.
+ *
+ * @param pool the pool
+ * @param size the number of bytes, which must not be zero
+ * @return void* the block, which is not initialized
+ */
+void* PoolAllocate(Pool* pool, size_t size);
+
+/**
+ * @brief Give a block back to the pool it came from.
+ *
+ * @param pool the pool
+ * @param block the block
+ * @param size the size it was allocated with
+ */
+void PoolFree(Pool* pool, void* block, size_t size);
+
+/**
+ * @brief Destroy a pool. Blocks still allocated from it are freed too, except those larger than
+ * POOL_MAX_SIZE.
+ */
+void DestroyPool(Pool* pool);
@@ -1,15 +1,19 @@
 #include "monkey/repl.h"
 
+#include "buffer.h"
 #include "monkey.h"
 #include "monkey/ast.h"
+#include "monkey/compiler.h"
 #include "monkey/environment.h"
 #include "monkey/evaluator.h"
 #include "monkey/lexer.h"
 #include "monkey/macros.h"
 #include "monkey/object.h"
+#include "monkey/optimizer.h"
 #include "monkey/parser.h"
 #include "monkey/stream.h"
 #include "monkey/string.h"
+#include "monkey/vm.h"
 
 #include <stdbool.h>
 #include <stddef.h>
@@ -20,7 +24,7 @@
 
 #define GETLINE_INITIAL_LENGTH 256
 
-MONKEY_FILE_LOCAL void printParserErrors(Stream* out, MonkeyStringBuffer errors) {
+MONKEY_FILE_LOCAL void printErrors(Stream* out, MonkeyStringBuffer errors) {
 	for (size_t i = 0; i < errors.length; i++) {
 		WriteStream(out, "\t", 1);
 		WriteStream(out, errors.data[i], strlen(errors.data[i]));
@@ -31,31 +35,63 @@ MONKEY_FILE_LOCAL void printParserErrors(Stream* out, MonkeyStringBuffer errors)
 void MonkeyRepl(MonkeyReplArgs args) {
 	char* line = NULL;
 	size_t lineCapacity = 0;
+	// Tokens and AST nodes borrow their text from the line they were read from, and function
+	// objects keep their AST alive across lines, so evaluated lines must stay around.
+	MonkeyStringBuffer sources = BUFFER_INIT;
 	Monkey* monkey = CreateMonkey();
-	Environment* env = CreateEnvironment(NULL);
+	Environment* env = CreateEnvironment(monkey, NULL);
+	Compiler* compiler = NULL;
+	VM* vm = NULL;
+	if (args.engine == MONKEY_ENGINE_VM) {
+		compiler = CreateCompiler(monkey);
+		vm = CreateVM(monkey);
+	}
+	// every prompt has to be seen before the line answering it is waited for
+	Stream* tied = args.reader->tied;
+	TieStream(args.reader, args.writer);
 	while (true) {
 		WriteStream(args.writer, "> ", 2);
 		int64_t lineLength = ReadStreamLine(&line, &lineCapacity, args.reader);
 		if (lineLength == -1) {
 			WriteStream(args.writer, "\n", 1);
+			if (StreamError(args.reader) != 0) {
+				(void)StreamPrintf(args.writer, "%s\n", strerror(StreamError(args.reader)));
+			}
 			break;
 		}
 
-		Lexer* lexer = CreateLexer(monkey, line);
+		char* source = MonkeyStrndup(line, (size_t)lineLength);
+		Lexer* lexer = CreateLexer(monkey, source);
 		Parser* parser = CreateParser(lexer);
 		Program* program = ParseProgram(parser);
 		MonkeyStringBuffer errors = ParserErrors(parser);
 		if (errors.length > 0) {
-			printParserErrors(args.writer, errors);
+			printErrors(args.writer, errors);
 			DestroyProgram(program);
 			DestroyParser(parser);
 			DestroyLexer(lexer);
+			free(source);
 			continue;
 		}
+		BUFFER_PUSH(&sources, source);
+		if (args.optimize) {
+			OptimizeProgram(program);
+		}
 
-		Object* evaluated = Eval(monkey, env, &program->base);
+		Object* evaluated = NULL;
+		if (args.engine == MONKEY_ENGINE_VM) {
+			if (!Compile(compiler, program)) {
+				printErrors(args.writer, CompilerErrors(compiler));
+				DestroyProgram(program);
+				DestroyParser(parser);
+				DestroyLexer(lexer);
+				continue;
+			}
+			evaluated = Run(vm, CompilerBytecode(compiler));
+		} else {
+			evaluated = Eval(monkey, env, &program->base);
+		}
 		char* text = InspectObject(evaluated);
-		DestroyObject(evaluated);
 		WriteStream(args.writer, text, strlen(text));
 		free(text);
 		WriteStream(args.writer, "\n", 1);
@@ -63,7 +99,17 @@ void MonkeyRepl(MonkeyReplArgs args) {
 		DestroyParser(parser);
 		DestroyLexer(lexer);
 	}
+	TieStream(args.reader, tied);
+	(void)FlushStream(args.writer);
 	free(line);
+	if (args.engine == MONKEY_ENGINE_VM) {
+		DestroyVM(vm);
+		DestroyCompiler(compiler);
+	}
 	DestroyEnvironment(env);
+	for (size_t i = 0; i < sources.length; i++) {
+		free(sources.data[i]);
+	}
+	BUFFER_FREE(sources);
 	DestroyMonkey(monkey);
 }
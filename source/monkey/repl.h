@@ -1,7 +1,9 @@
 #pragma once
 
+#include "monkey/engine.h"
 #include "monkey/stream.h"
 
+#include <stdbool.h>
 #include <stdio.h>
 
 /**
@@ -10,12 +12,20 @@
 typedef struct {
 	Stream* reader;
 	Stream* writer;
+	/**
+	 * @brief engine defaults to MONKEY_ENGINE_EVALUATOR.
+	 */
+	MonkeyEngine engine;
+	/**
+	 * @brief optimize runs OptimizeProgram on every line before it is run.
+	 */
+	bool optimize;
 } MonkeyReplArgs;
 
 /**
  * @brief MonkeyRepl will start a REPL for the Monkey language.
  *
- * @param args The reader and writer.
+ * @param args The reader, writer and engine.
  */
 void MonkeyRepl(MonkeyReplArgs args);
 #define MONKEY_REPL(...) MonkeyRepl((MonkeyReplArgs){__VA_ARGS__})
@@ -0,0 +1,235 @@
+#include "monkey/resolver.h"
+
+#include "buffer.h"
+#include "monkey/ast.h"
+#include "monkey/macros.h"
+#include "monkey/symbol.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef struct {
+	const MonkeySymbol* name;
+	size_t slot;
+} Local;
+
+/**
+ * @private
+ *
+ * Scope is the variables of one function literal. Functions rarely have more than a handful of
+ * variables, so they are searched linearly.
+ */
+typedef struct {
+	BUFFER_TYPE(Local) locals;
+} Scope;
+
+typedef struct {
+	BUFFER_TYPE(Scope) scopes;
+} Resolver;
+
+MONKEY_FILE_LOCAL void resolveStatement(Resolver* resolver, Statement* statement);
+MONKEY_FILE_LOCAL void resolveExpression(Resolver* resolver, Expression* expression);
+
+MONKEY_FILE_LOCAL const Local* findLocal(const Scope* scope, const MonkeySymbol* name) {
+	// parameters may share a name, and the last of them wins
+	for (size_t i = scope->locals.length; i > 0; --i) {
+		if (scope->locals.data[i - 1].name == name) {
+			return &scope->locals.data[i - 1];
+		}
+	}
+	return NULL;
+}
+
+MONKEY_FILE_LOCAL void addLocal(Scope* scope, Identifier* identifier) {
+	identifier->scope = IDENTIFIER_SCOPE_LOCAL;
+	identifier->depth = 0;
+	identifier->slot = scope->locals.length;
+	Local local = {identifier->symbol, identifier->slot};
+	BUFFER_PUSH(&scope->locals, local);
+}
+
+MONKEY_FILE_LOCAL void define(Resolver* resolver, Identifier* identifier) {
+	if (resolver->scopes.length == 0) {
+		identifier->scope = IDENTIFIER_SCOPE_GLOBAL;
+		return;
+	}
+	Scope* scope = &resolver->scopes.data[resolver->scopes.length - 1];
+	const Local* existing = findLocal(scope, identifier->symbol);
+	if (existing != NULL) {
+		// re-binding a name reuses its slot
+		identifier->scope = IDENTIFIER_SCOPE_LOCAL;
+		identifier->depth = 0;
+		identifier->slot = existing->slot;
+		return;
+	}
+	addLocal(scope, identifier);
+}
+
+MONKEY_FILE_LOCAL void resolveIdentifier(Resolver* resolver, Identifier* identifier) {
+	for (size_t depth = 0; depth < resolver->scopes.length; ++depth) {
+		const Scope* scope = &resolver->scopes.data[resolver->scopes.length - 1 - depth];
+		const Local* local = findLocal(scope, identifier->symbol);
+		if (local != NULL) {
+			identifier->scope = IDENTIFIER_SCOPE_LOCAL;
+			identifier->depth = depth;
+			identifier->slot = local->slot;
+			return;
+		}
+	}
+	identifier->scope = IDENTIFIER_SCOPE_GLOBAL;
+}
+
+MONKEY_FILE_LOCAL void resolveStatements(Resolver* resolver, StatementSpan statements) {
+	for (size_t i = 0; i < statements.length; ++i) {
+		resolveStatement(resolver, statements.begin[i]);
+	}
+}
+
+MONKEY_FILE_LOCAL void markTailStatements(StatementSpan statements, bool valueIsTail);
+
+/**
+ * @private
+ *
+ * Marks the calls an expression in tail position evaluates to.
+ */
+MONKEY_FILE_LOCAL void markTailExpression(Expression* expression) {
+	if (expression == NULL) {
+		return;
+	}
+	if (expression->type == EXPRESSION_TYPE_CALL) {
+		((CallExpression*)expression)->tail = true;
+	} else if (expression->type == EXPRESSION_TYPE_IF) {
+		IfExpression* exp = (IfExpression*)expression;
+		markTailStatements(exp->consequence->statements, true);
+		if (exp->alternative != NULL) {
+			markTailStatements(exp->alternative->statements, true);
+		}
+	}
+}
+
+/**
+ * @private
+ *
+ * Marks the tail calls of a block whose return statements return from the function. Its last
+ * expression is in tail position too when the value of the block is.
+ */
+MONKEY_FILE_LOCAL void markTailStatements(StatementSpan statements, bool valueIsTail) {
+	for (size_t i = 0; i < statements.length; ++i) {
+		Statement* statement = statements.begin[i];
+		if (statement->type == STATEMENT_TYPE_RETURN) {
+			markTailExpression(((ReturnStatement*)statement)->returnValue);
+		} else if (statement->type == STATEMENT_TYPE_EXPRESSION) {
+			Expression* expression = ((ExpressionStatement*)statement)->expression;
+			if (valueIsTail && i == statements.length - 1) {
+				markTailExpression(expression);
+			} else if (expression != NULL && expression->type == EXPRESSION_TYPE_IF) {
+				// the value is dropped, but returns in the branches still leave the function
+				IfExpression* exp = (IfExpression*)expression;
+				markTailStatements(exp->consequence->statements, false);
+				if (exp->alternative != NULL) {
+					markTailStatements(exp->alternative->statements, false);
+				}
+			}
+		}
+	}
+}
+
+MONKEY_FILE_LOCAL void resolveFunctionLiteral(Resolver* resolver, FunctionLiteral* func) {
+	Scope scope = {BUFFER_INIT};
+	BUFFER_PUSH(&resolver->scopes, scope);
+	// every parameter gets a slot, even one named like an earlier parameter, so that each
+	// argument has somewhere to go
+	for (size_t i = 0; i < func->parameters.length; ++i) {
+		addLocal(&resolver->scopes.data[resolver->scopes.length - 1], func->parameters.begin[i]);
+	}
+	if (func->body != NULL) {
+		resolveStatements(resolver, func->body->statements);
+		markTailStatements(func->body->statements, true);
+	}
+	Scope* inner = &resolver->scopes.data[--resolver->scopes.length];
+	func->slotCount = inner->locals.length;
+	BUFFER_FREE(inner->locals);
+}
+
+MONKEY_FILE_LOCAL void resolveStatement(Resolver* resolver, Statement* statement) {
+	switch (statement->type) {
+		case STATEMENT_TYPE_EXPRESSION:
+			resolveExpression(resolver, ((ExpressionStatement*)statement)->expression);
+			return;
+		case STATEMENT_TYPE_RETURN:
+			resolveExpression(resolver, ((ReturnStatement*)statement)->returnValue);
+			return;
+		case STATEMENT_TYPE_LET: {
+			LetStatement* let = (LetStatement*)statement;
+			// A function can only be called after the let completes, so it may refer to itself.
+			// Any other value is evaluated before its name is bound.
+			if (let->value != NULL && let->value->type == EXPRESSION_TYPE_FUNCTION_LITERAL) {
+				define(resolver, let->identifier);
+				resolveExpression(resolver, let->value);
+			} else {
+				resolveExpression(resolver, let->value);
+				define(resolver, let->identifier);
+			}
+			return;
+		}
+		case STATEMENT_TYPE_BLOCK:
+			resolveStatements(resolver, ((BlockStatement*)statement)->statements);
+			return;
+	}
+	(void)fprintf(stderr, "Unknown statement type: %d\n", statement->type);
+	assert(false);
+}
+
+MONKEY_FILE_LOCAL void resolveExpression(Resolver* resolver, Expression* expression) {
+	if (expression == NULL) {
+		return;
+	}
+	switch (expression->type) {
+		case EXPRESSION_TYPE_INTEGER_LITERAL:
+		case EXPRESSION_TYPE_BOOLEAN_LITERAL:
+			return;
+		case EXPRESSION_TYPE_IDENTIFIER:
+			resolveIdentifier(resolver, (Identifier*)expression);
+			return;
+		case EXPRESSION_TYPE_PREFIX:
+			resolveExpression(resolver, ((PrefixExpression*)expression)->right);
+			return;
+		case EXPRESSION_TYPE_INFIX: {
+			InfixExpression* infix = (InfixExpression*)expression;
+			resolveExpression(resolver, infix->left);
+			resolveExpression(resolver, infix->right);
+			return;
+		}
+		case EXPRESSION_TYPE_IF: {
+			IfExpression* exp = (IfExpression*)expression;
+			resolveExpression(resolver, exp->condition);
+			resolveStatements(resolver, exp->consequence->statements);
+			if (exp->alternative != NULL) {
+				resolveStatements(resolver, exp->alternative->statements);
+			}
+			return;
+		}
+		case EXPRESSION_TYPE_FUNCTION_LITERAL:
+			resolveFunctionLiteral(resolver, (FunctionLiteral*)expression);
+			return;
+		case EXPRESSION_TYPE_CALL: {
+			CallExpression* call = (CallExpression*)expression;
+			resolveExpression(resolver, call->function);
+			for (size_t i = 0; i < call->arguments.length; ++i) {
+				resolveExpression(resolver, call->arguments.begin[i]);
+			}
+			return;
+		}
+	}
+	(void)fprintf(stderr, "Unknown expression type: %d\n", expression->type);
+	assert(false);
+}
+
+void ResolveProgram(Program* program) {
+	Resolver resolver = {BUFFER_INIT};
+	resolveStatements(&resolver, program->statements);
+	BUFFER_FREE(resolver.scopes);
+}
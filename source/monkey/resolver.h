@@ -0,0 +1,15 @@
+#pragma once
+
+#include "monkey/ast.h"
+
+/**
+ * @brief ResolveProgram binds identifiers to variables ahead of evaluation.
+ *
+ * Every identifier that refers to a parameter or local variable of an enclosing function literal
+ * gets the depth and slot of that variable, and every function literal gets its slot count. All
+ * other identifiers are left as globals, which are looked up by name since a REPL can define them
+ * later. Calls in tail position are marked as such.
+ *
+ * @param program The program to resolve.
+ */
+void ResolveProgram(Program* program);
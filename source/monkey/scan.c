@@ -0,0 +1,258 @@
+#include "monkey/scan.h"
+
+#include "monkey/macros.h"
+
+#include <hedley.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#if !defined(MONKEY_DISABLE_SIMD) && \
+		(defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define MONKEY_SCAN_SSE2
+#include <emmintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#endif
+
+// AVX2 is only compiled in where functions can target it without changing the flags of the whole
+// build, and where the CPU can be asked whether it has it.
+#if defined(MONKEY_SCAN_SSE2) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MONKEY_SCAN_AVX2
+#include <immintrin.h>
+#define AVX2_FUNCTION __attribute__((target("avx2")))
+#endif
+
+// ---- Scalar ----
+
+MONKEY_FILE_LOCAL bool isWhitespace(char ch) {
+	return ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r';
+}
+
+MONKEY_FILE_LOCAL bool isLetter(char ch) {
+	return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || ch == '_';
+}
+
+MONKEY_FILE_LOCAL bool isDigit(char ch) {
+	return ch >= '0' && ch <= '9';
+}
+
+MONKEY_FILE_LOCAL size_t scalarWhitespace(const char* text, size_t length) {
+	size_t i = 0;
+	while (i < length && isWhitespace(text[i])) {
+		++i;
+	}
+	return i;
+}
+
+MONKEY_FILE_LOCAL size_t scalarLetters(const char* text, size_t length) {
+	size_t i = 0;
+	while (i < length && isLetter(text[i])) {
+		++i;
+	}
+	return i;
+}
+
+MONKEY_FILE_LOCAL size_t scalarDigits(const char* text, size_t length) {
+	size_t i = 0;
+	while (i < length && isDigit(text[i])) {
+		++i;
+	}
+	return i;
+}
+
+MONKEY_FILE_LOCAL const Scanner SCALAR_SCANNER = {
+		"scalar",
+		scalarWhitespace,
+		scalarLetters,
+		scalarDigits,
+};
+
+#ifdef MONKEY_SCAN_SSE2
+
+MONKEY_FILE_LOCAL unsigned lowestSetBit(uint32_t mask) {
+#if defined(_MSC_VER) && !defined(__clang__)
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return (unsigned)index;
+#else
+	return (unsigned)__builtin_ctz(mask);
+#endif
+}
+
+// ---- SSE2 ----
+
+// Each classifier sets every byte of the result to 0xFF where the input byte is in the class.
+// Comparisons are signed, so bytes of 0x80 and above never fall inside a range.
+
+HEDLEY_ALWAYS_INLINE MONKEY_FILE_LOCAL __m128i sse2ClassifyWhitespace(__m128i chunk) {
+	__m128i result = _mm_cmpeq_epi8(chunk, _mm_set1_epi8(' '));
+	result = _mm_or_si128(result, _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\t')));
+	result = _mm_or_si128(result, _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n')));
+	return _mm_or_si128(result, _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\r')));
+}
+
+HEDLEY_ALWAYS_INLINE MONKEY_FILE_LOCAL __m128i sse2ClassifyLetters(__m128i chunk) {
+	// setting bit 5 maps upper case letters onto lower case ones, and nothing else onto them
+	__m128i lower = _mm_or_si128(chunk, _mm_set1_epi8(0x20));
+	__m128i result = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+			_mm_cmplt_epi8(lower, _mm_set1_epi8('z' + 1)));
+	return _mm_or_si128(result, _mm_cmpeq_epi8(chunk, _mm_set1_epi8('_')));
+}
+
+HEDLEY_ALWAYS_INLINE MONKEY_FILE_LOCAL __m128i sse2ClassifyDigits(__m128i chunk) {
+	return _mm_and_si128(_mm_cmpgt_epi8(chunk, _mm_set1_epi8('0' - 1)),
+			_mm_cmplt_epi8(chunk, _mm_set1_epi8('9' + 1)));
+}
+
+/**
+ * @private
+ *
+ * Returns the index of the first byte of a 16-byte block outside the class, or 16.
+ */
+#define SSE2_RUN_END(classify, text) \
+	lowestSetBit((uint32_t)_mm_movemask_epi8(classify(_mm_loadu_si128((const __m128i*)(text)))) ^ \
+			UINT32_C(0x1FFFF))
+
+#define SSE2_BLOCK 16
+
+MONKEY_FILE_LOCAL size_t sse2Whitespace(const char* text, size_t length) {
+	size_t i = 0;
+	for (; i + SSE2_BLOCK <= length; i += SSE2_BLOCK) {
+		unsigned end = SSE2_RUN_END(sse2ClassifyWhitespace, text + i);
+		if (end < SSE2_BLOCK) {
+			return i + end;
+		}
+	}
+	return i + scalarWhitespace(text + i, length - i);
+}
+
+MONKEY_FILE_LOCAL size_t sse2Letters(const char* text, size_t length) {
+	size_t i = 0;
+	for (; i + SSE2_BLOCK <= length; i += SSE2_BLOCK) {
+		unsigned end = SSE2_RUN_END(sse2ClassifyLetters, text + i);
+		if (end < SSE2_BLOCK) {
+			return i + end;
+		}
+	}
+	return i + scalarLetters(text + i, length - i);
+}
+
+MONKEY_FILE_LOCAL size_t sse2Digits(const char* text, size_t length) {
+	size_t i = 0;
+	for (; i + SSE2_BLOCK <= length; i += SSE2_BLOCK) {
+		unsigned end = SSE2_RUN_END(sse2ClassifyDigits, text + i);
+		if (end < SSE2_BLOCK) {
+			return i + end;
+		}
+	}
+	return i + scalarDigits(text + i, length - i);
+}
+
+MONKEY_FILE_LOCAL const Scanner SSE2_SCANNER = {
+		"sse2",
+		sse2Whitespace,
+		sse2Letters,
+		sse2Digits,
+};
+
+#endif
+
+#ifdef MONKEY_SCAN_AVX2
+
+// ---- AVX2 ----
+
+HEDLEY_ALWAYS_INLINE AVX2_FUNCTION MONKEY_FILE_LOCAL __m256i avx2ClassifyWhitespace(
+		__m256i chunk) {
+	__m256i result = _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(' '));
+	result = _mm256_or_si256(result, _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\t')));
+	result = _mm256_or_si256(result, _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\n')));
+	return _mm256_or_si256(result, _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\r')));
+}
+
+HEDLEY_ALWAYS_INLINE AVX2_FUNCTION MONKEY_FILE_LOCAL __m256i avx2ClassifyLetters(__m256i chunk) {
+	__m256i lower = _mm256_or_si256(chunk, _mm256_set1_epi8(0x20));
+	__m256i result = _mm256_and_si256(_mm256_cmpgt_epi8(lower, _mm256_set1_epi8('a' - 1)),
+			_mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), lower));
+	return _mm256_or_si256(result, _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('_')));
+}
+
+HEDLEY_ALWAYS_INLINE AVX2_FUNCTION MONKEY_FILE_LOCAL __m256i avx2ClassifyDigits(__m256i chunk) {
+	return _mm256_and_si256(_mm256_cmpgt_epi8(chunk, _mm256_set1_epi8('0' - 1)),
+			_mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), chunk));
+}
+
+/**
+ * @private
+ *
+ * Returns the index of the first byte of a 32-byte block outside the class, or 32.
+ */
+#define AVX2_RUN_END(classify, text) \
+	((unsigned)__builtin_ctzll((uint64_t)(uint32_t)~(uint32_t)_mm256_movemask_epi8( \
+										  classify(_mm256_loadu_si256((const __m256i*)(text)))) | \
+			(UINT64_C(1) << 32U)))
+
+#define AVX2_BLOCK 32
+
+// Runs shorter than a block are the common case, so what is left after the last full block goes
+// to the SSE2 scanners rather than straight to the scalar ones.
+
+AVX2_FUNCTION MONKEY_FILE_LOCAL size_t avx2Whitespace(const char* text, size_t length) {
+	size_t i = 0;
+	for (; i + AVX2_BLOCK <= length; i += AVX2_BLOCK) {
+		unsigned end = AVX2_RUN_END(avx2ClassifyWhitespace, text + i);
+		if (end < AVX2_BLOCK) {
+			return i + end;
+		}
+	}
+	return i + sse2Whitespace(text + i, length - i);
+}
+
+AVX2_FUNCTION MONKEY_FILE_LOCAL size_t avx2Letters(const char* text, size_t length) {
+	size_t i = 0;
+	for (; i + AVX2_BLOCK <= length; i += AVX2_BLOCK) {
+		unsigned end = AVX2_RUN_END(avx2ClassifyLetters, text + i);
+		if (end < AVX2_BLOCK) {
+			return i + end;
+		}
+	}
+	return i + sse2Letters(text + i, length - i);
+}
+
+AVX2_FUNCTION MONKEY_FILE_LOCAL size_t avx2Digits(const char* text, size_t length) {
+	size_t i = 0;
+	for (; i + AVX2_BLOCK <= length; i += AVX2_BLOCK) {
+		unsigned end = AVX2_RUN_END(avx2ClassifyDigits, text + i);
+		if (end < AVX2_BLOCK) {
+			return i + end;
+		}
+	}
+	return i + sse2Digits(text + i, length - i);
+}
+
+MONKEY_FILE_LOCAL const Scanner AVX2_SCANNER = {
+		"avx2",
+		avx2Whitespace,
+		avx2Letters,
+		avx2Digits,
+};
+
+#endif
+
+const Scanner* GetScanner(void) {
+#ifdef MONKEY_SCAN_AVX2
+	if (__builtin_cpu_supports("avx2")) {
+		return &AVX2_SCANNER;
+	}
+#endif
+#ifdef MONKEY_SCAN_SSE2
+	return &SSE2_SCANNER;
+#else
+	return &SCALAR_SCANNER;
+#endif
+}
+
+const Scanner* GetScalarScanner(void) {
+	return &SCALAR_SCANNER;
+}
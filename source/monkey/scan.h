@@ -0,0 +1,48 @@
+#pragma once
+
+#include "monkey/macros.h"
+
+#include <stddef.h>
+
+/**
+ * @brief ScanFn returns the length of the run of characters of one class at the start of text,
+ * reading no further than length bytes.
+ */
+typedef size_t (*ScanFn)(const char* text, size_t length);
+
+/**
+ * @brief Scanner holds the character-class scanners used by the lexer to skip over whole runs of
+ * whitespace, identifier letters or digits at once.
+ *
+ * The vectorized scanners classify 16 (SSE2) or 32 (AVX2) bytes per step. They never read past the
+ * end of the text, since it may be a mapped file that ends right at a page boundary.
+ */
+typedef struct {
+	const char* name;
+	/**
+	 * @brief whitespace matches ' ', '\t', '\n' and '\r'.
+	 */
+	ScanFn whitespace;
+	/**
+	 * @brief letters matches 'a'-'z', 'A'-'Z' and '_'.
+	 */
+	ScanFn letters;
+	/**
+	 * @brief digits matches '0'-'9'.
+	 */
+	ScanFn digits;
+} Scanner;
+
+/**
+ * @private
+ *
+ * Returns the fastest scanner the CPU supports, unless the build defines MONKEY_DISABLE_SIMD.
+ */
+MONKEY_INTERNAL const Scanner* GetScanner(void);
+
+/**
+ * @private
+ *
+ * Returns the portable byte-at-a-time scanner, which the others must agree with.
+ */
+MONKEY_INTERNAL const Scanner* GetScalarScanner(void);
@@ -0,0 +1,159 @@
+#include "monkey/script.h"
+
+#include "monkey.h"
+#include "monkey/ast.h"
+#include "monkey/compiler.h"
+#include "monkey/environment.h"
+#include "monkey/evaluator.h"
+#include "monkey/file.h"
+#include "monkey/lexer.h"
+#include "monkey/location.h"
+#include "monkey/macros.h"
+#include "monkey/object.h"
+#include "monkey/optimizer.h"
+#include "monkey/parser.h"
+#include "monkey/stream.h"
+#include "monkey/string.h"
+#include "monkey/vm.h"
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+MONKEY_FILE_LOCAL void printErrors(Stream* out, const char* path, MonkeyStringBuffer errors) {
+	for (size_t i = 0; i < errors.length; i++) {
+		(void)StreamPrintf(out, "%s: %s\n", path, errors.data[i]);
+	}
+}
+
+MONKEY_FILE_LOCAL bool runProgram(
+		MonkeyScriptArgs args, Monkey* monkey, Lexer* lexer, Program* program) {
+	Environment* env = NULL;
+	Compiler* compiler = NULL;
+	VM* vm = NULL;
+	Object* result = NULL;
+	if (args.engine == MONKEY_ENGINE_VM) {
+		compiler = CreateCompiler(monkey);
+		if (!Compile(compiler, program)) {
+			printErrors(args.errors, args.path, CompilerErrors(compiler));
+			DestroyCompiler(compiler);
+			return false;
+		}
+		vm = CreateVM(monkey);
+		result = Run(vm, CompilerBytecode(compiler));
+	} else {
+		env = CreateEnvironment(monkey, NULL);
+		result = Eval(monkey, env, &program->base);
+	}
+
+	bool ok = true;
+	if (result != NULL && ObjectTypeOf(result) == OBJECT_TYPE_ERROR) {
+		const ErrorObject* error = (const ErrorObject*)result;
+		if (error->offset == NO_SOURCE_OFFSET) {
+			(void)StreamPrintf(args.errors, "%s: %s\n", args.path, error->message);
+		} else {
+			SourceLocation location = LexerLocate(lexer, error->offset);
+			(void)StreamPrintf(args.errors, "%s:%zu:%zu: %s\n", args.path, location.line,
+					location.column, error->message);
+		}
+		ok = false;
+	} else if (result != NULL && ObjectTypeOf(result) != OBJECT_TYPE_NULL) {
+		char* text = InspectObject(result);
+		WriteStream(args.writer, text, strlen(text));
+		free(text);
+		WriteStream(args.writer, "\n", 1);
+	}
+
+	if (args.engine == MONKEY_ENGINE_VM) {
+		DestroyVM(vm);
+		DestroyCompiler(compiler);
+	} else {
+		DestroyEnvironment(env);
+	}
+	return ok;
+}
+
+MONKEY_FILE_LOCAL bool runLexer(MonkeyScriptArgs args, Monkey* monkey, Lexer* lexer) {
+	Parser* parser = CreateParser(lexer);
+	Program* program = ParseProgram(parser);
+	MonkeyStringBuffer errors = ParserErrors(parser);
+	bool ok = errors.length == 0;
+	if (ok) {
+		if (args.optimize) {
+			OptimizeProgram(program);
+		}
+		ok = runProgram(args, monkey, lexer, program);
+	} else {
+		// parse errors already start with their line and column
+		for (size_t i = 0; i < errors.length; i++) {
+			(void)StreamPrintf(args.errors, "%s:%s\n", args.path, errors.data[i]);
+		}
+	}
+
+	DestroyProgram(program);
+	DestroyParser(parser);
+	return ok;
+}
+
+MONKEY_FILE_LOCAL bool runStream(MonkeyScriptArgs args, Stream* reader) {
+	Monkey* monkey = CreateMonkey();
+	Lexer* lexer = CreateStreamLexer(monkey, reader, LEXER_CHUNK_SIZE);
+	bool ok = runLexer(args, monkey, lexer);
+	DestroyLexer(lexer);
+	DestroyMonkey(monkey);
+	if (StreamError(reader) != 0) {
+		// the program ran on whatever was read before the failure
+		(void)StreamPrintf(args.errors, "%s: %s\n", args.path, strerror(StreamError(reader)));
+		ok = false;
+	}
+	return ok;
+}
+
+/**
+ * @private
+ *
+ * Runs a file that cannot be mapped, such as a pipe, by reading it as a stream.
+ */
+MONKEY_FILE_LOCAL bool runUnmappedFile(MonkeyScriptArgs args) {
+	FILE* file = NULL;
+#ifdef _WIN32
+	(void)fopen_s(&file, args.path, "rb");
+#else
+	file = fopen(args.path, "rb");
+#endif
+	if (file == NULL) {
+		(void)StreamPrintf(args.errors, "%s: %s\n", args.path, strerror(errno));
+		return false;
+	}
+	Stream* reader = StreamFromFile(file);
+	bool ok = runStream(args, reader);
+	CloseStream(reader);
+	return ok;
+}
+
+bool MonkeyRunScript(MonkeyScriptArgs args) {
+	if (strcmp(args.path, "-") == 0) {
+		return runStream(args, args.reader);
+	}
+
+	MappedFile* file = MapFile(args.path);
+	if (file == NULL && errno == ENODEV) {
+		return runUnmappedFile(args);
+	}
+	if (file == NULL) {
+		(void)StreamPrintf(args.errors, "%s: %s\n", args.path, strerror(errno));
+		return false;
+	}
+
+	Monkey* monkey = CreateMonkey();
+	Lexer* lexer = CreateLexerFromView(monkey, MappedFileContents(file));
+	bool ok = runLexer(args, monkey, lexer);
+	DestroyLexer(lexer);
+	// function objects may still refer to the text of the file until the heap is gone
+	DestroyMonkey(monkey);
+	UnmapFile(file);
+	return ok;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "monkey/engine.h"
+#include "monkey/stream.h"
+
+#include <stdbool.h>
+
+/**
+ * @brief MonkeyScriptArgs is a struct that holds the arguments for running a script.
+ */
+typedef struct {
+	/**
+	 * @brief path is the file to run, or "-" to run whatever reader supplies.
+	 */
+	const char* path;
+	/**
+	 * @brief reader is only used when path is "-".
+	 */
+	Stream* reader;
+	/**
+	 * @brief writer receives the value of the program, unless it is null.
+	 */
+	Stream* writer;
+	/**
+	 * @brief errors receives parse, compile and runtime errors, each prefixed with the path.
+	 */
+	Stream* errors;
+	/**
+	 * @brief engine defaults to MONKEY_ENGINE_EVALUATOR.
+	 */
+	MonkeyEngine engine;
+	/**
+	 * @brief optimize runs OptimizeProgram on the program before it is run.
+	 */
+	bool optimize;
+} MonkeyScriptArgs;
+
+/**
+ * @brief MonkeyRunScript runs a whole file as one Monkey program.
+ *
+ * The file is mapped into memory rather than read, so that its text is lexed in place. A program
+ * from a reader is lexed as it is read instead, so it need not fit in memory as a whole, and so
+ * is a file that cannot be mapped, such as a pipe.
+ *
+ * @param args The path, writers and engine.
+ * @return Whether the file was read, parsed and run without errors.
+ */
+bool MonkeyRunScript(MonkeyScriptArgs args);
+#define MONKEY_RUN_SCRIPT(...) MonkeyRunScript((MonkeyScriptArgs){__VA_ARGS__})
@@ -1,14 +1,35 @@
+#ifndef _WIN32
+// read, lseek and fileno are POSIX, not C11
+#define _POSIX_C_SOURCE 200112L
+#endif
+
 #include "monkey/stream.h"
 
+#include "monkey/macros.h"
+#include "monkey/string.h"
+#include "span.h"
+
+#include <errno.h>
 #include <stdarg.h>
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
 
 Stream* StreamFromFile(FILE* file) {
+	return StreamFromFileWithBuffer(file, STREAM_DEFAULT_BUFFER_SIZE);
+}
+
+Stream* StreamFromFileWithBuffer(FILE* file, size_t bufferSize) {
 	Stream* result = calloc(1, sizeof(Stream));
 	result->file = file;
+	result->bufferSize = bufferSize;
 	return result;
 }
 
@@ -20,20 +41,149 @@ Stream* StreamFromText(char* text, size_t text_length) {
 	return result;
 }
 
+Stream* StreamToMemory(void) {
+	Stream* result = calloc(1, sizeof(Stream));
+	result->growable = true;
+	return result;
+}
+
 #ifndef MIN
 #define MIN(a, b) ((a) < (b) ? (a) : (b))
 #endif
 
+/**
+ * @private
+ *
+ * Makes room in a memory stream for count more characters at its position, and a terminator.
+ */
+MONKEY_FILE_LOCAL void reserveText(Stream* stream, size_t count) {
+	size_t needed = stream->textPosition + count + 1;
+	if (needed <= stream->textCapacity) {
+		return;
+	}
+	size_t capacity = stream->textCapacity * 2;
+	stream->textCapacity = capacity > needed ? capacity : needed;
+	stream->text = realloc(stream->text, stream->textCapacity);
+}
+
+/**
+ * @private
+ *
+ * Moves the position of a text stream past what was just written there.
+ */
+MONKEY_FILE_LOCAL void advanceText(Stream* stream, size_t count) {
+	stream->textPosition += count;
+	if (stream->textPosition > stream->textLength) {
+		stream->textLength = stream->textPosition;
+	}
+}
+
+char* TakeStreamText(Stream* stream, size_t* length) {
+	if (!stream->growable) {
+		return NULL;
+	}
+	stream->textPosition = stream->textLength;
+	reserveText(stream, 0);
+	stream->text[stream->textLength] = '\0';
+	if (length != NULL) {
+		*length = stream->textLength;
+	}
+	char* result = stream->text;
+	stream->text = NULL;
+	stream->textLength = 0;
+	stream->textPosition = 0;
+	stream->textCapacity = 0;
+	return result;
+}
+
+/**
+ * @private
+ *
+ * Reads what the file of a stream has ready, up to size characters, waiting only if it has
+ * nothing.
+ *
+ * @return The number of characters read, or zero at the end of the file or on an error, which is
+ * kept in the stream.
+ */
+MONKEY_FILE_LOCAL size_t readFile(Stream* stream, char* buffer, size_t size) {
+	if (stream->tied != NULL) {
+		(void)FlushStream(stream->tied);
+	}
+	while (true) {
+#ifdef _WIN32
+		int result =
+				_read(_fileno(stream->file), buffer, (unsigned int)MIN(size, (size_t)INT32_MAX));
+#else
+		ssize_t result = read(fileno(stream->file), buffer, size);
+#endif
+		if (result >= 0) {
+			return (size_t)result;
+		}
+		// a signal arriving while waiting is not the end of the file
+		if (errno != EINTR) {
+			stream->error = errno;
+			return 0;
+		}
+	}
+}
+
+MONKEY_FILE_LOCAL void seekFile(FILE* file) {
+	(void)fseek(file, 0, SEEK_SET);
+	// reads bypass the file, so its descriptor has to be moved as well
+#ifdef _WIN32
+	(void)_lseek(_fileno(file), 0, SEEK_SET);
+#else
+	(void)lseek(fileno(file), 0, SEEK_SET);
+#endif
+}
+
+/**
+ * @private
+ *
+ * Returns what can be taken from a stream without waiting, reading more into its input buffer if
+ * it has nothing. The view is empty at the end of the stream.
+ */
+MONKEY_FILE_LOCAL MonkeyStringView peekInput(Stream* stream) {
+	if (stream->file == NULL) {
+		return (MonkeyStringView)SPAN_WITH_LENGTH(stream->text + stream->textPosition,
+				stream->textLength - stream->textPosition);
+	}
+	if (stream->inputPosition == stream->inputLength) {
+		if (stream->input == NULL) {
+			stream->input = malloc(stream->bufferSize);
+		}
+		stream->inputPosition = 0;
+		stream->inputLength = readFile(stream, stream->input, stream->bufferSize);
+	}
+	return (MonkeyStringView)SPAN_WITH_LENGTH(
+			stream->input + stream->inputPosition, stream->inputLength - stream->inputPosition);
+}
+
+MONKEY_FILE_LOCAL void takeInput(Stream* stream, size_t count) {
+	if (stream->file == NULL) {
+		stream->textPosition += count;
+	} else {
+		stream->inputPosition += count;
+	}
+}
+
 int64_t ReadStream(Stream* stream, char* buffer, size_t buffer_size) {
-	if (stream->file) {
-		return (int64_t)fread(buffer, 1, buffer_size, stream->file);
+	if (buffer_size == 0) {
+		return 0;
+	}
+	if (stream->file != NULL && stream->inputPosition == stream->inputLength &&
+			buffer_size >= stream->bufferSize) {
+		// large reads skip the input buffer, which would only add a copy
+		size_t read = readFile(stream, buffer, buffer_size);
+		return read > 0 ? (int64_t)read : -1;
 	}
-	if (stream->textPosition == stream->textLength) {
+	MonkeyStringView available = peekInput(stream);
+	if (available.length == 0) {
 		return -1;
 	}
-	size_t bytesToRead = MIN(buffer_size, stream->textLength - stream->textPosition);
-	memcpy(buffer, stream->text + stream->textPosition, bytesToRead);
-	stream->textPosition += bytesToRead;
+	size_t bytesToRead = MIN(buffer_size, available.length);
+	memcpy(buffer, available.begin, bytesToRead);
+	takeInput(stream, bytesToRead);
 	return (int64_t)bytesToRead;
 }
 
@@ -45,31 +195,29 @@ int64_t ReadStreamLine(char** buffer, size_t* buffer_size, Stream* stream) {
 		*buffer_size = INITIAL_BUFFER_SIZE;
 		*buffer = malloc(*buffer_size);
 	}
-	while (1) {
-		int c;
-		if (stream->file) {
-			c = fgetc(stream->file);
-		} else {
-			if (stream->textPosition == stream->textLength) {
-				c = EOF;
-			} else {
-				c = (unsigned char)stream->text[stream->textPosition++];
-			}
-		}
-		if (c == EOF) {
-			if (bytesRead == 0) {
+	while (true) {
+		MonkeyStringView available = peekInput(stream);
+		if (available.length == 0) {
+			if (bytesRead == 0 || stream->error != 0) {
 				return -1;
 			}
 			break;
 		}
-		if (c == '\n') {
-			break;
-		}
-		(*buffer)[bytesRead++] = (char)c;
-		if (bytesRead == *buffer_size) {
-			*buffer_size *= 2;
+		const char* newline = memchr(available.begin, '\n', available.length);
+		size_t count = newline != NULL ? (size_t)(newline - available.begin) : available.length;
+		if (bytesRead + count >= *buffer_size) {
+			while (bytesRead + count >= *buffer_size) {
+				*buffer_size *= 2;
+			}
 			*buffer = realloc(*buffer, *buffer_size);
 		}
+		memcpy(*buffer + bytesRead, available.begin, count);
+		bytesRead += count;
+		if (newline != NULL) {
+			takeInput(stream, count + 1);
+			break;
+		}
+		takeInput(stream, count);
 	}
 	(*buffer)[bytesRead] = '\0';
 	return (int64_t)bytesRead;
@@ -77,10 +225,29 @@ int64_t ReadStreamLine(char** buffer, size_t* buffer_size, Stream* stream) {
 
 int64_t WriteStream(Stream* stream, const char* buffer, size_t buffer_size) {
 	if (stream->file) {
-		return (int64_t)fwrite(buffer, 1, buffer_size, stream->file);
+		if (buffer_size > stream->bufferSize - stream->outputLength && !FlushStream(stream)) {
+			return -1;
+		}
+		if (buffer_size >= stream->bufferSize) {
+			// large writes skip the output buffer, which was just emptied
+			size_t written = fwrite(buffer, 1, buffer_size, stream->file);
+			return written == buffer_size ? (int64_t)written : -1;
+		}
+		if (stream->output == NULL) {
+			stream->output = malloc(stream->bufferSize);
+		}
+		memcpy(stream->output + stream->outputLength, buffer, buffer_size);
+		stream->outputLength += buffer_size;
+		return (int64_t)buffer_size;
+	}
+	if (stream->growable) {
+		reserveText(stream, buffer_size);
+		memcpy(stream->text + stream->textPosition, buffer, buffer_size);
+		advanceText(stream, buffer_size);
+		return (int64_t)buffer_size;
 	}
 	size_t bytesToCopy = MIN(buffer_size, stream->textLength - stream->textPosition);
-	if (bytesToCopy == 0) {
+	if (bytesToCopy == 0 && buffer_size > 0) {
 		return -1;
 	}
 	memcpy(stream->text + stream->textPosition, buffer, bytesToCopy);
@@ -88,26 +255,102 @@ int64_t WriteStream(Stream* stream, const char* buffer, size_t buffer_size) {
 	return (int64_t)bytesToCopy;
 }
 
+/**
+ * @private
+ *
+ * Formats into the output buffer of a file stream, flushing it first if there is not enough room
+ * left. Text too long for the buffer is written to the file directly.
+ */
+MONKEY_FILE_LOCAL int64_t printFile(Stream* stream, const char* format, va_list args) {
+	if (stream->output == NULL) {
+		stream->output = malloc(stream->bufferSize);
+	}
+	va_list argsCopy;
+	va_copy(argsCopy, args);
+	size_t room = stream->bufferSize - stream->outputLength;
+	int result = vsnprintf(stream->output + stream->outputLength, room, format, argsCopy);
+	va_end(argsCopy);
+	if (result < 0) {
+		return -1;
+	}
+	if ((size_t)result >= room) {
+		if (!FlushStream(stream)) {
+			return -1;
+		}
+		if ((size_t)result >= stream->bufferSize) {
+			return vfprintf(stream->file, format, args);
+		}
+		(void)vsnprintf(stream->output, stream->bufferSize, format, args);
+	}
+	stream->outputLength += (size_t)result;
+	return result;
+}
+
+/**
+ * @private
+ *
+ * Formats for a text stream, which then takes the text the way WriteStream does. Formatting in
+ * place would store a terminator over whatever follows the position.
+ */
+MONKEY_FILE_LOCAL int64_t printText(Stream* stream, const char* format, va_list args) {
+	char small[256];
+	va_list argsCopy;
+	va_copy(argsCopy, args);
+	int length = vsnprintf(small, sizeof small, format, argsCopy);
+	va_end(argsCopy);
+	if (length < 0) {
+		return -1;
+	}
+	if ((size_t)length < sizeof small) {
+		return WriteStream(stream, small, (size_t)length);
+	}
+	char* text = malloc((size_t)length + 1);
+	(void)vsnprintf(text, (size_t)length + 1, format, args);
+	int64_t result = WriteStream(stream, text, (size_t)length);
+	free(text);
+	return result;
+}
+
 int64_t StreamPrintf(Stream* stream, const char* format, ...) {
 	va_list args;
 	va_start(args, format);
 	int64_t result = 0;
 	if (stream->file) {
-		result = vfprintf(stream->file, format, args);
+		result = printFile(stream, format, args);
 	} else {
-		result = vsnprintf(stream->text + stream->textPosition,
-				stream->textLength - stream->textPosition, format, args);
-		if (result > 0) {
-			stream->textPosition += (size_t)result;
-		}
+		result = printText(stream, format, args);
 	}
 	va_end(args);
 	return result;
 }
 
+bool FlushStream(Stream* stream) {
+	if (stream->file == NULL) {
+		return true;
+	}
+	size_t length = stream->outputLength;
+	stream->outputLength = 0;
+	if (length > 0 && fwrite(stream->output, 1, length, stream->file) != length) {
+		return false;
+	}
+	return fflush(stream->file) == 0;
+}
+
+int StreamError(const Stream* stream) {
+	return stream->error;
+}
+
+void TieStream(Stream* input, Stream* output) {
+	input->tied = output;
+}
+
 void RewindStream(Stream* stream) {
 	if (stream->file) {
-		(void)fseek(stream->file, 0, SEEK_SET);
+		(void)FlushStream(stream);
+		seekFile(stream->file);
+		stream->inputPosition = 0;
+		stream->inputLength = 0;
+		stream->error = 0;
 	} else {
 		stream->textPosition = 0;
 	}
@@ -115,7 +358,13 @@ void RewindStream(Stream* stream) {
 
 void CloseStream(Stream* stream) {
 	if (stream->file) {
+		(void)FlushStream(stream);
 		(void)fclose(stream->file);
 	}
+	if (stream->growable) {
+		free(stream->text);
+	}
+	free(stream->input);
+	free(stream->output);
 	free(stream);
 }
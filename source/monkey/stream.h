@@ -1,6 +1,7 @@
 #pragma once
 
 #include <hedley.h>
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -8,23 +9,82 @@
 /**
  * @brief Stream is an abstraction for text I/O.
  *
- * Streams are used to read and write text data. They may be backed by either a file or a string.
+ * Streams are used to read and write text data. They may be backed by a file, a string of fixed
+ * size, or memory that grows to hold whatever is written.
+ *
+ * File streams have buffers of their own, so that reading and writing take a few large calls into
+ * the system rather than one per character or fragment. Reads go straight to the descriptor under
+ * the file, and return what it has, so nothing else should read from the file. Writes are kept
+ * until the buffer fills or the stream is flushed, rewound or closed. A read that fails ends the
+ * stream like the end of the file does, and StreamError tells the two apart.
  */
-typedef struct {
+typedef struct Stream {
 	FILE* file;
 	char* text;
+	/**
+	 * @brief textLength is the size of the string of a text stream, and how much was written to a
+	 * memory stream.
+	 */
 	size_t textLength;
 	size_t textPosition;
+	/**
+	 * @brief growable is set for memory streams, which own text and grow it up to textCapacity
+	 * as needed.
+	 */
+	bool growable;
+	size_t textCapacity;
+	/**
+	 * @brief bufferSize is the size of the input and output buffers of a file stream, which are
+	 * only allocated once they are used.
+	 */
+	size_t bufferSize;
+	/**
+	 * @brief input holds what was read from the file but not taken yet, from inputPosition up to
+	 * inputLength.
+	 */
+	char* input;
+	size_t inputPosition;
+	size_t inputLength;
+	/**
+	 * @brief output holds what was written to the stream but not to the file yet.
+	 */
+	char* output;
+	size_t outputLength;
+	/**
+	 * @brief tied is flushed whenever the stream has to wait for its file (see TieStream).
+	 */
+	struct Stream* tied;
+	/**
+	 * @brief error is the errno of a read from the file that failed, or zero.
+	 */
+	int error;
 } Stream;
 
 /**
- * @brief StreamFromFile creates a stream from a file.
+ * @brief STREAM_DEFAULT_BUFFER_SIZE is the size of the buffers of streams made by StreamFromFile.
+ */
+#define STREAM_DEFAULT_BUFFER_SIZE ((size_t)64 << 10U)
+
+/**
+ * @brief StreamFromFile creates a stream from a file, with buffers of the default size.
+ *
+ * The stream reads the descriptor under the file, so the file must not have been read through
+ * stdio already: whatever stdio buffered would be skipped.
  *
  * @param file The file to read from.
  * @return The stream.
  */
 Stream* StreamFromFile(FILE* file);
 
+/**
+ * @brief StreamFromFileWithBuffer creates a stream from a file, with buffers of the given size.
+ *
+ * @param file The file to read from.
+ * @param bufferSize The size of each buffer, which must not be zero.
+ * @return The stream.
+ */
+Stream* StreamFromFileWithBuffer(FILE* file, size_t bufferSize);
+
 /**
  * @brief StreamFromText creates a stream from a string.
  *
@@ -34,6 +94,24 @@ Stream* StreamFromFile(FILE* file);
  */
 Stream* StreamFromText(char* text, size_t text_length);
 
+/**
+ * @brief StreamToMemory creates a stream that keeps whatever is written to it, however much that
+ * is. It can be rewound and read back like a text stream.
+ *
+ * @return The stream.
+ */
+Stream* StreamToMemory(void);
+
+/**
+ * @brief TakeStreamText takes the text written to a memory stream, which is left empty.
+ *
+ * @param stream The memory stream.
+ * @param length Set to the length of the text, if not NULL.
+ * @return The text, which is NUL-terminated and owned by the caller, or NULL if the stream is not
+ * a memory stream.
+ */
+char* TakeStreamText(Stream* stream, size_t* length);
+
 /**
  * @brief ReadStream reads characters into a buffer.
  *
@@ -41,7 +119,8 @@ Stream* StreamFromText(char* text, size_t text_length);
  * @param buffer The buffer to read into.
  * @param buffer_size The size of the buffer.
  * @return The number of characters read, or -1 if end-of-stream was reached and no characters were
- * read.
+ * read, or if reading failed. File streams may read fewer characters than asked for before the
+ * end, such as a line typed into a terminal.
  */
 int64_t ReadStream(Stream* stream, char* buffer, size_t buffer_size);
 
@@ -53,17 +132,24 @@ int64_t ReadStream(Stream* stream, char* buffer, size_t buffer_size);
  * @param buffer_size The size of the buffer.
  * @param stream The stream to read from.
  * @return The number of characters read, or -1 if end-of-stream was reached and no characters were
- * read.
+ * read, or if reading failed.
  */
 int64_t ReadStreamLine(char** buffer, size_t* buffer_size, Stream* stream);
 
+/**
+ * @brief StreamError returns why reading from a file stream failed, as an errno value, or zero if
+ * it has not.
+ */
+int StreamError(const Stream* stream);
+
 /**
  * @brief WriteStream writes characters from a buffer.
  *
  * @param stream The stream to write to.
  * @param buffer The buffer to write from.
  * @param buffer_size The size of the buffer.
- * @return The number of characters written, or -1 if an error occurred.
+ * @return The number of characters written, which is fewer than buffer_size at the end of a text
+ * stream, or -1 if a text stream is full or an error occurred.
  */
 int64_t WriteStream(Stream* stream, const char* buffer, size_t buffer_size);
 
@@ -72,10 +158,30 @@ int64_t WriteStream(Stream* stream, const char* buffer, size_t buffer_size);
  *
  * @param stream The stream to write to.
  * @param format The format string.
- * @return The number of characters written, or -1 if an error occurred.
+ * @return The number of characters written, which is fewer than formatted at the end of a text
+ * stream, or -1 if a text stream is full or an error occurred. Text streams take formatted text
+ * the way WriteStream takes a buffer, without a terminator.
  */
 int64_t StreamPrintf(Stream* stream, const char* format, ...) HEDLEY_PRINTF_FORMAT(2, 3);
 
+/**
+ * @brief FlushStream writes whatever was written to a stream out to its file.
+ *
+ * @param stream The stream to flush.
+ * @return Whether everything was written.
+ */
+bool FlushStream(Stream* stream);
+
+/**
+ * @brief TieStream makes an input stream flush an output stream whenever it has to wait for more
+ * input, so that a prompt is seen before the answer to it is read. Input that is already there
+ * is read without flushing, so that piped input does not cost a write for every read.
+ *
+ * @param input The stream to read from.
+ * @param output The stream to flush, or NULL to stop flushing one.
+ */
+void TieStream(Stream* input, Stream* output);
+
 /**
  * @brief RewindStream rewinds a stream to the beginning.
  *
@@ -84,7 +190,7 @@ int64_t StreamPrintf(Stream* stream, const char* format, ...) HEDLEY_PRINTF_FORM
 void RewindStream(Stream* stream);
 
 /**
- * @brief CloseStream closes the stream.
+ * @brief CloseStream flushes and closes the stream.
  *
  * @param stream The stream to close.
  */
@@ -1,9 +1,13 @@
 #include "monkey/string.h"
 
 #include "buffer.h"
+#include "monkey/macros.h"
+#include "span.h"
 
 #include <stdarg.h>
+#include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -23,6 +27,27 @@ char* MonkeyStrndup(const char* str, size_t n) {
 	return result;
 }
 
+MonkeyStringView MonkeyStringViewFrom(const char* str) {
+	return (MonkeyStringView)SPAN_WITH_LENGTH(str, strlen(str));
+}
+
+char* MonkeyStringViewDup(MonkeyStringView view) {
+	return MonkeyStrndup(view.begin, view.length);
+}
+
+bool MonkeyStringViewEqual(MonkeyStringView a, MonkeyStringView b) {
+	return a.length == b.length && (a.length == 0 || memcmp(a.begin, b.begin, a.length) == 0);
+}
+
+uint32_t MonkeyStringViewHash(MonkeyStringView view) {
+	// djb2, same as g_str_hash
+	uint32_t hash = 5381;
+	for (size_t i = 0; i < view.length; ++i) {
+		hash = (hash << 5U) + hash + (unsigned char)view.begin[i];
+	}
+	return hash;
+}
+
 char* MonkeyAsprintf(const char* format, ...) {
 	if (format == NULL) {
 		return NULL;
@@ -71,3 +96,59 @@ char* MonkeyStringJoin(MonkeyStringSpan strings) {
 	BUFFER_FREE(lengths);
 	return result;
 }
+
+/**
+ * @private
+ *
+ * Makes room for count more characters and a terminator at the end of a builder.
+ */
+MONKEY_FILE_LOCAL void reserve(MonkeyStringBuilder* builder, size_t count) {
+	size_t needed = builder->length + count + 1;
+	if (needed <= builder->capacity) {
+		return;
+	}
+	size_t capacity = builder->capacity * 2;
+	builder->capacity = capacity > needed ? capacity : needed;
+	builder->data = realloc(builder->data, builder->capacity);
+}
+
+void MonkeyStringBuilderAppend(MonkeyStringBuilder* builder, const char* str) {
+	MonkeyStringBuilderAppendView(builder, MonkeyStringViewFrom(str));
+}
+
+void MonkeyStringBuilderAppendView(MonkeyStringBuilder* builder, MonkeyStringView view) {
+	if (view.length == 0) {
+		return;
+	}
+	reserve(builder, view.length);
+	memcpy(builder->data + builder->length, view.begin, view.length);
+	builder->length += view.length;
+}
+
+void MonkeyStringBuilderAppendFormat(MonkeyStringBuilder* builder, const char* format, ...) {
+	// most formats fit in the room already there, so try that first
+	reserve(builder, 0);
+	size_t room = builder->capacity - builder->length;
+	va_list args;
+	va_start(args, format);
+	va_list argsCopy;
+	va_copy(argsCopy, args);
+	int len = vsnprintf(builder->data + builder->length, room, format, argsCopy);
+	va_end(argsCopy);
+	if (len >= 0 && (size_t)len >= room) {
+		reserve(builder, (size_t)len);
+		(void)vsnprintf(builder->data + builder->length, (size_t)len + 1, format, args);
+	}
+	va_end(args);
+	if (len > 0) {
+		builder->length += (size_t)len;
+	}
+}
+
+char* MonkeyStringBuilderFinish(MonkeyStringBuilder* builder) {
+	reserve(builder, 0);
+	builder->data[builder->length] = '\0';
+	char* result = builder->data;
+	*builder = (MonkeyStringBuilder)BUFFER_INIT;
+	return result;
+}
@@ -3,8 +3,11 @@
 #include "buffer.h"
 #include "span.h"
 
+#include <hedley.h>
 #include <stdarg.h>
+#include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
 /**
  * @brief Allocates a new string and copies the given string into it.
@@ -21,6 +24,36 @@ char* MonkeyStrdup(const char* str);
  */
 char* MonkeyStrndup(const char* str, size_t n);
 
+/**
+ * @brief A non-owning view of a run of characters. Not necessarily NUL-terminated.
+ */
+typedef SPAN_TYPE(const char) MonkeyStringView;
+
+/**
+ * @brief Creates a view of a NUL-terminated string.
+ * @param str The string to view.
+ * @return A view of the string, excluding the terminator.
+ */
+MonkeyStringView MonkeyStringViewFrom(const char* str);
+
+/**
+ * @brief Allocates a new NUL-terminated string holding the characters of the view.
+ * @param view The view to copy.
+ * @return A new string.
+ */
+char* MonkeyStringViewDup(MonkeyStringView view);
+
+/**
+ * @brief Compares the characters of two views.
+ * @return Whether the views hold the same characters.
+ */
+bool MonkeyStringViewEqual(MonkeyStringView a, MonkeyStringView b);
+
+/**
+ * @brief Hashes the characters of a view. Equal views hash equally.
+ */
+uint32_t MonkeyStringViewHash(MonkeyStringView view);
+
 /**
  * @brief Allocates a new string and formats the given arguments into it.
  * @param format The format string.
@@ -48,3 +81,35 @@ typedef BUFFER_TYPE(char*) MonkeyStringBuffer;
 typedef SPAN_TYPE(char*) MonkeyStringSpan;
 
 char* MonkeyStringJoin(MonkeyStringSpan strings);
+
+/**
+ * @brief A string that is built by appending to it in place, growing as needed. Start one with
+ * BUFFER_INIT.
+ */
+typedef BUFFER_TYPE(char) MonkeyStringBuilder;
+
+/**
+ * @brief Appends a NUL-terminated string to a builder.
+ */
+void MonkeyStringBuilderAppend(MonkeyStringBuilder* builder, const char* str);
+
+/**
+ * @brief Appends the characters of a view to a builder.
+ */
+void MonkeyStringBuilderAppendView(MonkeyStringBuilder* builder, MonkeyStringView view);
+
+/**
+ * @brief Formats the given arguments onto the end of a builder.
+ * @param builder The builder.
+ * @param format The format string.
+ * @param ... The arguments to format.
+ */
+void MonkeyStringBuilderAppendFormat(MonkeyStringBuilder* builder, const char* format, ...)
+		HEDLEY_PRINTF_FORMAT(2, 3);
+
+/**
+ * @brief Takes the string out of a builder, which is left empty for reuse.
+ * @param builder The builder.
+ * @return The NUL-terminated string, which is never NULL.
+ */
+char* MonkeyStringBuilderFinish(MonkeyStringBuilder* builder);
@@ -0,0 +1,84 @@
+#include "monkey/symbol.h"
+
+#include "monkey.h"
+#include "monkey/arena.h"
+#include "monkey/macros.h"
+#include "monkey/string.h"
+#include "monkey/token.h"
+#include "span.h"
+
+#include <glib.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct MonkeySymbolTable {
+	/**
+	 * @brief arena holds the symbols and their names, which are never freed individually.
+	 */
+	Arena* arena;
+	/**
+	 * @brief store maps names to symbols. Keys are the symbols' own names.
+	 */
+	GHashTable* store;
+};
+
+MONKEY_FILE_LOCAL guint tblHashName(gconstpointer key) {
+	return MonkeyStringViewHash(*(const MonkeyStringView*)key);
+}
+
+MONKEY_FILE_LOCAL gboolean tblNameEqual(gconstpointer a, gconstpointer b) {
+	return MonkeyStringViewEqual(*(const MonkeyStringView*)a, *(const MonkeyStringView*)b);
+}
+
+MONKEY_FILE_LOCAL MonkeySymbol* intern(MonkeySymbolTable* symbols, MonkeyStringView name) {
+	MonkeySymbol* symbol = g_hash_table_lookup(symbols->store, &name);
+	if (symbol != NULL) {
+		return symbol;
+	}
+	symbol = ArenaAllocate(symbols->arena, sizeof(MonkeySymbol));
+	char* text = ArenaCopy(symbols->arena, name.begin, name.length);
+	symbol->name = (MonkeyStringView)SPAN_WITH_LENGTH((const char*)text, name.length);
+	symbol->id = g_hash_table_size(symbols->store);
+	symbol->tokenType = TOKEN_TYPE_IDENT;
+	g_hash_table_insert(symbols->store, &symbol->name, symbol);
+	return symbol;
+}
+
+MonkeySymbolTable* CreateSymbolTable(void) {
+	typedef struct {
+		TokenType type;
+		const char* text;
+	} Keyword;
+	const Keyword keywords[] = {
+			{TOKEN_TYPE_ELSE, "else"},
+			{TOKEN_TYPE_FALSE, "false"},
+			{TOKEN_TYPE_FUNCTION, "fn"},
+			{TOKEN_TYPE_IF, "if"},
+			{TOKEN_TYPE_LET, "let"},
+			{TOKEN_TYPE_RETURN, "return"},
+			{TOKEN_TYPE_TRUE, "true"},
+	};
+
+	MonkeySymbolTable* symbols = malloc(sizeof(MonkeySymbolTable));
+	symbols->arena = CreateArena();
+	symbols->store = g_hash_table_new(tblHashName, tblNameEqual);
+	for (size_t i = 0; i < sizeof keywords / sizeof keywords[0]; ++i) {
+		intern(symbols, MonkeyStringViewFrom(keywords[i].text))->tokenType = keywords[i].type;
+	}
+	return symbols;
+}
+
+void DestroySymbolTable(MonkeySymbolTable* symbols) {
+	g_hash_table_destroy(symbols->store);
+	ReleaseArena(symbols->arena);
+	free(symbols);
+}
+
+const MonkeySymbol* MonkeyIntern(Monkey* monkey, MonkeyStringView name) {
+	return intern(MonkeyGetSymbols(monkey), name);
+}
+
+size_t MonkeySymbolCount(Monkey* monkey) {
+	return g_hash_table_size(MonkeyGetSymbols(monkey)->store);
+}
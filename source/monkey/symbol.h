@@ -0,0 +1,55 @@
+#pragma once
+
+#include "monkey.h"
+#include "monkey/macros.h"
+#include "monkey/string.h"
+#include "monkey/token.h"
+
+#include <stddef.h>
+
+/**
+ * @brief MonkeySymbol is an interned identifier. Every occurrence of a name within one Monkey
+ * instance maps to the same symbol, so names can be compared and hashed by pointer.
+ *
+ * Symbols live as long as the Monkey instance that interned them.
+ */
+typedef struct MonkeySymbol {
+	/**
+	 * @brief name is owned by the symbol table, so it outlives the source it was lexed from.
+	 */
+	MonkeyStringView name;
+	/**
+	 * @brief id numbers symbols densely in the order they were interned.
+	 */
+	size_t id;
+	/**
+	 * @brief tokenType is the keyword this name spells, or TOKEN_TYPE_IDENT.
+	 */
+	TokenType tokenType;
+} MonkeySymbol;
+
+/**
+ * @private
+ *
+ * Creates a symbol table with the keywords already interned.
+ */
+MONKEY_INTERNAL MonkeySymbolTable* CreateSymbolTable(void);
+
+/**
+ * @private
+ */
+MONKEY_INTERNAL void DestroySymbolTable(MonkeySymbolTable* symbols);
+
+/**
+ * @brief Returns the symbol for a name, interning it the first time the name is seen.
+ *
+ * @param monkey the library instance
+ * @param name the name, which is copied if it is new
+ * @return const MonkeySymbol* the symbol
+ */
+const MonkeySymbol* MonkeyIntern(Monkey* monkey, MonkeyStringView name);
+
+/**
+ * @brief Returns how many distinct symbols have been interned, keywords included.
+ */
+size_t MonkeySymbolCount(Monkey* monkey);
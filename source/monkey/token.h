@@ -1,6 +1,9 @@
 #pragma once
 
 #include "monkey.h"
+#include "monkey/string.h"
+
+#include <stddef.h>
 
 /**
  * @brief TOKEN_TYPES_X is a list of all the token types.
@@ -46,38 +49,38 @@ typedef enum {
 
 /**
  * @brief Token is a struct that holds information about a token.
+ *
+ * The literal is a view into the text the token was lexed from, so tokens own no memory and the
+ * lexer input must outlive every token (and AST node) produced from it. Stream lexers point
+ * literals into memory that lives as long as the program parsed from them instead.
  */
+// avoid cyclic include with monkey/symbol.h here
+struct MonkeySymbol;
+
 typedef struct {
 	TokenType type;
-	char* literal;
+	MonkeyStringView literal;
+	/**
+	 * @brief symbol is the interned name of identifiers and keywords, and NULL for other tokens.
+	 */
+	const struct MonkeySymbol* symbol;
+	/**
+	 * @brief offset is the byte offset of the start of the token in the lexer input.
+	 */
+	size_t offset;
 } Token;
 
-/**
- * @private
- */
-MONKEY_INTERNAL MonkeyTokenState* CreateTokenState(void);
-
-/**
- * @private
- */
-MONKEY_INTERNAL void DestroyTokenState(MonkeyTokenState* state);
-
 /**
  * @brief Returns the string representation of the given token type.
  */
 const char* TokenTypeText(TokenType type);
 
 /**
- * @brief CopyToken copies the given token into a new token.
+ * @brief CopyToken copies the given token into a new token. This does not allocate.
  */
 Token CopyToken(Token* token);
 
 /**
- * @brief Destroys the resources held by the given token.
+ * @brief Destroys the resources held by the given token. Tokens currently hold none.
  */
 void DestroyToken(Token* token);
-
-/**
- * @private
- */
-MONKEY_INTERNAL TokenType LookupIdent(Monkey* monkey, const char* identifier);
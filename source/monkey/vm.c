@@ -0,0 +1,472 @@
+#include "monkey/vm.h"
+
+#include "buffer.h"
+#include "monkey.h"
+#include "monkey/code.h"
+#include "monkey/compiler.h"
+#include "monkey/heap.h"
+#include "monkey/location.h"
+#include "monkey/macros.h"
+#include "monkey/object.h"
+#include "monkey/string.h"
+#include "span.h"
+
+#include <assert.h>
+#include <hedley.h>
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define STACK_SIZE ((size_t)1 << 16U)
+#define MAX_FRAMES ((size_t)1 << 14U)
+
+typedef struct {
+	/**
+	 * @brief closure is the function being run, or NULL for the top-level program. It is
+	 * borrowed from the stack slot just below basePointer.
+	 */
+	ClosureObject* closure;
+	InstructionSpan instructions;
+	size_t ip;
+	size_t basePointer;
+} Frame;
+
+struct VM {
+	MonkeyInternedObjects interns;
+	Heap* heap;
+	BUFFER_TYPE(Object*) globals;
+	/**
+	 * @brief stack holds the operands and locals of every frame. Local slots that were never
+	 * assigned hold NULL.
+	 */
+	Object** stack;
+	size_t sp;
+	Frame* frames;
+	size_t frameCount;
+	/**
+	 * @brief maxFrames is the call depth limit of the library instance plus the top level, or
+	 * MAX_FRAMES if that is less.
+	 */
+	size_t maxFrames;
+	/**
+	 * @brief lastPopped is the value of the last expression statement, which Run returns.
+	 */
+	Object* lastPopped;
+};
+
+MONKEY_FILE_LOCAL void traceVM(Heap* heap, void* context) {
+	VM* vm = context;
+	for (size_t i = 0; i < vm->globals.length; ++i) {
+		HeapMark(heap, vm->globals.data[i]);
+	}
+	// closures being run are on the stack, just below their frame's locals
+	for (size_t i = 0; i < vm->sp; ++i) {
+		HeapMark(heap, vm->stack[i]);
+	}
+	HeapMark(heap, vm->lastPopped);
+}
+
+VM* CreateVM(Monkey* monkey) {
+	VM* vm = calloc(1, sizeof(VM));
+	vm->interns = MonkeyGetInterns(monkey);
+	vm->heap = MonkeyGetHeap(monkey);
+	vm->stack = malloc(STACK_SIZE * sizeof(Object*));
+	vm->frames = malloc(MAX_FRAMES * sizeof(Frame));
+	size_t maxDepth = MonkeyGetMaxCallDepth(monkey);
+	vm->maxFrames = maxDepth < MAX_FRAMES ? maxDepth + 1 : MAX_FRAMES;
+	HeapAddTracer(vm->heap, traceVM, vm);
+	return vm;
+}
+
+MONKEY_FILE_LOCAL Object* HEDLEY_PRINTF_FORMAT(2, 3) newError(VM* vm, const char* format, ...) {
+	va_list args;
+	va_start(args, format);
+	char* message = MonkeyAvsprintf(format, args);
+	va_end(args);
+
+	// bytecode does not map instructions back to the source
+	return (Object*)CreateErrorObject(vm->heap, message, NO_SOURCE_OFFSET);
+}
+
+MONKEY_FILE_LOCAL bool isError(Object* value) {
+	return ObjectTypeOf(value) == OBJECT_TYPE_ERROR;
+}
+
+/**
+ * @private
+ *
+ * Abandons the running program after a runtime error, dropping everything on the stack.
+ */
+MONKEY_FILE_LOCAL Object* unwind(VM* vm, Object* error) {
+	vm->sp = 0;
+	vm->frameCount = 0;
+	vm->lastPopped = NULL;
+	return error;
+}
+
+MONKEY_FILE_LOCAL bool isTruthy(VM* vm, Object* value) {
+	return !(value == vm->interns.falseObj || value == vm->interns.nullObj);
+}
+
+MONKEY_FILE_LOCAL Object* nativeBoolToBooleanObject(VM* vm, bool value) {
+	return value ? vm->interns.trueObj : vm->interns.falseObj;
+}
+
+MONKEY_FILE_LOCAL const char* operatorText(Opcode op) {
+	switch (op) {
+		case OPCODE_ADD:
+			return "+";
+		case OPCODE_SUB:
+			return "-";
+		case OPCODE_MUL:
+			return "*";
+		case OPCODE_DIV:
+			return "/";
+		case OPCODE_EQUAL:
+			return "==";
+		case OPCODE_NOT_EQUAL:
+			return "!=";
+		case OPCODE_LESS_THAN:
+			return "<";
+		case OPCODE_GREATER_THAN:
+			return ">";
+		default:
+			break;
+	}
+	(void)fprintf(stderr, "Not an infix operator: %s\n", LookupOpcode(op)->name);
+	assert(false);
+	return NULL;
+}
+
+/**
+ * @private
+ *
+ * Does integer arithmetic, failing with the errors the evaluator gives for the same operands.
+ */
+MONKEY_FILE_LOCAL Object* integerArithmetic(VM* vm, Operator op, int64_t left, int64_t right) {
+	int64_t result;
+	if (ApplyIntegerOperator(op, left, right, &result)) {
+		return IntegerToObject(vm->heap, result);
+	}
+	if (op == OPERATOR_SLASH && right == 0) {
+		return newError(vm, "division by zero");
+	}
+	return newError(vm, "integer overflow: %" PRId64 " %s %" PRId64, left, OperatorText(op),
+			right);
+}
+
+MONKEY_FILE_LOCAL Object* integerBinaryOperation(VM* vm, Opcode op, int64_t left, int64_t right) {
+	switch (op) {
+		case OPCODE_ADD:
+			return integerArithmetic(vm, OPERATOR_PLUS, left, right);
+		case OPCODE_SUB:
+			return integerArithmetic(vm, OPERATOR_MINUS, left, right);
+		case OPCODE_MUL:
+			return integerArithmetic(vm, OPERATOR_ASTERISK, left, right);
+		case OPCODE_DIV:
+			return integerArithmetic(vm, OPERATOR_SLASH, left, right);
+		case OPCODE_EQUAL:
+			return nativeBoolToBooleanObject(vm, left == right);
+		case OPCODE_NOT_EQUAL:
+			return nativeBoolToBooleanObject(vm, left != right);
+		case OPCODE_LESS_THAN:
+			return nativeBoolToBooleanObject(vm, left < right);
+		case OPCODE_GREATER_THAN:
+			return nativeBoolToBooleanObject(vm, left > right);
+		default:
+			break;
+	}
+	return newError(vm, "unknown operator: INTEGER %s INTEGER", operatorText(op));
+}
+
+MONKEY_FILE_LOCAL bool areImmediateIntegers(const Object* left, const Object* right) {
+	return ((uintptr_t)left & (uintptr_t)right & OBJECT_TAG_INTEGER) != 0;
+}
+
+/**
+ * @private
+ *
+ * Applies the operators that cannot fail to two immediate integers, without decoding the type of
+ * either. Returns NULL for the others, which binaryOperation checks.
+ */
+MONKEY_FILE_LOCAL Object* immediateIntegerOperation(
+		VM* vm, Opcode op, Object* left, Object* right) {
+	// immediates have a bit to spare, so sums and differences cannot overflow, and the encoding
+	// keeps their order
+	switch (op) {
+		case OPCODE_ADD:
+			return IntegerToObject(vm->heap, ObjectToInteger(left) + ObjectToInteger(right));
+		case OPCODE_SUB:
+			return IntegerToObject(vm->heap, ObjectToInteger(left) - ObjectToInteger(right));
+		case OPCODE_EQUAL:
+			return nativeBoolToBooleanObject(vm, left == right);
+		case OPCODE_NOT_EQUAL:
+			return nativeBoolToBooleanObject(vm, left != right);
+		case OPCODE_LESS_THAN:
+			return nativeBoolToBooleanObject(vm, (intptr_t)left < (intptr_t)right);
+		case OPCODE_GREATER_THAN:
+			return nativeBoolToBooleanObject(vm, (intptr_t)left > (intptr_t)right);
+		default:
+			return NULL;
+	}
+}
+
+MONKEY_FILE_LOCAL Object* binaryOperation(VM* vm, Opcode op, Object* left, Object* right) {
+	ObjectType leftType = ObjectTypeOf(left);
+	ObjectType rightType = ObjectTypeOf(right);
+	if (leftType == OBJECT_TYPE_INTEGER && rightType == OBJECT_TYPE_INTEGER) {
+		return integerBinaryOperation(vm, op, ObjectToInteger(left), ObjectToInteger(right));
+	}
+	if (op == OPCODE_EQUAL) {
+		return nativeBoolToBooleanObject(vm, left == right);
+	}
+	if (op == OPCODE_NOT_EQUAL) {
+		return nativeBoolToBooleanObject(vm, left != right);
+	}
+	if (leftType != rightType) {
+		return newError(vm, "type mismatch: %s %s %s", ObjectTypeText(leftType), operatorText(op),
+				ObjectTypeText(rightType));
+	}
+	return newError(vm, "unknown operator: %s %s %s", ObjectTypeText(leftType), operatorText(op),
+			ObjectTypeText(rightType));
+}
+
+/**
+ * @private
+ *
+ * Pops the current frame, dropping its locals and callee, and pushes the result in their place.
+ */
+MONKEY_FILE_LOCAL void popFrame(VM* vm, Object* result) {
+	Frame* frame = &vm->frames[--vm->frameCount];
+	vm->sp = frame->basePointer - 1;
+	vm->stack[vm->sp++] = result;
+}
+
+Object* Run(VM* vm, Bytecode bytecode) {
+	while (vm->globals.length < bytecode.globalNames.length) {
+		BUFFER_PUSH(&vm->globals, NULL);
+	}
+	vm->lastPopped = NULL;
+	vm->sp = 0;
+	vm->frames[0] = (Frame){NULL, bytecode.instructions, 0, 0};
+	vm->frameCount = 1;
+
+	// The instruction pointer of the current frame lives in a local while it runs, and is only
+	// written back to the frame across calls.
+	Frame* frame = &vm->frames[0];
+	const uint8_t* ins = frame->instructions.begin;
+	size_t ip = 0;
+
+#define PUSH(value) \
+	do { \
+		if (vm->sp >= STACK_SIZE) { \
+			return unwind(vm, newError(vm, "stack overflow")); \
+		} \
+		vm->stack[vm->sp++] = (value); \
+	} while (false)
+
+	while (ip < frame->instructions.length) {
+		Opcode op = (Opcode)ins[ip];
+		switch (op) {
+			case OPCODE_CONSTANT: {
+				uint32_t index = ReadWideOperand(ins + ip + 1);
+				ip += 3;
+				PUSH(bytecode.constants.begin[index]);
+				break;
+			}
+			case OPCODE_POP:
+				vm->lastPopped = vm->stack[--vm->sp];
+				ip += 1;
+				break;
+			case OPCODE_ADD:
+			case OPCODE_SUB:
+			case OPCODE_MUL:
+			case OPCODE_DIV:
+			case OPCODE_EQUAL:
+			case OPCODE_NOT_EQUAL:
+			case OPCODE_LESS_THAN:
+			case OPCODE_GREATER_THAN: {
+				Object* right = vm->stack[vm->sp - 1];
+				Object* left = vm->stack[vm->sp - 2];
+				Object* result = areImmediateIntegers(left, right)
+						? immediateIntegerOperation(vm, op, left, right)
+						: NULL;
+				if (result == NULL) {
+					result = binaryOperation(vm, op, left, right);
+					if (isError(result)) {
+						return unwind(vm, result);
+					}
+				}
+				vm->stack[vm->sp - 2] = result;
+				vm->sp -= 1;
+				ip += 1;
+				break;
+			}
+			case OPCODE_TRUE:
+				PUSH(vm->interns.trueObj);
+				ip += 1;
+				break;
+			case OPCODE_FALSE:
+				PUSH(vm->interns.falseObj);
+				ip += 1;
+				break;
+			case OPCODE_NULL:
+				PUSH(vm->interns.nullObj);
+				ip += 1;
+				break;
+			case OPCODE_MINUS: {
+				Object* right = vm->stack[vm->sp - 1];
+				ObjectType type = ObjectTypeOf(right);
+				if (type != OBJECT_TYPE_INTEGER) {
+					return unwind(vm, newError(vm, "unknown operator: -%s", ObjectTypeText(type)));
+				}
+				int64_t value = ObjectToInteger(right);
+				if (value == INT64_MIN) {
+					return unwind(vm, newError(vm, "integer overflow: -%" PRId64, value));
+				}
+				vm->stack[vm->sp - 1] = IntegerToObject(vm->heap, -value);
+				ip += 1;
+				break;
+			}
+			case OPCODE_BANG: {
+				Object* right = vm->stack[vm->sp - 1];
+				vm->stack[vm->sp - 1] = nativeBoolToBooleanObject(vm, !isTruthy(vm, right));
+				ip += 1;
+				break;
+			}
+			case OPCODE_JUMP_NOT_TRUTHY: {
+				bool truthy = isTruthy(vm, vm->stack[--vm->sp]);
+				ip = truthy ? ip + 3 : ReadWideOperand(ins + ip + 1);
+				break;
+			}
+			case OPCODE_JUMP:
+				ip = ReadWideOperand(ins + ip + 1);
+				break;
+			case OPCODE_GET_GLOBAL: {
+				uint32_t index = ReadWideOperand(ins + ip + 1);
+				ip += 3;
+				Object* value = vm->globals.data[index];
+				if (value == NULL) {
+					return unwind(vm, newError(vm, "identifier not found: %s",
+											  bytecode.globalNames.begin[index]));
+				}
+				PUSH(value);
+				break;
+			}
+			case OPCODE_SET_GLOBAL: {
+				uint32_t index = ReadWideOperand(ins + ip + 1);
+				ip += 3;
+				vm->globals.data[index] = vm->stack[--vm->sp];
+				break;
+			}
+			case OPCODE_GET_LOCAL: {
+				uint32_t index = ins[ip + 1];
+				ip += 2;
+				Object* value = vm->stack[frame->basePointer + index];
+				if (value == NULL) {
+					return unwind(vm, newError(vm, "identifier not found: %s",
+											  frame->closure->function->localNames.begin[index]));
+				}
+				PUSH(value);
+				break;
+			}
+			case OPCODE_SET_LOCAL: {
+				uint32_t index = ins[ip + 1];
+				ip += 2;
+				vm->stack[frame->basePointer + index] = vm->stack[--vm->sp];
+				break;
+			}
+			case OPCODE_GET_FREE: {
+				uint32_t index = ins[ip + 1];
+				ip += 2;
+				PUSH(frame->closure->freeVariables.begin[index]);
+				break;
+			}
+			case OPCODE_CURRENT_CLOSURE:
+				ip += 1;
+				PUSH(&frame->closure->base);
+				break;
+			case OPCODE_CLOSURE: {
+				uint32_t index = ReadWideOperand(ins + ip + 1);
+				size_t count = ins[ip + 3];
+				ip += 4;
+				Object** freeVariables = malloc(count * sizeof(Object*));
+				for (size_t i = 0; i < count; ++i) {
+					freeVariables[i] = vm->stack[vm->sp - count + i];
+				}
+				CompiledFunctionObject* function =
+						(CompiledFunctionObject*)bytecode.constants.begin[index];
+				// the free variables stay on the stack until the closure exists, to keep them
+				// reachable
+				Object* closure = (Object*)CreateClosureObject(
+						vm->heap, function, (ObjectSpan)SPAN_WITH_LENGTH(freeVariables, count));
+				vm->sp -= count;
+				vm->stack[vm->sp++] = closure;
+				break;
+			}
+			case OPCODE_CALL: {
+				size_t argumentCount = ins[ip + 1];
+				ip += 2;
+				Object* callee = vm->stack[vm->sp - 1 - argumentCount];
+				ObjectType type = ObjectTypeOf(callee);
+				if (type != OBJECT_TYPE_CLOSURE) {
+					return unwind(vm, newError(vm, "not a function: %s", ObjectTypeText(type)));
+				}
+				ClosureObject* closure = (ClosureObject*)callee;
+				CompiledFunctionObject* function = closure->function;
+				if (argumentCount != function->numParameters) {
+					return unwind(vm, newError(vm, "wrong number of arguments: want=%zu, got=%zu",
+											  function->numParameters, argumentCount));
+				}
+				size_t basePointer = vm->sp - argumentCount;
+				if (vm->frameCount == vm->maxFrames ||
+						basePointer + function->numLocals >= STACK_SIZE) {
+					return unwind(vm, newError(vm, "stack overflow"));
+				}
+				frame->ip = ip;
+				frame = &vm->frames[vm->frameCount++];
+				*frame = (Frame){closure, function->instructions, 0, basePointer};
+				for (size_t i = vm->sp; i < basePointer + function->numLocals; ++i) {
+					vm->stack[i] = NULL;
+				}
+				vm->sp = basePointer + function->numLocals;
+				ins = frame->instructions.begin;
+				ip = 0;
+				break;
+			}
+			case OPCODE_RETURN_VALUE:
+			case OPCODE_RETURN: {
+				Object* result =
+						op == OPCODE_RETURN_VALUE ? vm->stack[--vm->sp] : vm->interns.nullObj;
+				if (vm->frameCount == 1) {
+					// returning from the top level ends the program
+					return unwind(vm, result);
+				}
+				popFrame(vm, result);
+				frame = &vm->frames[vm->frameCount - 1];
+				ins = frame->instructions.begin;
+				ip = frame->ip;
+				break;
+			}
+		}
+	}
+
+#undef PUSH
+
+	Object* result = vm->lastPopped;
+	vm->lastPopped = NULL;
+	vm->frameCount = 0;
+	return result;
+}
+
+void DestroyVM(VM* vm) {
+	HeapRemoveTracer(vm->heap, traceVM, vm);
+	BUFFER_FREE(vm->globals);
+	free(vm->stack);
+	free(vm->frames);
+	free(vm);
+}
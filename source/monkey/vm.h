@@ -0,0 +1,35 @@
+#pragma once
+
+#include "monkey.h"
+#include "monkey/compiler.h"
+#include "monkey/object.h"
+
+/**
+ * @brief VM is a stack-based virtual machine that runs the output of the Compiler.
+ *
+ * Globals persist across calls to Run, so that a REPL can run one line at a time.
+ */
+typedef struct VM VM;
+
+/**
+ * @brief CreateVM creates a new virtual machine.
+ * @param monkey The library instance.
+ * @return A new virtual machine.
+ */
+VM* CreateVM(Monkey* monkey);
+
+/**
+ * @brief Run executes bytecode until it finishes or fails.
+ * @param vm The virtual machine to use.
+ * @param bytecode The bytecode to run.
+ * @return The value of the last expression statement (or NULL if there was none), or an
+ * ErrorObject if a runtime error occurred. It is only guaranteed to stay valid until the next
+ * allocation on the library instance, e.g. the next call to Run.
+ */
+Object* Run(VM* vm, Bytecode bytecode);
+
+/**
+ * @brief DestroyVM destroys a virtual machine. Its globals are left to the garbage collector.
+ * @param vm The virtual machine to destroy.
+ */
+void DestroyVM(VM* vm);
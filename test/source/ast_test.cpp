@@ -1,11 +1,10 @@
 
 #include <catch2/catch_test_macros.hpp>
-#include <cstdlib>
-#include <cstring>
 #include <string>
 
 extern "C" {
 #include "monkey.h"
+#include "monkey/arena.h"
 #include "monkey/ast.h"
 #include "monkey/string.h"
 #include "monkey/token.h"
@@ -16,19 +15,21 @@ extern "C" {
 
 TEST_CASE("AST can be pretty-printed", "[ast]") {
 	const MonkeyPtr monkey{CreateMonkey()};
+	Arena* arena = CreateArena();
 	Statement* rawStatements[] = {
-			&CreateLetStatement(Token{TOKEN_TYPE_LET, MonkeyStrdup("let")},
-					CreateIdentifier(
-							Token{TOKEN_TYPE_IDENT, MonkeyStrdup("myVar")}, MonkeyStrdup("myVar")),
-					&CreateIdentifier(Token{TOKEN_TYPE_IDENT, MonkeyStrdup("anotherVar")},
-							MonkeyStrdup("anotherVar"))
+			&CreateLetStatement(arena, Token{TOKEN_TYPE_LET, MonkeyStringViewFrom("let"), 0},
+					CreateIdentifier(arena,
+							Token{TOKEN_TYPE_IDENT, MonkeyStringViewFrom("myVar"), 0},
+							MonkeyStringViewFrom("myVar")),
+					&CreateIdentifier(arena,
+							Token{TOKEN_TYPE_IDENT, MonkeyStringViewFrom("anotherVar"), 0},
+							MonkeyStringViewFrom("anotherVar"))
 							 ->base)
 					 ->base,
 	};
-	Statement** statements = static_cast<Statement**>(malloc(sizeof(Statement*)));
-	memcpy(statements, rawStatements, sizeof(rawStatements));
-	// NOLINTNEXTLINE(clang-analyzer-unix.Malloc): false positive
-	const ProgramPtr program{CreateProgram(SPAN_WITH_LENGTH(statements, 1))};
+	auto** statements =
+			static_cast<Statement**>(ArenaCopy(arena, rawStatements, sizeof(rawStatements)));
+	const ProgramPtr program{CreateProgram(arena, SPAN_WITH_LENGTH(statements, 1))};
 
 	const StringPtr actual{ProgramString(program.get())};
 	REQUIRE(actual.get() == std::string{"let myVar = anotherVar;"});
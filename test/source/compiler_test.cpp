@@ -0,0 +1,160 @@
+#include <catch2/catch_message.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+#include <string>
+#include <tuple>
+
+extern "C" {
+#include <monkey.h>
+#include <monkey/code.h>
+#include <monkey/compiler.h>
+#include <monkey/lexer.h>
+#include <monkey/object.h>
+#include <monkey/parser.h>
+}
+
+#include "monkey_wrapper.hpp"
+
+namespace {
+std::string disassemble(InstructionSpan instructions) {
+	const StringPtr text{InstructionsString(instructions)};
+	return text.get();
+}
+
+std::string disassembleFunction(const Object* object) {
+	REQUIRE(ObjectTypeOf(object) == OBJECT_TYPE_COMPILED_FUNCTION);
+	return disassemble(reinterpret_cast<const CompiledFunctionObject*>(object)->instructions);
+}
+} // namespace
+
+TEST_CASE("Instructions are encoded big-endian and disassembled", "[compiler]") {
+	Instructions instructions = BUFFER_INIT;
+	EmitInstruction(&instructions, OPCODE_ADD, 0, 0);
+	EmitInstruction(&instructions, OPCODE_GET_LOCAL, 1, 0);
+	size_t constant = EmitInstruction(&instructions, OPCODE_CONSTANT, 65534, 0);
+	EmitInstruction(&instructions, OPCODE_CLOSURE, 65535, 255);
+
+	REQUIRE(instructions.length == 1 + 2 + 3 + 4);
+	CHECK(instructions.data[constant + 1] == 0xFF);
+	CHECK(instructions.data[constant + 2] == 0xFE);
+	CHECK(disassemble(InstructionSpan BUFFER_AS_SPAN(instructions)) ==
+			"0000 ADD\n0001 GET_LOCAL 1\n0003 CONSTANT 65534\n0006 CLOSURE 65535 255\n");
+	BUFFER_FREE(instructions);
+}
+
+TEST_CASE("Compiled programs", "[compiler]") {
+	const MonkeyPtr monkey{CreateMonkey()};
+	const char* input;
+	const char* expected;
+	std::tie(input, expected) = GENERATE(table<const char*, const char*>({
+			std::make_tuple("1 + 2", "0000 CONSTANT 0\n0003 CONSTANT 1\n0006 ADD\n0007 POP\n"),
+			std::make_tuple("-1; !true", "0000 CONSTANT 0\n0003 MINUS\n0004 POP\n"
+										 "0005 TRUE\n0006 BANG\n0007 POP\n"),
+			std::make_tuple("if (true) { 10 }; 3333;",
+					"0000 TRUE\n0001 JUMP_NOT_TRUTHY 10\n0004 CONSTANT 0\n0007 JUMP 11\n"
+					"0010 NULL\n0011 POP\n0012 CONSTANT 1\n0015 POP\n"),
+			std::make_tuple("let one = 1; one;", "0000 CONSTANT 0\n0003 SET_GLOBAL 0\n0006 NULL\n"
+												 "0007 POP\n0008 GET_GLOBAL 0\n0011 POP\n"),
+	}));
+
+	CAPTURE(input);
+	const LexerPtr lexer{CreateLexer(monkey.get(), input)};
+	const ParserPtr parser{CreateParser(lexer.get())};
+	const ProgramPtr program{ParseProgram(parser.get())};
+	const CompilerPtr compiler{CreateCompiler(monkey.get())};
+
+	REQUIRE(Compile(compiler.get(), program.get()));
+	CHECK(disassemble(CompilerBytecode(compiler.get()).instructions) == expected);
+}
+
+TEST_CASE("Integer constants are shared across programs", "[compiler]") {
+	const MonkeyPtr monkey{CreateMonkey()};
+	const CompilerPtr compiler{CreateCompiler(monkey.get())};
+	// more literals than the pool has room for, but only a few distinct ones
+	std::string input;
+	for (int i = 0; i < 70000; i++) {
+		input += std::to_string(i % 7) + ";";
+	}
+	const char* inputs[] = {"1 + 2; 1", input.c_str(), "2 + 1"};
+	for (const char* source : inputs) {
+		const LexerPtr lexer{CreateLexer(monkey.get(), source)};
+		const ParserPtr parser{CreateParser(lexer.get())};
+		const ProgramPtr program{ParseProgram(parser.get())};
+		REQUIRE(Compile(compiler.get(), program.get()));
+	}
+
+	const Bytecode bytecode = CompilerBytecode(compiler.get());
+	CHECK(bytecode.constants.length == 7);
+	CHECK(disassemble(bytecode.instructions) ==
+			"0000 CONSTANT 1\n0003 CONSTANT 0\n0006 ADD\n0007 POP\n");
+}
+
+TEST_CASE("Closures capture free variables", "[compiler]") {
+	const MonkeyPtr monkey{CreateMonkey()};
+	constexpr char INPUT[] = "fn(a) { fn(b) { a + b } }";
+	const LexerPtr lexer{CreateLexer(monkey.get(), INPUT)};
+	const ParserPtr parser{CreateParser(lexer.get())};
+	const ProgramPtr program{ParseProgram(parser.get())};
+	const CompilerPtr compiler{CreateCompiler(monkey.get())};
+
+	REQUIRE(Compile(compiler.get(), program.get()));
+	const Bytecode bytecode = CompilerBytecode(compiler.get());
+	REQUIRE(bytecode.constants.length == 2);
+	CHECK(disassembleFunction(bytecode.constants.begin[0]) ==
+			"0000 GET_FREE 0\n0002 GET_LOCAL 0\n0004 ADD\n0005 RETURN_VALUE\n");
+	CHECK(disassembleFunction(bytecode.constants.begin[1]) ==
+			"0000 GET_LOCAL 0\n0002 CLOSURE 0 1\n0006 RETURN_VALUE\n");
+	CHECK(disassemble(bytecode.instructions) == "0000 CLOSURE 1 0\n0004 POP\n");
+}
+
+TEST_CASE("Functions refer to themselves through the current closure", "[compiler]") {
+	const MonkeyPtr monkey{CreateMonkey()};
+	constexpr char INPUT[] = "let f = fn(x) { f(x) };";
+	const LexerPtr lexer{CreateLexer(monkey.get(), INPUT)};
+	const ParserPtr parser{CreateParser(lexer.get())};
+	const ProgramPtr program{ParseProgram(parser.get())};
+	const CompilerPtr compiler{CreateCompiler(monkey.get())};
+
+	REQUIRE(Compile(compiler.get(), program.get()));
+	const Bytecode bytecode = CompilerBytecode(compiler.get());
+	REQUIRE(bytecode.constants.length == 1);
+	CHECK(disassembleFunction(bytecode.constants.begin[0]) ==
+			"0000 CURRENT_CLOSURE\n0001 GET_LOCAL 0\n0003 CALL 1\n0005 RETURN_VALUE\n");
+}
+
+TEST_CASE("Compiler recovers from errors in nested functions", "[compiler]") {
+	const MonkeyPtr monkey{CreateMonkey()};
+	const CompilerPtr compiler{CreateCompiler(monkey.get())};
+	const char* inputs[] = {"let f = fn() { fn() { fn() { y } } };", "fn() { y }"};
+	for (const char* input : inputs) {
+		CAPTURE(input);
+		const LexerPtr lexer{CreateLexer(monkey.get(), input)};
+		const ParserPtr parser{CreateParser(lexer.get())};
+		const ProgramPtr program{ParseProgram(parser.get())};
+		REQUIRE_FALSE(Compile(compiler.get(), program.get()));
+		CHECK(CompilerErrors(compiler.get()).data[0] == std::string("identifier not found: y"));
+		CHECK(CompilerBytecode(compiler.get()).instructions.length == 0);
+	}
+
+	// the compiler is still usable afterwards, as in the REPL
+	const LexerPtr lexer{CreateLexer(monkey.get(), "1")};
+	const ParserPtr parser{CreateParser(lexer.get())};
+	const ProgramPtr program{ParseProgram(parser.get())};
+	REQUIRE(Compile(compiler.get(), program.get()));
+	CHECK(disassemble(CompilerBytecode(compiler.get()).instructions) ==
+			"0000 CONSTANT 0\n0003 POP\n");
+}
+
+TEST_CASE("Compiler reports unresolved identifiers", "[compiler]") {
+	const MonkeyPtr monkey{CreateMonkey()};
+	constexpr char INPUT[] = "let a = 1; a + foobar;";
+	const LexerPtr lexer{CreateLexer(monkey.get(), INPUT)};
+	const ParserPtr parser{CreateParser(lexer.get())};
+	const ProgramPtr program{ParseProgram(parser.get())};
+	const CompilerPtr compiler{CreateCompiler(monkey.get())};
+
+	REQUIRE_FALSE(Compile(compiler.get(), program.get()));
+	const MonkeyStringBuffer errors = CompilerErrors(compiler.get());
+	REQUIRE(errors.length == 1);
+	CHECK(errors.data[0] == std::string("identifier not found: foobar"));
+}
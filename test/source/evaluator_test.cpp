@@ -1,6 +1,7 @@
 #include <catch2/catch_message.hpp>
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/generators/catch_generators.hpp>
+#include <cstddef>
 #include <cstdint>
 #include <nonstd/variant.hpp>
 #include <string>
@@ -21,21 +22,19 @@ extern "C" {
 namespace {
 void testIntegerObject(const Object* object, int64_t expected) {
 	REQUIRE(object != nullptr);
-	REQUIRE(object->type == OBJECT_TYPE_INTEGER);
-	const auto* integer = reinterpret_cast<const IntegerObject*>(object);
-	REQUIRE(integer->value == expected);
+	REQUIRE(ObjectTypeOf(object) == OBJECT_TYPE_INTEGER);
+	REQUIRE(ObjectToInteger(object) == expected);
 }
 
 void testBooleanObject(const Object* object, bool expected) {
 	REQUIRE(object != nullptr);
-	REQUIRE(object->type == OBJECT_TYPE_BOOLEAN);
-	const auto* boolean = reinterpret_cast<const BooleanObject*>(object);
-	REQUIRE(boolean->value == expected);
+	REQUIRE(ObjectTypeOf(object) == OBJECT_TYPE_BOOLEAN);
+	REQUIRE(ObjectToBoolean(object) == expected);
 }
 
 void testNullObject(const Object* object) {
 	REQUIRE(object != nullptr);
-	REQUIRE(object->type == OBJECT_TYPE_NULL);
+	REQUIRE(ObjectTypeOf(object) == OBJECT_TYPE_NULL);
 }
 
 void testObject(const Object* object, TestValue expected) {
@@ -50,13 +49,13 @@ void testObject(const Object* object, TestValue expected) {
 	}
 }
 
-ObjectPtr testEval(Monkey* monkey, const char* input) {
-	const EnvironmentPtr env{CreateEnvironment(nullptr)};
+Object* testEval(Monkey* monkey, const char* input) {
+	const EnvironmentPtr env{CreateEnvironment(monkey, nullptr)};
 	const LexerPtr lexer{CreateLexer(monkey, input)};
 	const ParserPtr parser{CreateParser(lexer.get())};
 	const ProgramPtr program{ParseProgram(parser.get())};
 
-	return ObjectPtr{Eval(monkey, env.get(), &program->base)};
+	return Eval(monkey, env.get(), &program->base);
 }
 } // namespace
 
@@ -80,11 +79,15 @@ TEST_CASE("Integer expressions", "[evaluator]") {
 			std::make_tuple("3 * 3 * 3 + 10", 37),
 			std::make_tuple("3 * (3 * 3) + 10", 37),
 			std::make_tuple("(5 + 10 * 2 + 15 / 3) * 2 + -10", 50),
+			std::make_tuple("4611686018427387903 + 1", INT64_C(4611686018427387904)),
+			std::make_tuple("4611686018427387904 - 1", INT64_C(4611686018427387903)),
+			std::make_tuple("-4611686018427387904 - 1", INT64_C(-4611686018427387905)),
+			std::make_tuple("9223372036854775807", INT64_MAX),
 	}));
 
 	CAPTURE(input, expected);
-	const ObjectPtr evaluated = testEval(monkey.get(), input);
-	testIntegerObject(evaluated.get(), expected);
+	Object* evaluated = testEval(monkey.get(), input);
+	testIntegerObject(evaluated, expected);
 }
 
 TEST_CASE("Boolean expressions", "[evaluator]") {
@@ -114,8 +117,8 @@ TEST_CASE("Boolean expressions", "[evaluator]") {
 	}));
 
 	CAPTURE(input, expected);
-	const ObjectPtr evaluated = testEval(monkey.get(), input);
-	testBooleanObject(evaluated.get(), expected);
+	Object* evaluated = testEval(monkey.get(), input);
+	testBooleanObject(evaluated, expected);
 }
 
 TEST_CASE("Prefix expressions", "[evaluator]") {
@@ -132,8 +135,8 @@ TEST_CASE("Prefix expressions", "[evaluator]") {
 	}));
 
 	CAPTURE(input, expected);
-	const ObjectPtr evaluated = testEval(monkey.get(), input);
-	testObject(evaluated.get(), expected);
+	Object* evaluated = testEval(monkey.get(), input);
+	testObject(evaluated, expected);
 }
 
 TEST_CASE("If/else expressions", "[evaluator]") {
@@ -151,8 +154,8 @@ TEST_CASE("If/else expressions", "[evaluator]") {
 	}));
 
 	CAPTURE(input, expected);
-	const ObjectPtr evaluated = testEval(monkey.get(), input);
-	testObject(evaluated.get(), expected);
+	Object* evaluated = testEval(monkey.get(), input);
+	testObject(evaluated, expected);
 }
 
 TEST_CASE("Return statements", "[evaluator]") {
@@ -174,26 +177,36 @@ if (10 > 1) {
 }
 			)mk",
 					TestInt{10}),
+			// a return only stops the function it is in
+			std::make_tuple("let f = fn() { return 1; 2 }; f(); 3", TestInt{3}),
+			std::make_tuple("let f = fn() { if (true) { return 1; } 2 }; f() + f()", TestInt{2}),
+			std::make_tuple("let f = fn(g) { return g() + 1; }; f(fn() { return 10; 0 })",
+					TestInt{11}),
+			std::make_tuple("if (true) { fn() { return 1; }(); 5 }", TestInt{5}),
 	}));
 
 	CAPTURE(input, expected);
-	const ObjectPtr evaluated = testEval(monkey.get(), input);
-	testObject(evaluated.get(), expected);
+	Object* evaluated = testEval(monkey.get(), input);
+	testObject(evaluated, expected);
 }
 
 TEST_CASE("Error handling", "[evaluator]") {
 	const MonkeyPtr monkey{CreateMonkey()};
 	const char* input;
 	const char* expectedMessage;
-	std::tie(input, expectedMessage) = GENERATE(table<const char*, const char*>({
-			std::make_tuple("5 + true;", "type mismatch: INTEGER + BOOLEAN"),
-			std::make_tuple("5 + true; 5;", "type mismatch: INTEGER + BOOLEAN"),
-			std::make_tuple("-true", "unknown operator: -BOOLEAN"),
-			std::make_tuple("true + false;", "unknown operator: BOOLEAN + BOOLEAN"),
-			std::make_tuple("5; true + false; 5", "unknown operator: BOOLEAN + BOOLEAN"),
-			std::make_tuple("if (10 > 1) { true + false; }", "unknown operator: BOOLEAN + BOOLEAN"),
-			std::make_tuple(
-					R"mk(
+	std::size_t expectedOffset;
+	std::tie(input, expectedMessage, expectedOffset) =
+			GENERATE(table<const char*, const char*, std::size_t>({
+					std::make_tuple("5 + true;", "type mismatch: INTEGER + BOOLEAN", 2),
+					std::make_tuple("5 + true; 5;", "type mismatch: INTEGER + BOOLEAN", 2),
+					std::make_tuple("-true", "unknown operator: -BOOLEAN", 0),
+					std::make_tuple("true + false;", "unknown operator: BOOLEAN + BOOLEAN", 5),
+					std::make_tuple(
+							"5; true + false; 5", "unknown operator: BOOLEAN + BOOLEAN", 8),
+					std::make_tuple("if (10 > 1) { true + false; }",
+							"unknown operator: BOOLEAN + BOOLEAN", 19),
+					std::make_tuple(
+							R"mk(
 if (10 > 1) {
 	if (10 > 1) {
 		return true + false;
@@ -201,16 +214,35 @@ if (10 > 1) {
 	return 1;
 }
 )mk",
-					"unknown operator: BOOLEAN + BOOLEAN"),
-			std::make_tuple("foobar", "identifier not found: foobar"),
-	}));
+							"unknown operator: BOOLEAN + BOOLEAN", 44),
+					std::make_tuple("foobar", "identifier not found: foobar", 0),
+					std::make_tuple("let f = fn(x) { x }; f(1, 2)",
+							"wrong number of arguments: want=1, got=2", 22),
+					// arguments are evaluated before the call can fail
+					std::make_tuple("let f = fn(x) { x }; f(1, y)", "identifier not found: y", 26),
+					std::make_tuple("5(-true)", "unknown operator: -BOOLEAN", 2),
+					std::make_tuple("let f = fn(x) { x }; f(f(1, 2))",
+							"wrong number of arguments: want=1, got=2", 24),
+					std::make_tuple("1 / 0", "division by zero", 2),
+					std::make_tuple("let m = -9223372036854775807 - 1; m / -1",
+							"integer overflow: -9223372036854775808 / -1", 36),
+					std::make_tuple("9223372036854775807 + 1",
+							"integer overflow: 9223372036854775807 + 1", 20),
+					std::make_tuple("-9223372036854775807 - 2",
+							"integer overflow: -9223372036854775807 - 2", 21),
+					std::make_tuple("4611686018427387904 * 2",
+							"integer overflow: 4611686018427387904 * 2", 20),
+					std::make_tuple("-(-9223372036854775807 - 1)",
+							"integer overflow: --9223372036854775808", 0),
+			}));
 
 	CAPTURE(input, expectedMessage);
-	const ObjectPtr evaluated = testEval(monkey.get(), input);
-	REQUIRE(evaluated.get() != nullptr);
-	REQUIRE(evaluated->type == OBJECT_TYPE_ERROR);
-	REQUIRE(reinterpret_cast<ErrorObject*>(evaluated.get())->message ==
+	Object* evaluated = testEval(monkey.get(), input);
+	REQUIRE(evaluated != nullptr);
+	REQUIRE(ObjectTypeOf(evaluated) == OBJECT_TYPE_ERROR);
+	REQUIRE(reinterpret_cast<ErrorObject*>(evaluated)->message ==
 			std::string(expectedMessage));
+	REQUIRE(reinterpret_cast<ErrorObject*>(evaluated)->offset == expectedOffset);
 }
 
 TEST_CASE("Let statements", "[evaluator]") {
@@ -225,18 +257,18 @@ TEST_CASE("Let statements", "[evaluator]") {
 	}));
 
 	CAPTURE(input, expected);
-	const ObjectPtr evaluated = testEval(monkey.get(), input);
-	testObject(evaluated.get(), expected);
+	Object* evaluated = testEval(monkey.get(), input);
+	testObject(evaluated, expected);
 }
 
 TEST_CASE("Function object", "[evaluator]") {
 	const MonkeyPtr monkey{CreateMonkey()};
 	constexpr char INPUT[] = "fn(x) { x + 2; };";
 
-	const ObjectPtr evaluated = testEval(monkey.get(), INPUT);
-	REQUIRE(evaluated.get() != nullptr);
-	REQUIRE(evaluated->type == OBJECT_TYPE_FUNCTION);
-	FunctionObject* func = reinterpret_cast<FunctionObject*>(evaluated.get());
+	Object* evaluated = testEval(monkey.get(), INPUT);
+	REQUIRE(evaluated != nullptr);
+	REQUIRE(ObjectTypeOf(evaluated) == OBJECT_TYPE_FUNCTION);
+	FunctionObject* func = reinterpret_cast<FunctionObject*>(evaluated);
 	REQUIRE(func->parameters.length == 1);
 	const StringPtr paramStr{IdentifierString(func->parameters.begin[0])};
 	CHECK(paramStr.get() == std::string("x"));
@@ -255,9 +287,207 @@ TEST_CASE("Function application", "[evaluator]") {
 			std::make_tuple("let add = fn(x, y) { x + y; }; add(5, 5);", TestInt{10}),
 			std::make_tuple("let add = fn(x, y) { x + y; }; add(5 + 5, add(5, 5));", TestInt{20}),
 			std::make_tuple("fn(x) { x; }(5)", TestInt{5}),
+			std::make_tuple("let f = fn(x) { let y = x * 2; let y = y + 1; y }; f(3);", TestInt{7}),
+			// a repeated parameter name refers to the last argument
+			std::make_tuple("let f = fn(x, x) { x }; f(1, 2)", TestInt{2}),
+			std::make_tuple("let f = fn(x, y, x) { let x = x + y; x }; f(1, 2, 3)", TestInt{5}),
+			std::make_tuple("fn(a, a) { fn() { a } }(1, 2)()", TestInt{2}),
+			std::make_tuple(
+					"let adder = fn(a) { fn(b) { a + b } }; let addTwo = adder(2); addTwo(3);",
+					TestInt{5}),
+			std::make_tuple("let adder = fn(a) { fn(b) { a + b } }; "
+							"let addOne = adder(1); let addTwo = adder(2); addOne(1) + addTwo(2);",
+					TestInt{6}),
+			std::make_tuple(R"mk(
+let fib = fn(x) {
+	if (x < 2) { return x; }
+	fib(x - 1) + fib(x - 2)
+};
+fib(15);
+			)mk",
+					TestInt{610}),
+	}));
+
+	CAPTURE(input, expected);
+	Object* evaluated = testEval(monkey.get(), input);
+	testObject(evaluated, expected);
+}
+
+TEST_CASE("Tail calls run in constant stack", "[evaluator]") {
+	// deep enough to overflow the C stack if every call nested another evaluation
+	const MonkeyPtr monkey{CreateMonkey()};
+	const char* input;
+	TestValue expected;
+	std::tie(input, expected) = GENERATE(table<const char*, TestValue>({
+			std::make_tuple("let loop = fn(n) { if (n == 0) { 0 } else { loop(n - 1) } }; "
+							"loop(200000);",
+					TestInt{0}),
+			std::make_tuple("let sum = fn(n, total) { if (n == 0) { return total; } "
+							"return sum(n - 1, total + n); }; sum(200000, 0);",
+					TestInt{20000100000}),
+			std::make_tuple("let even = fn(n) { if (n == 0) { true } else { odd(n - 1) } }; "
+							"let odd = fn(n) { if (n == 0) { false } else { even(n - 1) } }; "
+							"even(200001);",
+					TestBool{false}),
+			std::make_tuple("let count = fn(n) { if (n > 0) { return count(n - 1); } n }; "
+							"count(200000);",
+					TestInt{0}),
+			std::make_tuple("let f = fn(n) { if (n == 0) { return 1; } g(n) }; "
+							"let g = fn(n) { f(n - 1) + 1 }; f(10);",
+					TestInt{11}),
 	}));
 
 	CAPTURE(input, expected);
-	const ObjectPtr evaluated = testEval(monkey.get(), input);
-	testObject(evaluated.get(), expected);
+	Object* evaluated = testEval(monkey.get(), input);
+	testObject(evaluated, expected);
+}
+
+TEST_CASE("Tail calls report errors at the call", "[evaluator]") {
+	const MonkeyPtr monkey{CreateMonkey()};
+	const char* input;
+	const char* message;
+	size_t offset;
+	std::tie(input, message, offset) = GENERATE(table<const char*, const char*, size_t>({
+			std::make_tuple("let f = fn(x) { x(1) }; f(5)", "not a function: INTEGER", 17),
+			std::make_tuple("let f = fn(x) { return f(); }; f(5)",
+					"wrong number of arguments: want=1, got=0", 24),
+	}));
+
+	CAPTURE(input);
+	Object* evaluated = testEval(monkey.get(), input);
+	REQUIRE(evaluated != nullptr);
+	REQUIRE(ObjectTypeOf(evaluated) == OBJECT_TYPE_ERROR);
+	const auto* error = reinterpret_cast<const ErrorObject*>(evaluated);
+	CHECK(std::string(error->message) == message);
+	CHECK(error->offset == offset);
+}
+
+TEST_CASE("Runaway recursion fails with a stack overflow", "[evaluator]") {
+	const MonkeyPtr monkey{CreateMonkey()};
+	const char* countdown =
+			"let f = fn(n) { if (n == 0) { 0 } else { 1 + f(n - 1) } }; "
+			"let loop = fn(n) { if (n == 0) { 0 } else { loop(n - 1) } }; ";
+
+	SECTION("with the default limits") {
+		Object* evaluated = testEval(monkey.get(), "let f = fn(n) { 1 + f(n + 1) }; f(0)");
+		REQUIRE(evaluated != nullptr);
+		REQUIRE(ObjectTypeOf(evaluated) == OBJECT_TYPE_ERROR);
+		const auto* error = reinterpret_cast<const ErrorObject*>(evaluated);
+		CHECK(std::string(error->message) == "stack overflow");
+		CHECK(error->offset == 21);
+	}
+
+	SECTION("past the call depth limit") {
+		MonkeySetMaxCallDepth(monkey.get(), 100);
+		testIntegerObject(testEval(monkey.get(), (std::string(countdown) + "f(99)").c_str()), 99);
+		Object* evaluated = testEval(monkey.get(), (std::string(countdown) + "f(100)").c_str());
+		REQUIRE(evaluated != nullptr);
+		REQUIRE(ObjectTypeOf(evaluated) == OBJECT_TYPE_ERROR);
+		CHECK(std::string(reinterpret_cast<const ErrorObject*>(evaluated)->message) ==
+				"stack overflow");
+		// tail calls replace their caller, so they do not count
+		testIntegerObject(
+				testEval(monkey.get(), (std::string(countdown) + "loop(1000)").c_str()), 0);
+	}
+
+	SECTION("past the stack limit") {
+		MonkeySetStackLimit(monkey.get(), static_cast<size_t>(64) << 10U);
+		testIntegerObject(testEval(monkey.get(), (std::string(countdown) + "f(5)").c_str()), 5);
+		Object* evaluated = testEval(monkey.get(), (std::string(countdown) + "f(5000)").c_str());
+		REQUIRE(evaluated != nullptr);
+		REQUIRE(ObjectTypeOf(evaluated) == OBJECT_TYPE_ERROR);
+		CHECK(std::string(reinterpret_cast<const ErrorObject*>(evaluated)->message) ==
+				"stack overflow");
+	}
+}
+
+TEST_CASE("Calls see functions that are bound again", "[evaluator]") {
+	const MonkeyPtr monkey{CreateMonkey()};
+
+	SECTION("in the same program") {
+		testIntegerObject(testEval(monkey.get(),
+								  "let g = fn(x) { x + 1 }; let h = fn(x) { g(x) }; let a = h(1); "
+								  "let g = fn(x) { x * 10 }; let b = h(2); a + b"),
+				22);
+		testIntegerObject(testEval(monkey.get(),
+								  "let g = fn(x) { x + 1 }; "
+								  "let h = fn(n) { if (n == 0) { 0 } else { g(n) + h(n - 1) } }; "
+								  "let a = h(3); let g = fn(x) { 0 }; a + h(3)"),
+				9);
+		Object* evaluated = testEval(monkey.get(),
+				"let g = fn(x) { x }; let h = fn() { g(1) }; h(); let g = fn(x, y) { x }; h()");
+		REQUIRE(evaluated != nullptr);
+		REQUIRE(ObjectTypeOf(evaluated) == OBJECT_TYPE_ERROR);
+		CHECK(std::string(reinterpret_cast<const ErrorObject*>(evaluated)->message) ==
+				"wrong number of arguments: want=2, got=1");
+	}
+
+	SECTION("in another environment") {
+		const LexerPtr lexer{CreateLexer(monkey.get(), "g(1)")};
+		const ParserPtr parser{CreateParser(lexer.get())};
+		const ProgramPtr program{ParseProgram(parser.get())};
+		const char* definitions[] = {"let g = fn(x) { x + 1 }", "let g = fn(x) { x * 10 }"};
+		const int64_t expected[] = {2, 10};
+		for (size_t i = 0; i < 2; ++i) {
+			// the first environment is gone by the time the second is made, and may leave it its
+			// address
+			const EnvironmentPtr env{CreateEnvironment(monkey.get(), nullptr)};
+			const LexerPtr defLexer{CreateLexer(monkey.get(), definitions[i])};
+			const ParserPtr defParser{CreateParser(defLexer.get())};
+			const ProgramPtr defProgram{ParseProgram(defParser.get())};
+			Eval(monkey.get(), env.get(), &defProgram->base);
+			testIntegerObject(Eval(monkey.get(), env.get(), &program->base), expected[i]);
+		}
+	}
+}
+
+TEST_CASE("Closures share the environment they were created in", "[evaluator]") {
+	const MonkeyPtr monkey{CreateMonkey()};
+
+	SECTION("closures see later updates to what they captured") {
+		const char* input;
+		int64_t expected;
+		std::tie(input, expected) = GENERATE(table<const char*, int64_t>({
+				std::make_tuple("let x = 1; let f = fn() { x }; let x = 2; f()", 2),
+				std::make_tuple(
+						"let g = fn() { let x = 1; let f = fn() { x }; let x = 2; f() }; g()", 2),
+				std::make_tuple("let make = fn() { let x = 1; let f = fn() { x }; let x = 5; f }; "
+								"make()()",
+						5),
+				std::make_tuple("let make = fn(a) { let get = fn() { a }; let a = a * 10; get }; "
+								"let get = make(4); get() + get()",
+						80),
+		}));
+		CAPTURE(input);
+		testIntegerObject(testEval(monkey.get(), input), expected);
+	}
+
+	SECTION("reading a function does not copy its environment") {
+		const EnvironmentPtr env{CreateEnvironment(monkey.get(), nullptr)};
+		const char* inputs[] = {"let make = fn(a) { fn() { a } }; let f = make(1); f", "f", "f"};
+		Object* first = nullptr;
+		for (const char* input : inputs) {
+			CAPTURE(input);
+			const LexerPtr lexer{CreateLexer(monkey.get(), input)};
+			const ParserPtr parser{CreateParser(lexer.get())};
+			const ProgramPtr program{ParseProgram(parser.get())};
+			Object* evaluated = Eval(monkey.get(), env.get(), &program->base);
+			REQUIRE(evaluated != nullptr);
+			REQUIRE(ObjectTypeOf(evaluated) == OBJECT_TYPE_FUNCTION);
+			if (first == nullptr) {
+				first = evaluated;
+			}
+			CHECK(evaluated == first);
+			CHECK(reinterpret_cast<FunctionObject*>(evaluated)->env ==
+					reinterpret_cast<FunctionObject*>(first)->env);
+		}
+
+		const LexerPtr lexer{CreateLexer(monkey.get(), "let g = fn() { 1 }; g")};
+		const ParserPtr parser{CreateParser(lexer.get())};
+		const ProgramPtr program{ParseProgram(parser.get())};
+		Object* evaluated = Eval(monkey.get(), env.get(), &program->base);
+		REQUIRE(evaluated != nullptr);
+		REQUIRE(ObjectTypeOf(evaluated) == OBJECT_TYPE_FUNCTION);
+		CHECK(reinterpret_cast<FunctionObject*>(evaluated)->env == env.get());
+	}
 }
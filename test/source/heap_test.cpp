@@ -0,0 +1,128 @@
+#include <catch2/catch_message.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+#include <cstdint>
+#include <tuple>
+
+extern "C" {
+#include <monkey.h>
+#include <monkey/compiler.h>
+#include <monkey/environment.h>
+#include <monkey/evaluator.h>
+#include <monkey/heap.h>
+#include <monkey/lexer.h>
+#include <monkey/object.h>
+#include <monkey/parser.h>
+#include <monkey/pool.h>
+#include <monkey/vm.h>
+}
+
+#include "monkey_wrapper.hpp"
+
+namespace {
+Object* testEval(Monkey* monkey, Environment* env, const char* input) {
+	const LexerPtr lexer{CreateLexer(monkey, input)};
+	const ParserPtr parser{CreateParser(lexer.get())};
+	const ProgramPtr program{ParseProgram(parser.get())};
+
+	return Eval(monkey, env, &program->base);
+}
+
+void testIntegerObject(const Object* object, int64_t expected) {
+	REQUIRE(object != nullptr);
+	REQUIRE(ObjectTypeOf(object) == OBJECT_TYPE_INTEGER);
+	REQUIRE(ObjectToInteger(object) == expected);
+}
+} // namespace
+
+TEST_CASE("Unreachable objects are collected", "[heap]") {
+	const MonkeyPtr monkey{CreateMonkey()};
+	Heap* heap = MonkeyGetHeap(monkey.get());
+	Environment* env = CreateEnvironment(monkey.get(), nullptr);
+	constexpr char INPUT[] = R"mk(
+let wrapper = fn() {
+	let countDown = fn(x) { if (x == 0) { return 0; } countDown(x - 1) };
+	countDown(10)
+};
+wrapper();
+	)mk";
+
+	testIntegerObject(testEval(monkey.get(), env, INPUT), 0);
+	CollectGarbage(heap);
+	// countDown refers to itself through its environment, but nothing refers to the cycle
+	CHECK(HeapObjectCount(heap) == 2);
+
+	DestroyEnvironment(env);
+	CollectGarbage(heap);
+	CHECK(HeapObjectCount(heap) == 0);
+}
+
+TEST_CASE("The heap remembers how many objects it held at once", "[heap]") {
+	const MonkeyPtr monkey{CreateMonkey()};
+	// nothing is collected until asked to
+	MonkeySetCollectionThreshold(monkey.get(), static_cast<size_t>(1) << 30U);
+	Heap* heap = MonkeyGetHeap(monkey.get());
+	const EnvironmentPtr env{CreateEnvironment(monkey.get(), nullptr)};
+	const size_t before = HeapObjectCount(heap);
+
+	testIntegerObject(testEval(monkey.get(), env.get(),
+							  "let f = fn(x) { fn() { x } }; f(1); f(2); f(3)();"),
+			3);
+	const size_t peak = HeapPeakObjectCount(heap);
+	CHECK(peak >= before + 5);
+	CollectGarbage(heap);
+	CHECK(HeapObjectCount(heap) < peak);
+	CHECK(HeapPeakObjectCount(heap) == peak);
+}
+
+TEST_CASE("Pools recycle blocks of the same size class", "[heap]") {
+	Pool* pool = CreatePool();
+	void* small = PoolAllocate(pool, 24);
+	void* other = PoolAllocate(pool, 100);
+	CHECK(small != other);
+
+	PoolFree(pool, small, 24);
+	CHECK(PoolAllocate(pool, 20) == small);
+	PoolFree(pool, other, 100);
+	CHECK(PoolAllocate(pool, 24) != other);
+	CHECK(PoolAllocate(pool, 100) == other);
+
+	void* large = PoolAllocate(pool, POOL_MAX_SIZE + 1);
+	REQUIRE(large != nullptr);
+	PoolFree(pool, large, POOL_MAX_SIZE + 1);
+	DestroyPool(pool);
+}
+
+TEST_CASE("Values in use survive a collection on every allocation", "[heap]") {
+	const MonkeyPtr monkey{CreateMonkey()};
+	MonkeySetCollectionThreshold(monkey.get(), 0);
+	const char* input;
+	int64_t expected;
+	std::tie(input, expected) = GENERATE(table<const char*, int64_t>({
+			std::make_tuple("let adder = fn(a) { fn(b) { a + b } }; "
+							"let addBig = adder(4611686018427387903); addBig(1) - addBig(0);",
+					1),
+			std::make_tuple("let compose = fn(f, g) { fn(x) { g(f(x)) } }; "
+							"let inc = fn(x) { x + 1 }; let twice = compose(inc, inc); "
+							"twice(twice(1));",
+					5),
+			std::make_tuple("let fib = fn(x) { if (x < 2) { return x; } fib(x - 1) + fib(x - 2) }; "
+							"fib(10);",
+					55),
+	}));
+
+	CAPTURE(input);
+	SECTION("evaluator") {
+		const EnvironmentPtr env{CreateEnvironment(monkey.get(), nullptr)};
+		testIntegerObject(testEval(monkey.get(), env.get(), input), expected);
+	}
+	SECTION("vm") {
+		const LexerPtr lexer{CreateLexer(monkey.get(), input)};
+		const ParserPtr parser{CreateParser(lexer.get())};
+		const ProgramPtr program{ParseProgram(parser.get())};
+		const CompilerPtr compiler{CreateCompiler(monkey.get())};
+		REQUIRE(Compile(compiler.get(), program.get()));
+		const VMPtr vm{CreateVM(monkey.get())};
+		testIntegerObject(Run(vm.get(), CompilerBytecode(compiler.get())), expected);
+	}
+}
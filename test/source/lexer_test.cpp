@@ -1,9 +1,14 @@
+#include <catch2/catch_message.hpp>
 #include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+#include <cstddef>
 #include <string>
 
 extern "C" {
 #include <monkey.h>
 #include <monkey/lexer.h>
+#include <monkey/stream.h>
+#include <monkey/symbol.h>
 #include <monkey/token.h>
 }
 
@@ -134,6 +139,157 @@ TEST_CASE("Lexer lexes tokens", "[lexer]") {
 		const TokenPtr tokPtr{&tok};
 		REQUIRE(std::string(TokenTypeText(tt.expectedType)) ==
 				std::string(TokenTypeText(tok.type)));
-		REQUIRE(std::string(tt.expectedLiteral) == tok.literal);
+		REQUIRE(std::string(tt.expectedLiteral) == viewString(tok.literal));
+	}
+}
+
+TEST_CASE("Lexer tokens are views into the input", "[lexer]") {
+	constexpr const char INPUT[] = "let ab = 12 == 3;";
+	const MonkeyPtr monkey{CreateMonkey()};
+	const LexerPtr lexer{CreateLexer(monkey.get(), INPUT)};
+
+	struct Test {
+		const char* expectedLiteral;
+		size_t expectedOffset;
+	};
+
+	constexpr Test TESTS[] = {
+			{"let", 0},
+			{"ab", 4},
+			{"=", 7},
+			{"12", 9},
+			{"==", 12},
+			{"3", 15},
+			{";", 16},
+			{"", 17},
+	};
+
+	for (const auto tt : TESTS) {
+		auto tok = LexerNextToken(lexer.get());
+		const TokenPtr tokPtr{&tok};
+		REQUIRE(viewString(tok.literal) == std::string(tt.expectedLiteral));
+		REQUIRE(tok.offset == tt.expectedOffset);
+		REQUIRE(tok.literal.begin == INPUT + tt.expectedOffset);
+	}
+}
+
+TEST_CASE("Lexer lexes long runs of whitespace, letters and digits", "[lexer]") {
+	constexpr const char INPUT[] = "  \t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\n"
+								   "a_very_long_identifier_that_goes_on_and_on 1234567890123456789"
+								   "\n\n\n\n\n\n\n\n\n\nanother_long_identifier_at_the_end";
+	const MonkeyPtr monkey{CreateMonkey()};
+	const LexerPtr lexer{CreateLexer(monkey.get(), INPUT)};
+
+	struct Test {
+		TokenType expectedType;
+		const char* expectedLiteral;
+		size_t expectedOffset;
+	};
+
+	constexpr Test TESTS[] = {
+			{TOKEN_TYPE_IDENT, "a_very_long_identifier_that_goes_on_and_on", 20},
+			{TOKEN_TYPE_INT, "1234567890123456789", 63},
+			{TOKEN_TYPE_IDENT, "another_long_identifier_at_the_end", 92},
+			{TOKEN_TYPE_END_OF_FILE, "", 126},
+	};
+
+	for (const auto tt : TESTS) {
+		auto tok = LexerNextToken(lexer.get());
+		const TokenPtr tokPtr{&tok};
+		REQUIRE(tok.type == tt.expectedType);
+		REQUIRE(viewString(tok.literal) == std::string(tt.expectedLiteral));
+		REQUIRE(tok.offset == tt.expectedOffset);
+	}
+}
+
+TEST_CASE("Lexer interns identifiers", "[lexer]") {
+	const MonkeyPtr monkey{CreateMonkey()};
+	const size_t keywordCount = MonkeySymbolCount(monkey.get());
+	const LexerPtr first{CreateLexer(monkey.get(), "let value = other + value")};
+	const LexerPtr second{CreateLexer(monkey.get(), "value")};
+
+	const Token let = LexerNextToken(first.get());
+	const Token value = LexerNextToken(first.get());
+	(void)LexerNextToken(first.get());
+	const Token other = LexerNextToken(first.get());
+	(void)LexerNextToken(first.get());
+	const Token valueAgain = LexerNextToken(first.get());
+	const Token valueElsewhere = LexerNextToken(second.get());
+
+	REQUIRE(let.symbol == MonkeyIntern(monkey.get(), MonkeyStringViewFrom("let")));
+	REQUIRE(let.symbol->tokenType == TOKEN_TYPE_LET);
+	REQUIRE(value.symbol != nullptr);
+	REQUIRE(value.symbol != other.symbol);
+	REQUIRE(valueAgain.symbol == value.symbol);
+	REQUIRE(valueElsewhere.symbol == value.symbol);
+	REQUIRE(viewString(value.symbol->name) == "value");
+	REQUIRE(MonkeySymbolCount(monkey.get()) == keywordCount + 2);
+}
+
+TEST_CASE("Stream lexer agrees with the lexer over the whole text", "[lexer]") {
+	std::string input = R"mk(
+let accumulated_interest = fn(principal) { principal * 1234567890 / 100 };
+		!-/*5; 10 == 10; 10 != 9; @
+	let result = accumulated_interest(42);)mk";
+	const std::size_t chunkSize = GENERATE(1, 2, 3, 5, 16, LEXER_CHUNK_SIZE);
+	CAPTURE(chunkSize);
+
+	const MonkeyPtr monkey{CreateMonkey()};
+	const LexerPtr whole{CreateLexer(monkey.get(), input.c_str())};
+	const StreamPtr stream{StreamFromText(&input[0], input.size())};
+	const LexerPtr streaming{CreateStreamLexer(monkey.get(), stream.get(), chunkSize)};
+
+	while (true) {
+		const Token expected = LexerNextToken(whole.get());
+		const Token actual = LexerNextToken(streaming.get());
+		CAPTURE(viewString(expected.literal));
+		REQUIRE(actual.type == expected.type);
+		REQUIRE(viewString(actual.literal) == viewString(expected.literal));
+		REQUIRE(actual.offset == expected.offset);
+		REQUIRE(actual.symbol == expected.symbol);
+		if (expected.type == TOKEN_TYPE_END_OF_FILE) {
+			break;
+		}
+	}
+}
+
+TEST_CASE("Lexer locates token offsets", "[lexer]") {
+	std::string input = "let x = 5;\n\nlet longer_name =\n\t10;";
+	const MonkeyPtr monkey{CreateMonkey()};
+	const StreamPtr stream{StreamFromText(&input[0], input.size())};
+	const LexerPtr whole{CreateLexer(monkey.get(), input.c_str())};
+	const LexerPtr streaming{CreateStreamLexer(monkey.get(), stream.get(), 3)};
+
+	struct Test {
+		const char* expectedLiteral;
+		std::size_t expectedLine;
+		std::size_t expectedColumn;
+	};
+
+	constexpr Test TESTS[] = {
+			{"let", 1, 1},
+			{"x", 1, 5},
+			{"=", 1, 7},
+			{"5", 1, 9},
+			{";", 1, 10},
+			{"let", 3, 1},
+			{"longer_name", 3, 5},
+			{"=", 3, 17},
+			{"10", 4, 2},
+			{";", 4, 4},
+			{"", 4, 5},
+	};
+
+	for (const auto tt : TESTS) {
+		CAPTURE(tt.expectedLiteral);
+		const Token expected = LexerNextToken(whole.get());
+		const Token actual = LexerNextToken(streaming.get());
+		REQUIRE(viewString(expected.literal) == std::string(tt.expectedLiteral));
+		for (Lexer* lexer : {whole.get(), streaming.get()}) {
+			const SourceLocation location = LexerLocate(lexer, expected.offset);
+			CHECK(location.line == tt.expectedLine);
+			CHECK(location.column == tt.expectedColumn);
+		}
+		REQUIRE(actual.offset == expected.offset);
 	}
 }
@@ -9,12 +9,14 @@
 
 extern "C" {
 #include <monkey/ast.h>
+#include <monkey/compiler.h>
 #include <monkey/environment.h>
 #include <monkey/lexer.h>
 #include <monkey/object.h>
 #include <monkey/parser.h>
 #include <monkey/stream.h>
 #include <monkey/string.h>
+#include <monkey/vm.h>
 }
 
 struct StringDeleter {
@@ -24,6 +26,10 @@ struct StringDeleter {
 };
 using StringPtr = std::unique_ptr<char, StringDeleter>;
 
+inline std::string viewString(MonkeyStringView view) {
+	return std::string(view.begin, view.length);
+}
+
 struct MonkeyDeleter {
 	void operator()(Monkey* ptr) {
 		DestroyMonkey(ptr);
@@ -66,13 +72,6 @@ struct StreamDeleter {
 };
 using StreamPtr = std::unique_ptr<Stream, StreamDeleter>;
 
-struct ObjectDeleter {
-	void operator()(Object* ptr) {
-		DestroyObject(ptr);
-	}
-};
-using ObjectPtr = std::unique_ptr<Object, ObjectDeleter>;
-
 struct EnvironmentDeleter {
 	void operator()(Environment* ptr) {
 		DestroyEnvironment(ptr);
@@ -80,6 +79,20 @@ struct EnvironmentDeleter {
 };
 using EnvironmentPtr = std::unique_ptr<Environment, EnvironmentDeleter>;
 
+struct CompilerDeleter {
+	void operator()(Compiler* ptr) {
+		DestroyCompiler(ptr);
+	}
+};
+using CompilerPtr = std::unique_ptr<Compiler, CompilerDeleter>;
+
+struct VMDeleter {
+	void operator()(VM* ptr) {
+		DestroyVM(ptr);
+	}
+};
+using VMPtr = std::unique_ptr<VM, VMDeleter>;
+
 namespace Catch {
 template <> struct StringMaker<MonkeyStringBuffer> {
 	// NOLINTNEXTLINE(readability-identifier-naming): catch2 defined this name
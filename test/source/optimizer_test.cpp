@@ -0,0 +1,146 @@
+#include <catch2/catch_message.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+#include <string>
+#include <tuple>
+
+extern "C" {
+#include <monkey.h>
+#include <monkey/ast.h>
+#include <monkey/compiler.h>
+#include <monkey/environment.h>
+#include <monkey/evaluator.h>
+#include <monkey/lexer.h>
+#include <monkey/object.h>
+#include <monkey/optimizer.h>
+#include <monkey/parser.h>
+#include <monkey/vm.h>
+}
+
+#include "monkey_wrapper.hpp"
+
+namespace {
+std::string optimizedString(const char* input) {
+	const MonkeyPtr monkey{CreateMonkey()};
+	const LexerPtr lexer{CreateLexer(monkey.get(), input)};
+	const ParserPtr parser{CreateParser(lexer.get())};
+	const ProgramPtr program{ParseProgram(parser.get())};
+	REQUIRE(ParserErrors(parser.get()).length == 0);
+
+	OptimizeProgram(program.get());
+	const StringPtr text{ProgramString(program.get())};
+	return text.get();
+}
+
+std::string inspect(const Object* object) {
+	if (object == nullptr) {
+		return "<none>";
+	}
+	if (ObjectTypeOf(object) == OBJECT_TYPE_ERROR) {
+		const auto* error = reinterpret_cast<const ErrorObject*>(object);
+		return std::string("error: ") + error->message;
+	}
+	const StringPtr text{InspectObject(object)};
+	return text.get();
+}
+
+std::string run(const char* input, bool optimize, bool vm) {
+	const MonkeyPtr monkey{CreateMonkey()};
+	const LexerPtr lexer{CreateLexer(monkey.get(), input)};
+	const ParserPtr parser{CreateParser(lexer.get())};
+	const ProgramPtr program{ParseProgram(parser.get())};
+	REQUIRE(ParserErrors(parser.get()).length == 0);
+	if (optimize) {
+		OptimizeProgram(program.get());
+	}
+
+	if (vm) {
+		const CompilerPtr compiler{CreateCompiler(monkey.get())};
+		if (!Compile(compiler.get(), program.get())) {
+			return std::string("compile error: ") + CompilerErrors(compiler.get()).data[0];
+		}
+		const VMPtr machine{CreateVM(monkey.get())};
+		return inspect(Run(machine.get(), CompilerBytecode(compiler.get())));
+	}
+	const EnvironmentPtr env{CreateEnvironment(monkey.get(), nullptr)};
+	return inspect(Eval(monkey.get(), env.get(), &program->base));
+}
+} // namespace
+
+TEST_CASE("Constant expressions are folded", "[optimizer]") {
+	const char* input;
+	const char* expected;
+	std::tie(input, expected) = GENERATE(table<const char*, const char*>({
+			std::make_tuple("2 * 60 * 60 * 1000", "7200000"),
+			std::make_tuple("-5 + 10 / 3", "-2"),
+			std::make_tuple("!true", "false"),
+			std::make_tuple("!!5", "true"),
+			std::make_tuple("1 < 2 == true", "true"),
+			std::make_tuple("true != false", "true"),
+			std::make_tuple("fn(x) { 1 + 2 + x }", "fn(x)(3 + x)"),
+			std::make_tuple("let f = fn(x) { x + (2 * 3) }; f(10 - 4)",
+					"let f = fn(x)(x + 6);f(6)"),
+	}));
+	CAPTURE(input);
+	CHECK(optimizedString(input) == expected);
+}
+
+TEST_CASE("Expressions that fail at run time are not folded", "[optimizer]") {
+	const char* input;
+	const char* expected;
+	std::tie(input, expected) = GENERATE(table<const char*, const char*>({
+			std::make_tuple("1 / 0", "(1 / 0)"),
+			std::make_tuple("9223372036854775807 + 1", "(9223372036854775807 + 1)"),
+			std::make_tuple("-(-9223372036854775807 - 1)", "(--9223372036854775808)"),
+			// regrouping these around x would change which step overflows
+			std::make_tuple("fn(x) { x * 60 * 60 }", "fn(x)((x * 60) * 60)"),
+			std::make_tuple("fn(x) { x + 1 + 2 - 3 }", "fn(x)(((x + 1) + 2) - 3)"),
+			std::make_tuple("fn(x) { x + 1 + -1 }", "fn(x)((x + 1) + -1)"),
+			std::make_tuple("fn(x) { x * 2 * 0 }", "fn(x)((x * 2) * 0)"),
+			std::make_tuple("true + false", "(true + false)"),
+			std::make_tuple("-true", "(-true)"),
+			std::make_tuple("1 == true", "(1 == true)"),
+	}));
+	CAPTURE(input);
+	CHECK(optimizedString(input) == expected);
+}
+
+TEST_CASE("If-expressions with constant conditions are pruned", "[optimizer]") {
+	const char* input;
+	const char* expected;
+	std::tie(input, expected) = GENERATE(table<const char*, const char*>({
+			std::make_tuple("if (1 < 2) { 10 } else { 20 }", "10"),
+			std::make_tuple("if (1 > 2) { 10 } else { 20 }", "20"),
+			std::make_tuple("if (1) { 10 }", "10"),
+			std::make_tuple("if (false) { 10 }", "iffalse "),
+			std::make_tuple("if (false) { 10 } else { 20; 30 }", "iftrue 2030"),
+			std::make_tuple("if (x) { 1 + 1 } else { 2 * 2 }", "ifx 2 else 4"),
+			// the dead branch defines a variable, so it stays
+			std::make_tuple("if (false) { let y = 1; }", "iffalse let y = 1;"),
+	}));
+	CAPTURE(input);
+	CHECK(optimizedString(input) == expected);
+}
+
+TEST_CASE("Optimized programs behave like unoptimized ones", "[optimizer]") {
+	const char* input = GENERATE(
+			"let f = fn(x) { x * 2 * 3 }; f(7)",
+			"let f = fn(x) { x * 2 * 3 }; f(true)",
+			"let f = fn(x) { x + 1 + 2 }; f(fn() { 1 })",
+			"if (false) { 10 }",
+			"if (true) { }",
+			"if (10 > 1) { if (true) { return 10; } 1 } else { 2 }; 3",
+			"let f = fn() { if (true) { return 1 + 1; } 3 }; f()",
+			"let f = fn() { if (false) { let y = 1; } y }; f()",
+			"let y = 1; let f = fn() { if (false) { let y = 2; } y }; f()",
+			"!(5 > 3) == !false",
+			"-(-5) * true",
+			"let f = fn(x) { x + 1 + -1 }; f(9223372036854775807)",
+			"let f = fn(x) { x * 2 * 0 }; f(4611686018427387904)",
+			"let x = 9223372036854775807; (x + 1) + 1",
+			"let m = -9223372036854775807 - 1; m / -1",
+			"1 / 0");
+	const bool vm = GENERATE(false, true);
+	CAPTURE(input, vm);
+	CHECK(run(input, true, vm) == run(input, false, vm));
+}
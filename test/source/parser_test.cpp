@@ -13,6 +13,7 @@ extern "C" {
 #include <monkey/ast.h>
 #include <monkey/lexer.h>
 #include <monkey/parser.h>
+#include <monkey/stream.h>
 #include <monkey/string.h>
 }
 
@@ -26,7 +27,7 @@ void testIdentifierExpression(Expression* expression, const char* name) {
 	REQUIRE(expression->type == EXPRESSION_TYPE_IDENTIFIER);
 	auto* ident = reinterpret_cast<Identifier*>(expression);
 
-	REQUIRE(std::string(ident->value) == std::string(name));
+	REQUIRE(viewString(ident->value) == std::string(name));
 	const StringPtr toklit{IdentifierTokenLiteral(ident)};
 	REQUIRE(std::string(toklit.get()) == std::string(name));
 }
@@ -69,7 +70,7 @@ void testPrefixExpression(Expression* expression, const char* op, TestValue valu
 	REQUIRE(expression->type == EXPRESSION_TYPE_PREFIX);
 	auto* prefix = reinterpret_cast<PrefixExpression*>(expression);
 
-	REQUIRE(std::string(op) == prefix->op);
+	REQUIRE(std::string(op) == OperatorText(prefix->op));
 	const StringPtr toklit{PrefixExpressionTokenLiteral(prefix)};
 	REQUIRE(std::string(toklit.get()) == op);
 	testLiteralExpression(prefix->right, value);
@@ -80,7 +81,7 @@ void testInfixExpression(Expression* expression, TestValue left, const char* op,
 	REQUIRE(expression->type == EXPRESSION_TYPE_INFIX);
 	auto* infix = reinterpret_cast<InfixExpression*>(expression);
 
-	REQUIRE(std::string(op) == infix->op);
+	REQUIRE(std::string(op) == OperatorText(infix->op));
 	const StringPtr toklit{InfixExpressionTokenLiteral(infix)};
 	REQUIRE(std::string(toklit.get()) == op);
 	testLiteralExpression(infix->left, left);
@@ -92,7 +93,7 @@ void testLetStatement(Statement* statement, const char* name, TestValue value) {
 
 	REQUIRE(statement->type == STATEMENT_TYPE_LET);
 	auto* letStatement = reinterpret_cast<LetStatement*>(statement);
-	REQUIRE(std::string(letStatement->identifier->value) == std::string(name));
+	REQUIRE(viewString(letStatement->identifier->value) == std::string(name));
 
 	const StringPtr nameToklit{IdentifierTokenLiteral(letStatement->identifier)};
 	REQUIRE(std::string(nameToklit.get()) == std::string(name));
@@ -153,6 +154,74 @@ TEST_CASE("Let statement errors", "[parser]") {
 	REQUIRE(errors.length > 0);
 }
 
+TEST_CASE("Parser errors start with their line and column", "[parser]") {
+	const MonkeyPtr monkey{CreateMonkey()};
+	const LexerPtr lexer{
+			CreateLexer(monkey.get(), "let x = 1;\nlet y 2;\n\t99999999999999999999;")};
+	const ParserPtr parser{CreateParser(lexer.get())};
+	const ProgramPtr program{ParseProgram(parser.get())};
+
+	const MonkeyStringBuffer errors = ParserErrors(parser.get());
+	REQUIRE(errors.length == 2);
+	CHECK(std::string(errors.data[0]) == "2:7: expected next token to be =, got INT instead");
+	CHECK(std::string(errors.data[1]) ==
+			"3:2: could not parse \"99999999999999999999\" as integer");
+}
+
+TEST_CASE("The parser reports the first error of every broken statement", "[parser]") {
+	const MonkeyPtr monkey{CreateMonkey()};
+
+	const char* input;
+	std::vector<std::string> expected;
+	SECTION("top level") {
+		input = "let = 5;\nlet x = 1;\nlet y 2 3 4;\nreturn );\nlet z = x;";
+		expected = {
+				"1:5: expected next token to be IDENT, got = instead",
+				"3:7: expected next token to be =, got INT instead",
+				"4:8: no prefix parse function for ) found",
+		};
+	}
+	SECTION("inside blocks") {
+		input = "fn() { let = 1; if (x) { ) } let a = 2 }(;\nlet b 3;";
+		expected = {
+				"1:12: expected next token to be IDENT, got = instead",
+				"1:26: no prefix parse function for ) found",
+				"1:42: no prefix parse function for ; found",
+				"2:7: expected next token to be =, got INT instead",
+		};
+	}
+	CAPTURE(input);
+
+	const LexerPtr lexer{CreateLexer(monkey.get(), input)};
+	const ParserPtr parser{CreateParser(lexer.get())};
+	const ProgramPtr program{ParseProgram(parser.get())};
+
+	const MonkeyStringBuffer errors = ParserErrors(parser.get());
+	std::vector<std::string> actual;
+	for (std::size_t i = 0; i < errors.length; ++i) {
+		actual.emplace_back(errors.data[i]);
+	}
+	CHECK(actual == expected);
+}
+
+TEST_CASE("The parser stops after too many errors", "[parser]") {
+	const MonkeyPtr monkey{CreateMonkey()};
+	std::string input;
+	for (std::size_t i = 0; i < PARSER_ERROR_LIMIT * 2; ++i) {
+		input += "let = 1;\n";
+	}
+
+	const LexerPtr lexer{CreateLexer(monkey.get(), input.c_str())};
+	const ParserPtr parser{CreateParser(lexer.get())};
+	const ProgramPtr program{ParseProgram(parser.get())};
+
+	const MonkeyStringBuffer errors = ParserErrors(parser.get());
+	REQUIRE(errors.length == PARSER_ERROR_LIMIT + 1);
+	CHECK(std::string(errors.data[PARSER_ERROR_LIMIT - 1]) ==
+			"100:5: expected next token to be IDENT, got = instead");
+	CHECK(std::string(errors.data[PARSER_ERROR_LIMIT]) == "101:5: too many errors, stopping");
+}
+
 TEST_CASE("Return statements are parsed correctly", "[parser]") {
 	const MonkeyPtr monkey{CreateMonkey()};
 
@@ -485,3 +554,22 @@ TEST_CASE("Call expressions are parsed correctly", "[parser]") {
 	// NOLINTNEXTLINE(readability-magic-numbers)
 	testInfixExpression(lit->arguments.begin[2], TestInt{4}, "+", TestInt{5});
 }
+
+TEST_CASE("Programs parsed from a stream outlive the lexer", "[parser]") {
+	std::string input = "let seventeen = 17; fn(x, y) { x + seventeen * y }(1, 2) != 12345678";
+	const MonkeyPtr monkey{CreateMonkey()};
+	const StreamPtr stream{StreamFromText(&input[0], input.size())};
+
+	ProgramPtr program;
+	{
+		const LexerPtr lexer{CreateStreamLexer(monkey.get(), stream.get(), 1)};
+		const ParserPtr parser{CreateParser(lexer.get())};
+		program.reset(ParseProgram(parser.get()));
+		checkParserErrors(parser.get());
+	}
+	input.assign(input.size(), '#');
+
+	const StringPtr actual{ProgramString(program.get())};
+	CHECK(std::string(actual.get()) ==
+			"let seventeen = 17;(fn(x, y)(x + (seventeen * y))(1, 2) != 12345678)");
+}
@@ -1,6 +1,4 @@
-#include <array>
 #include <catch2/catch_test_macros.hpp>
-#include <cstddef>
 #include <string>
 
 extern "C" {
@@ -10,21 +8,52 @@ extern "C" {
 
 #include "monkey_wrapper.hpp"
 
-constexpr std::size_t OUTPUT_BUFFER_SIZE = 1024;
-
 TEST_CASE("REPL prints simple output", "[repl]") {
 	char inputText[] = "6;\n";
-	std::array<char, OUTPUT_BUFFER_SIZE> outputText;
 
 	const MonkeyReplArgs args = {
 			StreamFromText(inputText, sizeof(inputText) - 1),
-			StreamFromText(outputText.data(), outputText.size()),
+			StreamToMemory(),
+	};
+	const StreamPtr readerPtr{args.reader};
+	const StreamPtr writerPtr{args.writer};
+
+	MonkeyRepl(args);
+	const StringPtr output{TakeStreamText(args.writer, nullptr)};
+
+	REQUIRE(std::string(output.get()) == "> 6\n> \n");
+}
+
+TEST_CASE("REPL keeps functions usable on later lines", "[repl]") {
+	char inputText[] = "let add = fn(x, y) { x + y };\nadd(2, 3);\n";
+
+	const MonkeyReplArgs args = {
+			StreamFromText(inputText, sizeof(inputText) - 1),
+			StreamToMemory(),
+	};
+	const StreamPtr readerPtr{args.reader};
+	const StreamPtr writerPtr{args.writer};
+
+	MonkeyRepl(args);
+	const StringPtr output{TakeStreamText(args.writer, nullptr)};
+
+	REQUIRE(std::string(output.get()) == "> null\n> 5\n> \n");
+}
+
+TEST_CASE("REPL runs lines on the virtual machine", "[repl]") {
+	char inputText[] = "let add = fn(x, y) { x + y };\nadd(2, 3);\nadd(missing, 1);\n";
+
+	const MonkeyReplArgs args = {
+			StreamFromText(inputText, sizeof(inputText) - 1),
+			StreamToMemory(),
+			MONKEY_ENGINE_VM,
 	};
 	const StreamPtr readerPtr{args.reader};
 	const StreamPtr writerPtr{args.writer};
 
 	MonkeyRepl(args);
-	args.writer->text[args.writer->textPosition] = '\0';
+	const StringPtr output{TakeStreamText(args.writer, nullptr)};
 
-	REQUIRE(std::string(outputText.data()) == "> 6\n> \n");
+	REQUIRE(std::string(output.get()) ==
+			"> null\n> 5\n> \tidentifier not found: missing\n> \n");
 }
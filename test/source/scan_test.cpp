@@ -0,0 +1,53 @@
+#include <catch2/catch_message.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+#include <cstddef>
+#include <vector>
+
+extern "C" {
+#include <monkey/scan.h>
+}
+
+TEST_CASE("Scanners agree with the scalar scanner", "[scan]") {
+	const Scanner* scanner = GetScanner();
+	const Scanner* scalar = GetScalarScanner();
+	CAPTURE(scanner->name);
+
+	char fill = ' ';
+	char stop = 'a';
+	ScanFn scan = nullptr;
+	ScanFn expected = nullptr;
+	SECTION("whitespace") {
+		fill = GENERATE(' ', '\t', '\n', '\r');
+		stop = GENERATE('a', '\0', '\x0b', '\x80', '\xff');
+		scan = scanner->whitespace;
+		expected = scalar->whitespace;
+	}
+	SECTION("letters") {
+		fill = GENERATE('a', 'z', 'A', 'Z', '_');
+		stop = GENERATE('0', ' ', '@', '[', '`', '{', '\0', '\xc1', '\xfa');
+		scan = scanner->letters;
+		expected = scalar->letters;
+	}
+	SECTION("digits") {
+		fill = GENERATE('0', '9');
+		stop = GENERATE('/', ':', 'a', '\0', '\xb0', '\xb9');
+		scan = scanner->digits;
+		expected = scalar->digits;
+	}
+	CAPTURE(static_cast<int>(fill), static_cast<int>(stop));
+
+	constexpr std::size_t MAX_LENGTH = 70;
+	for (std::size_t length = 0; length <= MAX_LENGTH; ++length) {
+		for (std::size_t stopAt = 0; stopAt <= length; ++stopAt) {
+			// sized exactly, so that reading past the end trips the address sanitizer
+			std::vector<char> text(length, fill);
+			if (stopAt < length) {
+				text[stopAt] = stop;
+			}
+			CAPTURE(length, stopAt);
+			REQUIRE(scan(text.data(), length) == stopAt);
+			REQUIRE(expected(text.data(), length) == stopAt);
+		}
+	}
+}
@@ -0,0 +1,160 @@
+#include <array>
+#include <catch2/catch_message.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <tuple>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+extern "C" {
+#include <monkey/engine.h>
+#include <monkey/script.h>
+#include <monkey/stream.h>
+}
+
+#include "monkey_wrapper.hpp"
+
+namespace {
+constexpr char SCRIPT_PATH[] = "script_test.mk";
+
+struct ScriptResult {
+	bool ok;
+	std::string output;
+	std::string errors;
+};
+
+ScriptResult runScript(const char* path, MonkeyEngine engine) {
+	const StreamPtr writer{StreamToMemory()};
+	const StreamPtr errors{StreamToMemory()};
+
+	const bool ok = MONKEY_RUN_SCRIPT(
+			.path = path, .writer = writer.get(), .errors = errors.get(), .engine = engine);
+	const StringPtr output{TakeStreamText(writer.get(), nullptr)};
+	const StringPtr errorOutput{TakeStreamText(errors.get(), nullptr)};
+	return {ok, output.get(), errorOutput.get()};
+}
+
+ScriptResult runSource(const char* source, MonkeyEngine engine) {
+	{
+		std::ofstream file{SCRIPT_PATH, std::ios::binary};
+		file << source;
+	}
+	ScriptResult result = runScript(SCRIPT_PATH, engine);
+	(void)std::remove(SCRIPT_PATH);
+	return result;
+}
+} // namespace
+
+TEST_CASE("Scripts run as one program", "[script]") {
+	const MonkeyEngine engine = GENERATE(MONKEY_ENGINE_EVALUATOR, MONKEY_ENGINE_VM);
+	CAPTURE(engine);
+
+	SECTION("the value of the program is printed") {
+		const ScriptResult result = runSource(R"mk(
+let fib = fn(x) {
+	if (x < 2) { return x; }
+	fib(x - 1) + fib(x - 2)
+};
+fib(10);
+)mk",
+				engine);
+		CHECK(result.ok);
+		CHECK(result.output == "55\n");
+		CHECK(result.errors.empty());
+	}
+
+	SECTION("a repeated parameter refers to the last argument") {
+		const ScriptResult result = runSource("let f = fn(x, x) { x }; f(1, 2)", engine);
+		CHECK(result.ok);
+		CHECK(result.output == "2\n");
+	}
+
+	SECTION("a null value is not printed") {
+		const ScriptResult result = runSource("let x = 1;", engine);
+		CHECK(result.ok);
+		CHECK(result.output.empty());
+	}
+
+	SECTION("an empty file is a valid program") {
+		const ScriptResult result = runSource("", engine);
+		CHECK(result.ok);
+		CHECK(result.output.empty());
+	}
+
+	SECTION("parse errors fail the script") {
+		const ScriptResult result = runSource("let = 5;", engine);
+		CHECK_FALSE(result.ok);
+		CHECK(result.output.empty());
+		CHECK(result.errors ==
+				"script_test.mk:1:5: expected next token to be IDENT, got = instead\n");
+	}
+
+	SECTION("runtime errors fail the script") {
+		const ScriptResult result = runSource("let x = 1;\nx + true;", engine);
+		CHECK_FALSE(result.ok);
+		CHECK(result.output.empty());
+		if (engine == MONKEY_ENGINE_EVALUATOR) {
+			CHECK(result.errors == "script_test.mk:2:3: type mismatch: INTEGER + BOOLEAN\n");
+		} else {
+			CHECK(result.errors == "script_test.mk: type mismatch: INTEGER + BOOLEAN\n");
+		}
+	}
+}
+
+TEST_CASE("Missing scripts are reported", "[script]") {
+	const ScriptResult result = runScript("does_not_exist.mk", MONKEY_ENGINE_EVALUATOR);
+	CHECK_FALSE(result.ok);
+	CHECK(result.errors.rfind("does_not_exist.mk: ", 0) == 0);
+}
+
+#ifndef _WIN32
+TEST_CASE("Directories are reported", "[script]") {
+	const ScriptResult result = runScript(".", MONKEY_ENGINE_EVALUATOR);
+	CHECK_FALSE(result.ok);
+	CHECK(result.errors == std::string(".: ") + std::strerror(EISDIR) + "\n");
+}
+
+TEST_CASE("Scripts that cannot be mapped are streamed", "[script]") {
+	const char* source;
+	bool expectedOk;
+	const char* expectedOutput;
+	std::tie(source, expectedOk, expectedOutput) = GENERATE(table<const char*, bool, const char*>({
+			std::make_tuple("let x = 6;\nx * 7", true, "42\n"),
+			std::make_tuple("1 + ;\n", false, ""),
+	}));
+	CAPTURE(source);
+	std::array<int, 2> fds{};
+	REQUIRE(pipe(fds.data()) == 0);
+	const auto length = static_cast<ssize_t>(std::strlen(source));
+	REQUIRE(write(fds[1], source, static_cast<std::size_t>(length)) == length);
+	(void)close(fds[1]);
+
+	const std::string path = "/dev/fd/" + std::to_string(fds[0]);
+	const ScriptResult result = runScript(path.c_str(), MONKEY_ENGINE_EVALUATOR);
+	(void)close(fds[0]);
+	CHECK(result.ok == expectedOk);
+	CHECK(result.output == expectedOutput);
+	CHECK(result.errors.empty() == expectedOk);
+}
+#endif
+
+TEST_CASE("Scripts are read from the reader when the path is -", "[script]") {
+	std::string source = "let fib = fn(x) { if (x < 2) { return x; } fib(x - 1) + fib(x - 2) };\n"
+						 "fib(15)";
+	const StreamPtr reader{StreamFromText(&source[0], source.size())};
+	const StreamPtr writer{StreamToMemory()};
+	const StreamPtr errors{StreamFromText(nullptr, 0)};
+
+	const bool ok = MONKEY_RUN_SCRIPT(
+			.path = "-", .reader = reader.get(), .writer = writer.get(), .errors = errors.get());
+	CHECK(ok);
+	const StringPtr output{TakeStreamText(writer.get(), nullptr)};
+	CHECK(std::string(output.get()) == "610\n");
+}
@@ -1,7 +1,14 @@
+#include <array>
 #include <catch2/catch_test_macros.hpp>
+#include <cerrno>
+#include <csignal>
 #include <cstdio>
 #include <memory>
 #include <string>
+#ifndef _WIN32
+#include <sys/time.h>
+#include <unistd.h>
+#endif
 
 extern "C" {
 #include <monkey/stream.h>
@@ -66,3 +73,183 @@ TEST_CASE("Stream behaves nicely when backed by a string", "[stream]") {
 
 	REQUIRE(std::string{buffer} == std::string{INPUT});
 }
+
+TEST_CASE("Stream buffers reads and writes of files", "[stream]") {
+	FILE* tempFile;
+#ifdef _WIN32
+	REQUIRE(tmpfile_s(&tempFile) == 0);
+#else
+	tempFile = std::tmpfile();
+#endif
+	// small enough for lines to span several reads, and for long writes to go around the buffer
+	const StreamPtr streamPtr{StreamFromFileWithBuffer(tempFile, 8)};
+	Stream* stream = streamPtr.get();
+
+	const std::string longLine(100, 'x');
+	WriteStream(stream, "short\n", 6);
+	CHECK(std::ftell(tempFile) == 0);
+	StreamPrintf(stream, "%s\n", longLine.c_str());
+	StreamPrintf(stream, "%d%d\n", 4, 2);
+	WriteStream(stream, "last", 4);
+	REQUIRE(FlushStream(stream));
+	CHECK(std::ftell(tempFile) == static_cast<long>(6 + longLine.size() + 1 + 3 + 4));
+
+	RewindStream(stream);
+	char* line = nullptr;
+	size_t lineSize = 0;
+	std::string lines;
+	while (ReadStreamLine(&line, &lineSize, stream) != -1) {
+		lines += std::string{line} + "|";
+	}
+	const StringPtr linePtr{line};
+	CHECK(lines == "short|" + longLine + "|42|last|");
+
+	RewindStream(stream);
+	std::string text;
+	char buffer[16];
+	int64_t read;
+	while ((read = ReadStream(stream, buffer, sizeof buffer)) > 0) {
+		text.append(buffer, static_cast<size_t>(read));
+	}
+	CHECK(read == -1);
+	CHECK(text == "short\n" + longLine + "\n42\nlast");
+}
+
+TEST_CASE("Tied streams are flushed before waiting for input", "[stream]") {
+	FILE* inputFile;
+	FILE* outputFile;
+#ifdef _WIN32
+	REQUIRE(tmpfile_s(&inputFile) == 0);
+	REQUIRE(tmpfile_s(&outputFile) == 0);
+#else
+	inputFile = std::tmpfile();
+	outputFile = std::tmpfile();
+#endif
+	REQUIRE(std::fputs("1\n2\n", inputFile) >= 0);
+	std::rewind(inputFile);
+	const StreamPtr input{StreamFromFile(inputFile)};
+	const StreamPtr output{StreamFromFile(outputFile)};
+	TieStream(input.get(), output.get());
+
+	char* line = nullptr;
+	size_t lineSize = 0;
+	WriteStream(output.get(), "> ", 2);
+	REQUIRE(ReadStreamLine(&line, &lineSize, input.get()) == 1);
+	CHECK(std::ftell(outputFile) == 2);
+	// the second line was read along with the first, so there is no waiting for it
+	WriteStream(output.get(), "> ", 2);
+	REQUIRE(ReadStreamLine(&line, &lineSize, input.get()) == 1);
+	CHECK(std::ftell(outputFile) == 2);
+	const StringPtr linePtr{line};
+}
+
+#ifndef _WIN32
+TEST_CASE("Failed reads are told apart from the end of the file", "[stream]") {
+	std::array<int, 2> fds{};
+	REQUIRE(pipe(fds.data()) == 0);
+	const StreamPtr readEnd{StreamFromFile(fdopen(fds[0], "r"))};
+	{
+		const StreamPtr writeEnd{StreamFromFile(fdopen(fds[1], "w"))};
+		REQUIRE(WriteStream(writeEnd.get(), "line", 4) == 4);
+		REQUIRE(FlushStream(writeEnd.get()));
+
+		char buffer[16];
+		CHECK(ReadStream(writeEnd.get(), buffer, sizeof buffer) == -1);
+		CHECK(StreamError(writeEnd.get()) == EBADF);
+	}
+
+	char* line = nullptr;
+	size_t lineSize = 0;
+	CHECK(ReadStreamLine(&line, &lineSize, readEnd.get()) == 4);
+	CHECK(ReadStreamLine(&line, &lineSize, readEnd.get()) == -1);
+	const StringPtr linePtr{line};
+	CHECK(StreamError(readEnd.get()) == 0);
+}
+
+namespace {
+int signalledFd = -1;
+
+void writeLine(int /*signal*/) {
+	(void)write(signalledFd, "42\n", 3);
+}
+} // namespace
+
+TEST_CASE("Reads interrupted by a signal are retried", "[stream]") {
+	std::array<int, 2> fds{};
+	REQUIRE(pipe(fds.data()) == 0);
+	signalledFd = fds[1];
+	// no SA_RESTART, so the signal interrupts the read waiting for the line
+	struct sigaction action = {};
+	action.sa_handler = writeLine;
+	struct sigaction previous = {};
+	REQUIRE(sigaction(SIGALRM, &action, &previous) == 0);
+	itimerval timer = {};
+	timer.it_value.tv_usec = 20000;
+	REQUIRE(setitimer(ITIMER_REAL, &timer, nullptr) == 0);
+
+	const StreamPtr stream{StreamFromFile(fdopen(fds[0], "r"))};
+	char* line = nullptr;
+	size_t lineSize = 0;
+	const int64_t length = ReadStreamLine(&line, &lineSize, stream.get());
+	const StringPtr linePtr{line};
+	(void)sigaction(SIGALRM, &previous, nullptr);
+	(void)close(fds[1]);
+	CHECK(length == 2);
+	CHECK(std::string{line} == "42");
+	CHECK(StreamError(stream.get()) == 0);
+}
+#endif
+
+TEST_CASE("Memory streams keep everything written to them", "[stream]") {
+	const StreamPtr streamPtr{StreamToMemory()};
+	Stream* stream = streamPtr.get();
+
+	const std::string longLine(5000, 'x');
+	CHECK(WriteStream(stream, "short\n", 6) == 6);
+	CHECK(StreamPrintf(stream, "%s\n", longLine.c_str()) ==
+			static_cast<int64_t>(longLine.size() + 1));
+	CHECK(StreamPrintf(stream, "%d%d", 4, 2) == 2);
+
+	RewindStream(stream);
+	char* line = nullptr;
+	size_t lineSize = 0;
+	std::string lines;
+	while (ReadStreamLine(&line, &lineSize, stream) != -1) {
+		lines += std::string{line} + "|";
+	}
+	const StringPtr linePtr{line};
+	CHECK(lines == "short|" + longLine + "|42|");
+
+	// writing after a rewind overwrites without losing what follows
+	RewindStream(stream);
+	WriteStream(stream, "SHORT", 5);
+	size_t length = 0;
+	const StringPtr text{TakeStreamText(stream, &length)};
+	CHECK(length == 6 + longLine.size() + 1 + 2);
+	CHECK(std::string{text.get()} == "SHORT\n" + longLine + "\n42");
+
+	const StringPtr empty{TakeStreamText(stream, &length)};
+	CHECK(length == 0);
+	CHECK(std::string{empty.get()}.empty());
+}
+
+TEST_CASE("Formatting into a string stops at its end like writing does", "[stream]") {
+	char text[8];
+	const StreamPtr streamPtr{StreamFromText(text, sizeof text)};
+	Stream* stream = streamPtr.get();
+
+	CHECK(StreamPrintf(stream, "%s", "Hello, World!") == 8);
+	CHECK(stream->textPosition == 8);
+	CHECK(std::string(text, sizeof text) == "Hello, W");
+	CHECK(StreamPrintf(stream, "%d", 42) == -1);
+	CHECK(WriteStream(stream, "42", 2) == -1);
+	CHECK(StreamPrintf(stream, "%s", "") == 0);
+	CHECK(WriteStream(stream, "", 0) == 0);
+	CHECK(stream->textPosition == 8);
+	CHECK(TakeStreamText(stream, nullptr) == nullptr);
+
+	// like a write, formatted text leaves whatever follows it alone
+	RewindStream(stream);
+	CHECK(StreamPrintf(stream, "%d", 12) == 2);
+	CHECK(std::string(text, sizeof text) == "12llo, W");
+}
@@ -13,3 +13,20 @@ TEST_CASE("Allocated string printf works", "[string]") {
 	const StringPtr result{MonkeyAsprintf("%s %d", "Hello", MAGIC)};
 	REQUIRE(std::string{result.get()} == std::string{"Hello 42"});
 }
+
+TEST_CASE("String builders append in place", "[string]") {
+	MonkeyStringBuilder builder = BUFFER_INIT;
+	const StringPtr empty{MonkeyStringBuilderFinish(&builder)};
+	CHECK(std::string{empty.get()}.empty());
+
+	const std::string longText(1000, 'x');
+	MonkeyStringBuilderAppend(&builder, "let ");
+	MonkeyStringBuilderAppendView(&builder, MonkeyStringViewFrom("answer = 42"));
+	MonkeyStringBuilderAppendFormat(&builder, "; %d%s", MAGIC, longText.c_str());
+	const char* tail = "; ignored";
+	MonkeyStringBuilderAppendView(&builder, MonkeyStringView{tail, tail + 1, 1});
+	const StringPtr result{MonkeyStringBuilderFinish(&builder)};
+	CHECK(std::string{result.get()} == "let answer = 42; 42" + longText + ";");
+	CHECK(builder.data == nullptr);
+	CHECK(builder.length == 0);
+}
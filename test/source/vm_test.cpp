@@ -0,0 +1,175 @@
+#include <catch2/catch_message.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+#include <cstdint>
+#include <nonstd/variant.hpp>
+#include <string>
+#include <tuple>
+
+extern "C" {
+#include <monkey.h>
+#include <monkey/compiler.h>
+#include <monkey/lexer.h>
+#include <monkey/object.h>
+#include <monkey/parser.h>
+#include <monkey/vm.h>
+}
+
+#include "monkey_wrapper.hpp"
+
+namespace {
+void testObject(const Object* object, TestValue expected) {
+	REQUIRE(object != nullptr);
+	if (auto* pInt = nonstd::get_if<TestInt>(&expected)) {
+		REQUIRE(ObjectTypeOf(object) == OBJECT_TYPE_INTEGER);
+		REQUIRE(ObjectToInteger(object) == pInt->value);
+	} else if (auto* pBool = nonstd::get_if<TestBool>(&expected)) {
+		REQUIRE(ObjectTypeOf(object) == OBJECT_TYPE_BOOLEAN);
+		REQUIRE(ObjectToBoolean(object) == pBool->value);
+	} else if (nonstd::get_if<TestNull>(&expected) != nullptr) {
+		REQUIRE(ObjectTypeOf(object) == OBJECT_TYPE_NULL);
+	} else {
+		FAIL("corrupt value");
+	}
+}
+
+Object* testRun(Monkey* monkey, const char* input) {
+	const LexerPtr lexer{CreateLexer(monkey, input)};
+	const ParserPtr parser{CreateParser(lexer.get())};
+	const ProgramPtr program{ParseProgram(parser.get())};
+	const CompilerPtr compiler{CreateCompiler(monkey)};
+	REQUIRE(Compile(compiler.get(), program.get()));
+	const VMPtr vm{CreateVM(monkey)};
+
+	return Run(vm.get(), CompilerBytecode(compiler.get()));
+}
+} // namespace
+
+TEST_CASE("VM expressions", "[vm]") {
+	const MonkeyPtr monkey{CreateMonkey()};
+	const char* input;
+	TestValue expected;
+	std::tie(input, expected) = GENERATE(table<const char*, TestValue>({
+			std::make_tuple("(5 + 10 * 2 + 15 / 3) * 2 + -10", TestInt{50}),
+			std::make_tuple("20 + 2 * -10", TestInt{0}),
+			std::make_tuple("(1 < 2) == true", TestBool{true}),
+			std::make_tuple("1 != 2", TestBool{true}),
+			std::make_tuple("!!5", TestBool{true}),
+			std::make_tuple("!(if (false) { 5; })", TestBool{true}),
+			std::make_tuple("if (1 > 2) { 10 }", TestNull{}),
+			std::make_tuple("if (1 > 2) { 10 } else { 20 }", TestInt{20}),
+			std::make_tuple("if ((if (false) { 10 })) { 10 } else { 20 }", TestInt{20}),
+			std::make_tuple("let a = 5; let b = a; let c = a + b + 5; c;", TestInt{15}),
+			std::make_tuple("9; return 2 * 5; 9;", TestInt{10}),
+			// integers at the edge of the immediate range, and past it
+			std::make_tuple("4611686018427387903 + 1", TestInt{4611686018427387904}),
+			std::make_tuple("-4611686018427387904 - 1", TestInt{-4611686018427387905}),
+			std::make_tuple("-3 < -2", TestBool{true}),
+			std::make_tuple("4611686018427387904 > 4611686018427387903", TestBool{true}),
+			std::make_tuple("4611686018427387904 == 4611686018427387903 + 1", TestBool{true}),
+	}));
+
+	CAPTURE(input, expected);
+	Object* result = testRun(monkey.get(), input);
+	testObject(result, expected);
+}
+
+TEST_CASE("VM function calls", "[vm]") {
+	const MonkeyPtr monkey{CreateMonkey()};
+	const char* input;
+	TestValue expected;
+	std::tie(input, expected) = GENERATE(table<const char*, TestValue>({
+			std::make_tuple("let identity = fn(x) { return x; }; identity(5);", TestInt{5}),
+			std::make_tuple("let add = fn(x, y) { x + y; }; add(5 + 5, add(5, 5));", TestInt{20}),
+			std::make_tuple("fn(x) { x; }(5)", TestInt{5}),
+			std::make_tuple("fn() { }()", TestNull{}),
+			std::make_tuple("let f = fn(x, x) { x }; f(1, 2)", TestInt{2}),
+			std::make_tuple("let f = fn(x, y, x) { let x = x + y; x }; f(1, 2, 3)", TestInt{5}),
+			std::make_tuple("fn(a, a) { fn() { a } }(1, 2)()", TestInt{2}),
+			std::make_tuple("let f = fn() { let a = 1; let b = 2; a + b }; f() + f();", TestInt{6}),
+			std::make_tuple(
+					"let adder = fn(a) { fn(b) { a + b } }; let addTwo = adder(2); addTwo(3);",
+					TestInt{5}),
+			std::make_tuple("let f = fn(a) { fn(b) { fn(c) { a + b + c } } }; f(1)(2)(3);",
+					TestInt{6}),
+			std::make_tuple(R"mk(
+let fib = fn(x) {
+	if (x < 2) { return x; }
+	fib(x - 1) + fib(x - 2)
+};
+fib(15);
+			)mk",
+					TestInt{610}),
+			std::make_tuple(R"mk(
+let wrapper = fn() {
+	let countDown = fn(x) { if (x == 0) { return 0; } countDown(x - 1) };
+	countDown(100)
+};
+wrapper();
+			)mk",
+					TestInt{0}),
+	}));
+
+	CAPTURE(input, expected);
+	Object* result = testRun(monkey.get(), input);
+	testObject(result, expected);
+}
+
+TEST_CASE("VM runtime errors", "[vm]") {
+	const MonkeyPtr monkey{CreateMonkey()};
+	const char* input;
+	const char* expectedMessage;
+	std::tie(input, expectedMessage) = GENERATE(table<const char*, const char*>({
+			std::make_tuple("5 + true; 5;", "type mismatch: INTEGER + BOOLEAN"),
+			std::make_tuple("-true", "unknown operator: -BOOLEAN"),
+			std::make_tuple("if (10 > 1) { true + false; }", "unknown operator: BOOLEAN + BOOLEAN"),
+			std::make_tuple("1(2)", "not a function: INTEGER"),
+			std::make_tuple("fn(a) { a }()", "wrong number of arguments: want=1, got=0"),
+			std::make_tuple("let f = fn(x) { f(x + 1) }; f(0);", "stack overflow"),
+			std::make_tuple("1 / 0", "division by zero"),
+			std::make_tuple("let m = -9223372036854775807 - 1; m / -1",
+					"integer overflow: -9223372036854775808 / -1"),
+			std::make_tuple("9223372036854775807 + 1", "integer overflow: 9223372036854775807 + 1"),
+			std::make_tuple(
+					"-9223372036854775807 - 2", "integer overflow: -9223372036854775807 - 2"),
+			std::make_tuple("4611686018427387904 * 2", "integer overflow: 4611686018427387904 * 2"),
+			std::make_tuple(
+					"-(-9223372036854775807 - 1)", "integer overflow: --9223372036854775808"),
+	}));
+
+	CAPTURE(input, expectedMessage);
+	Object* result = testRun(monkey.get(), input);
+	REQUIRE(result != nullptr);
+	REQUIRE(ObjectTypeOf(result) == OBJECT_TYPE_ERROR);
+	REQUIRE(reinterpret_cast<ErrorObject*>(result)->message == std::string(expectedMessage));
+}
+
+TEST_CASE("VM call depth follows the library instance", "[vm]") {
+	const MonkeyPtr monkey{CreateMonkey()};
+	MonkeySetMaxCallDepth(monkey.get(), 100);
+	const std::string countdown = "let f = fn(n) { if (n == 0) { 0 } else { 1 + f(n - 1) } }; ";
+
+	testObject(testRun(monkey.get(), (countdown + "f(99)").c_str()), TestInt{99});
+	Object* result = testRun(monkey.get(), (countdown + "f(100)").c_str());
+	REQUIRE(result != nullptr);
+	REQUIRE(ObjectTypeOf(result) == OBJECT_TYPE_ERROR);
+	CHECK(reinterpret_cast<ErrorObject*>(result)->message == std::string("stack overflow"));
+}
+
+TEST_CASE("VM globals persist across runs", "[vm]") {
+	const MonkeyPtr monkey{CreateMonkey()};
+	const CompilerPtr compiler{CreateCompiler(monkey.get())};
+	const VMPtr vm{CreateVM(monkey.get())};
+	const char* inputs[] = {"let x = 40;", "let inc = fn(n) { n + 1 };", "inc(inc(x))"};
+	Object* result = nullptr;
+
+	for (const char* input : inputs) {
+		const LexerPtr lexer{CreateLexer(monkey.get(), input)};
+		const ParserPtr parser{CreateParser(lexer.get())};
+		const ProgramPtr program{ParseProgram(parser.get())};
+		REQUIRE(Compile(compiler.get(), program.get()));
+		result = Run(vm.get(), CompilerBytecode(compiler.get()));
+	}
+
+	testObject(result, TestInt{42});
+}